@@ -0,0 +1,321 @@
+#!/usr/bin/perl
+
+use strict;
+use warnings;
+use Getopt::Long qw(:config no_ignore_case);
+use Time::HiRes qw(time);
+use Cwd qw(abs_path);
+use lib ".";
+use Ci;
+
+my ($workdir,$baseline,$save,$timeTol,$memTol,$minSeconds,$names,$help);
+GetOptions(
+'w=s' => \$workdir,
+'b=s' => \$baseline,
+'save' => \$save,
+'timetol=f' => \$timeTol,
+'memtol=f' => \$memTol,
+'min=f' => \$minSeconds,
+'c=s' => \$names,
+'h' => \$help) or die "$0: Error in command line args, run with -h to display help\n";
+
+if (defined($help)) {
+	print "USAGE: $0 [options]\n";
+	print "\tRuns the cases in inputs/benchmarks.txt, which are TestSuite inputs\n";
+	print "\twith a given m, number of threads and matrix vector product, and\n";
+	print "\tcompares wall time, time per phase and peak memory against a baseline.\n";
+	print "\tInputs are run with twositedmrg, without SU(2), and with Profiler=json.\n";
+	print "\tIf no option is given runs all cases\n";
+	print "\t-c name1,name2,...\n";
+	print "\t\tRun only these cases\n";
+	print Ci::helpFor("-w");
+	print "\t-b baseline\n";
+	print "\t\tUse baseline as baseline file instead of the default of benchmarkBaseline.txt\n";
+	print "\t-save\n";
+	print "\t\tSave the results as the new baseline and do not compare\n";
+	print "\t-timetol tolerance\n";
+	print "\t\tRelative tolerance for times, default 0.15\n";
+	print "\t-memtol tolerance\n";
+	print "\t\tRelative tolerance for peak memory, default 0.10\n";
+	print "\t-min seconds\n";
+	print "\t\tDo not compare times below seconds in the baseline, default 1\n";
+	print Ci::helpFor("-h");
+	exit(0);
+}
+
+defined($workdir) or $workdir = "benchmarks";
+defined($baseline) or $baseline = "benchmarkBaseline.txt";
+defined($save) or $save = 0;
+defined($timeTol) or $timeTol = 0.15;
+defined($memTol) or $memTol = 0.10;
+defined($minSeconds) or $minSeconds = 1;
+
+my @cases = readCases("inputs/benchmarks.txt", $names);
+die "$0: No cases to run\n" if (scalar(@cases) == 0);
+
+my %baseValues;
+if (!$save) {
+	if (-r "$baseline") {
+		readResults(\%baseValues, $baseline);
+	} else {
+		print STDERR "$0: WARNING: No $baseline found, nothing to compare against\n";
+	}
+}
+
+$baseline = abs_path(".")."/$baseline" unless ($baseline =~ /^\//);
+
+prepareDir();
+
+my @results;
+foreach my $c (@cases) {
+	push @results, runCase($c);
+}
+
+writeResults(\@results, "benchmarkResults.txt");
+if ($save) {
+	writeResults(\@results, $baseline);
+	print STDERR "$0: Baseline saved to $baseline\n";
+	exit(0);
+}
+
+my $regressions = report(\@results, \%baseValues);
+exit(($regressions > 0) ? 1 : 0);
+
+sub readCases
+{
+	my ($file, $names) = @_;
+	my %wanted;
+	if (defined($names)) {
+		my @temp = split(/,/, $names);
+		foreach my $name (@temp) {
+			$wanted{"$name"} = 1;
+		}
+	}
+
+	my @cases;
+	open(FILE, "<", "$file") or die "$0: Cannot open $file : $!\n";
+	while (<FILE>) {
+		next if (/^\#/ or /^[ \t]*$/);
+		chomp;
+		my @temp = split;
+		(scalar(@temp) == 5) or die "$0: Wrong line in $file: $_\n";
+		my %h = (name => $temp[0],
+		         input => $temp[1],
+		         m => $temp[2],
+		         threads => $temp[3],
+		         matrixVector => $temp[4]);
+		next if (defined($names) and !exists($wanted{$temp[0]}));
+		push @cases, \%h;
+	}
+
+	close(FILE);
+	return @cases;
+}
+
+sub runCase
+{
+	my ($c) = @_;
+	my $name = $c->{"name"};
+	my $input = createInput($c);
+	my %r = (name => $name, seconds => -1, rssKb => -1, phases => {});
+
+	my $t0 = time();
+	my $ret = system("./dmrg -f $input > output_$name.txt 2>&1");
+	my $seconds = time() - $t0;
+	if ($ret != 0) {
+		print STDERR "$0: $name FAILED, see output_$name.txt\n";
+		return \%r;
+	}
+
+	$r{"seconds"} = $seconds;
+	procProfile(\%r, "Profilebench_$name.txt.json");
+	printf STDERR "$0: $name done in %.3f seconds\n", $seconds;
+	return \%r;
+}
+
+sub createInput
+{
+	my ($c) = @_;
+	my $n = $c->{"input"};
+	my $name = $c->{"name"};
+	my $m = $c->{"m"};
+	my $matrixVector = $c->{"matrixVector"};
+	my $options = "twositedmrg";
+	if ($matrixVector eq "Stored") {
+		$options .= ",MatrixVectorStored";
+	} elsif ($matrixVector eq "Kron") {
+		$options .= ",MatrixVectorKron";
+	} elsif ($matrixVector ne "OnTheFly") {
+		die "$0: $name: MatrixVector must be OnTheFly, Stored or Kron\n";
+	}
+
+	my $file = "../inputs/input$n.inp";
+	my $fout = "bench_$name.inp";
+	open(FILE, "<", "$file") or die "$0: Cannot open $file : $!\n";
+	open(FOUT, ">", "$fout") or die "$0: Cannot write to $fout : $!\n";
+	my $hasThreads = 0;
+	while (<FILE>) {
+		if (/^SolverOptions=/) {
+			$_ = "SolverOptions=$options\n";
+		} elsif (/^OutputFile=/) {
+			$_ = "OutputFile=bench_$name.txt\n";
+		} elsif (/^InfiniteLoopKeptStates=/) {
+			$_ = "InfiniteLoopKeptStates=$m\n";
+		} elsif (/^FiniteLoops[ \t]+(.*$)/) {
+			$_ = finiteLoops($1, $m, $name);
+		} elsif (/^UseSu2Symmetry=/) {
+			$_ = "UseSu2Symmetry=0\n";
+		} elsif (/^Threads=/) {
+			$_ = "Threads=".$c->{"threads"}."\n";
+			$hasThreads = 1;
+		} elsif (/^Profiler=/ or /^MemoryBudget=/) {
+			next;
+		}
+
+		print FOUT;
+	}
+
+	close(FILE);
+	print FOUT "Threads=".$c->{"threads"}."\n" unless ($hasThreads);
+	print FOUT "Profiler=json\n";
+	close(FOUT);
+	return $fout;
+}
+
+sub finiteLoops
+{
+	my ($line, $m, $name) = @_;
+	my @temp = split(/[ \t]+/, $line);
+	my $n = shift @temp;
+	(scalar(@temp) == 3*$n) or die "$0: $name: FiniteLoops must be in one line\n";
+	for (my $i = 0; $i < $n; ++$i) {
+		$temp[3*$i + 1] = $m;
+	}
+
+	return "FiniteLoops $n ".join(" ", @temp)."\n";
+}
+
+sub procProfile
+{
+	my ($r, $file) = @_;
+	open(FILE, "<", "$file") or die "$0: Cannot open $file : $!\n";
+	while (<FILE>) {
+		next unless (/^\{"kind":"run"/);
+		$r->{"rssKb"} = $1 if (/"maxRssKb":(\d+),"phases"/);
+		while (/"([^"]+)":\{"seconds":([^,]+),"calls":/g) {
+			$r->{"phases"}->{"$1"} = $2;
+		}
+	}
+
+	close(FILE);
+}
+
+sub writeResults
+{
+	my ($results, $file) = @_;
+	open(FOUT, ">", "$file") or die "$0: Cannot write to $file : $!\n";
+	print FOUT "#Name Seconds MaxRssKb Phase=Seconds ...\n";
+	foreach my $r (@$results) {
+		next if ($r->{"seconds"} < 0);
+		print FOUT $r->{"name"}." ".$r->{"seconds"}." ".$r->{"rssKb"};
+		my $phases = $r->{"phases"};
+		foreach my $phase (sort keys %$phases) {
+			print FOUT " $phase=".$phases->{$phase};
+		}
+
+		print FOUT "\n";
+	}
+
+	close(FOUT);
+}
+
+sub readResults
+{
+	my ($values, $file) = @_;
+	open(FILE, "<", "$file") or die "$0: Cannot open $file : $!\n";
+	while (<FILE>) {
+		next if (/^\#/);
+		chomp;
+		my @temp = split;
+		next if (scalar(@temp) < 3);
+		my $name = shift @temp;
+		my %r = (name => $name, seconds => shift @temp, rssKb => shift @temp);
+		my %phases;
+		foreach my $item (@temp) {
+			my ($phase, $seconds) = split(/=/, $item);
+			$phases{"$phase"} = $seconds;
+		}
+
+		$r{"phases"} = \%phases;
+		$values->{"$name"} = \%r;
+	}
+
+	close(FILE);
+}
+
+# Returns SLOWER, FASTER or OK; times below minSeconds in the baseline are OK
+sub compareTime
+{
+	my ($new, $old) = @_;
+	return "OK" if ($old < $minSeconds);
+	return "SLOWER" if ($new > $old*(1 + $timeTol));
+	return "FASTER" if ($new < $old*(1 - $timeTol));
+	return "OK";
+}
+
+sub report
+{
+	my ($results, $baseValues) = @_;
+	my $regressions = 0;
+	print "#Name Seconds BaselineSeconds Ratio MaxRssMB BaselineMaxRssMB Status\n";
+	foreach my $r (@$results) {
+		my $name = $r->{"name"};
+		if ($r->{"seconds"} < 0) {
+			print "$name - - - - - FAILED\n";
+			++$regressions;
+			next;
+		}
+
+		my $old = $baseValues->{"$name"};
+		if (!defined($old)) {
+			printf("%s %.3f - - %.1f - NO_BASELINE\n", $name, $r->{"seconds"}, $r->{"rssKb"}/1024);
+			next;
+		}
+
+		my @status;
+		my $timeStatus = compareTime($r->{"seconds"}, $old->{"seconds"});
+		push @status, $timeStatus if ($timeStatus ne "OK");
+		push @status, "MORE_MEMORY" if ($r->{"rssKb"} > $old->{"rssKb"}*(1 + $memTol));
+
+		my $phases = $r->{"phases"};
+		my $oldPhases = $old->{"phases"};
+		foreach my $phase (sort keys %$phases) {
+			next unless (exists($oldPhases->{$phase}));
+			my $phaseStatus = compareTime($phases->{$phase}, $oldPhases->{$phase});
+			push @status, "$phase:SLOWER" if ($phaseStatus eq "SLOWER");
+		}
+
+		my $regressed = grep { /SLOWER|MORE_MEMORY/ } @status;
+		++$regressions if ($regressed);
+		my $ratio = ($old->{"seconds"} > 0) ? $r->{"seconds"}/$old->{"seconds"} : 0;
+		printf("%s %.3f %.3f %.3f %.1f %.1f %s\n",
+		       $name,
+		       $r->{"seconds"},
+		       $old->{"seconds"},
+		       $ratio,
+		       $r->{"rssKb"}/1024,
+		       $old->{"rssKb"}/1024,
+		       (scalar(@status) > 0) ? join(",", @status) : "OK");
+	}
+
+	print "#Regressions=$regressions\n";
+	return $regressions;
+}
+
+sub prepareDir
+{
+	my $b = (-r "$workdir");
+	system("mkdir $workdir") if (!$b);
+	system("cp -av ../src/dmrg $workdir/");
+	chdir("$workdir/");
+}
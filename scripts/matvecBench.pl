@@ -0,0 +1,122 @@
+#!/usr/bin/perl
+
+=pod
+USAGE is matvecBench.pl dmrgBefore dmrgAfter [repetitions] [input ...]
+
+Runs both dmrg executables on a copy of each input that adds nofiniteloops
+to SolverOptions, so that only the infinite algorithm runs, and divides the
+wall time of the run by the number of Lanczos steps, read from the
+"eigenvalue= ... after N iterations" lines of the solver.
+The infinite steps are dominated by the Hamiltonian products, so that
+the seconds per step compare the matrix vector products of both executables.
+Inputs should not set MatrixVectorStored or MatrixVectorKron in
+SolverOptions, so that the Hamiltonian product is done on the fly,
+and should use the Lanczos solver.
+Inputs default to TestSuite inputs 0 (Hubbard) and 20 (Heisenberg).
+
+OUTPUT is 7 columns
+Input LanczosSteps SecondsPerStepBefore SecondsPerStepAfter Speedup
+for the best of the repetitions, and the seconds of that repetition
+before and after as the last two columns
+=cut
+
+use warnings;
+use strict;
+use utf8;
+use File::Basename;
+use Cwd qw(abs_path);
+use Time::HiRes qw(time);
+
+my ($before, $after, $reps, @inputs) = @ARGV;
+defined($after) or die "USAGE: $0 dmrgBefore dmrgAfter [repetitions] [input ...]\n";
+defined($reps) or $reps = 3;
+
+if (scalar(@inputs) == 0) {
+	my $dir = dirname(abs_path($0))."/../TestSuite/inputs";
+	@inputs = ("$dir/input0.inp", "$dir/input20.inp");
+}
+
+$before = abs_path($before);
+$after = abs_path($after);
+
+print "#Input LanczosSteps SecondsPerStepBefore SecondsPerStepAfter Speedup ";
+print "SecondsBefore SecondsAfter\n";
+foreach my $input (@inputs) {
+	my $infinite = "matvecBench.inp";
+	writeInfinite($input, $infinite);
+	my ($sBefore, $cBefore) = bestOf($before, $infinite, $reps);
+	my ($sAfter, $cAfter) = bestOf($after, $infinite, $reps);
+	($cBefore == $cAfter)
+		or print STDERR "$0: WARNING: $input has $cBefore steps before, $cAfter after\n";
+	my $perBefore = $sBefore/$cBefore;
+	my $perAfter = $sAfter/$cAfter;
+	my $speedup = ($perAfter > 0) ? $perBefore/$perAfter : 0;
+	printf("%s %d %.6g %.6g %.3f %.3f %.3f\n", basename($input), $cAfter,
+	       $perBefore, $perAfter, $speedup, $sBefore, $sAfter);
+	unlink($infinite);
+}
+
+sub bestOf
+{
+	my ($dmrg, $input, $reps) = @_;
+	my ($best, $steps) = (0, 0);
+	my $cout = "matvecBench.cout";
+	for (my $i = 0; $i < $reps; ++$i) {
+		my $start = time();
+		system("$dmrg -f $input > $cout 2>&1") == 0
+			or die "$0: $dmrg -f $input failed, see $cout\n";
+		my $s = time() - $start;
+		my $c = stepsOf($cout);
+		($c > 0) or die "$0: No Lanczos steps in $cout\n";
+		if ($i == 0 || $s < $best) {
+			$best = $s;
+			$steps = $c;
+		}
+	}
+
+	return ($best, $steps);
+}
+
+# Sums the Lanczos steps of the run
+sub stepsOf
+{
+	my ($cout) = @_;
+	my $steps = 0;
+	open(FILE, "<", $cout) or die "$0: Cannot open $cout : $!\n";
+	while (<FILE>) {
+		next unless (/eigenvalue= *\S+ after (\d+) iterations/);
+		$steps += $1;
+	}
+
+	close(FILE);
+	return $steps;
+}
+
+sub writeInfinite
+{
+	my ($input, $infinite) = @_;
+	my $hasOptions = 0;
+	open(FILE, "<", $input) or die "$0: Cannot open $input : $!\n";
+	open(FOUT, ">", $infinite) or die "$0: Cannot write $infinite : $!\n";
+	while (<FILE>) {
+		if (/^SolverOptions=(.*)$/) {
+			my $opts = $1;
+			if ($opts =~ /MatrixVectorStored/ or $opts =~ /MatrixVectorKron/) {
+				close(FILE);
+				close(FOUT);
+				unlink($infinite);
+				die "$0: $input does not use MatrixVectorOnTheFly\n";
+			}
+
+			$opts = ($opts =~ /^ *none *$/) ? "nofiniteloops" : "$opts,nofiniteloops";
+			$_ = "SolverOptions=$opts\n";
+			$hasOptions = 1;
+		}
+
+		print FOUT;
+	}
+
+	close(FILE);
+	close(FOUT);
+	$hasOptions or die "$0: $input has no SolverOptions\n";
+}
@@ -115,8 +115,8 @@ public:
 
 		PsimagLite::String tarname = tarName(parameters_.filename);
 		Dmrg::TarPack tarPack(tarname);
-		for (SizeType i = 0; i < files_.size(); ++i)
-			tarPack.add(files_[i]);
+		tarPack.add(files_);
+		tarPack.close();
 
 		if (parameters_.options.find("tarNoDelete") != PsimagLite::String::npos)
 			return;
@@ -2,22 +2,60 @@
 #define BASESTACK_H
 #include "DiskStack.h"
 #include <errno.h>
+#include <map>
+#include <algorithm>
 #include "IoSelector.h"
 
 namespace Dmrg {
 
+// A stack kept in memory or, with diskstacks, in disk
+//
+// In memory, entries are held by pointer, so that a recovery snapshot can
+// write them from a background thread without copying them. While a snapshot
+// is pinned, popped entries are only freed on unpin(). For each recovery file,
+// the stack remembers which of its entries are already in the file, and a
+// snapshot appends only the entries pushed after the last one.
+// To stay within a memory budget, the oldest entries in memory can be moved
+// to a DiskStack with spill(); they come back when they become the top, or
+// when a snapshot or a copy needs them.
 template<typename DataType>
 class BaseStack {
 
 	typedef DiskStack<DataType> DiskStackType;
 	typedef PsimagLite::Vector<PsimagLite::String>::Type VectorStringType;
+	typedef PsimagLite::Vector<SizeType>::Type VectorSizeType;
+	typedef typename PsimagLite::Vector<DataType*>::Type VectorDataPointerType;
 	typedef typename PsimagLite::IoSelector::In IoInType;
 	typedef typename PsimagLite::IoSelector::Out IoOutType;
 
+	struct SnapshotFileType {
+
+		SnapshotFileType() : total(0), lowWater(0) {}
+
+		VectorSizeType instances; // instance in the file of each entry, bottom first
+		SizeType total; // number of instances in the file
+		SizeType lowWater; // lowest size of the stack since the last snapshot
+	};
+
+	typedef std::map<PsimagLite::String, SnapshotFileType> MapSnapshotFileType;
+
 public:
 
+	typedef typename PsimagLite::Vector<const DataType*>::Type VectorConstDataPointerType;
+
+	// What a snapshot appends to its file
+	struct SnapshotType {
+
+		SnapshotType() : total(0) {}
+
+		PsimagLite::String file;
+		VectorConstDataPointerType entries;
+		VectorSizeType instances;
+		SizeType total;
+	};
+
 	BaseStack(bool disk)
-	    : m_(!disk), diskStack_(0)
+	    : m_(!disk), diskStack_(0), spillStack_(0), spilled_(0), pinned_(false)
 	{
 		if (m_) return;
 		PsimagLite::String tmpfname = tmpFname();
@@ -26,10 +64,13 @@ public:
 	}
 
 	BaseStack(const BaseStack& other)
-	    : m_(other.m_), diskStack_(0)
+	    : m_(other.m_), diskStack_(0), spillStack_(0), spilled_(0), pinned_(false)
 	{
 		if (m_) {
-			stack_ = other.stack_;
+			other.unspill(0);
+			for (SizeType i = 0; i < other.stack_.size(); ++i)
+				stack_.push_back(new DataType(*(other.stack_[i])));
+			bytes_ = other.bytes_;
 			return;
 		}
 
@@ -48,24 +89,49 @@ public:
 
 		delete diskStack_;
 		diskStack_ = 0;
+		delete spillStack_;
+		spillStack_ = 0;
+
+		pinned_ = false;
+		unpin();
+		for (SizeType i = 0; i < stack_.size(); ++i)
+			delete stack_[i];
 	}
 
 	void push(const DataType& d)
 	{
 		check();
-		return (m_) ? stack_.push(d) : diskStack_->push(d);
+		if (!m_) return diskStack_->push(d);
+		stack_.push_back(new DataType(d));
+		bytes_.push_back(d.memoryUsage());
 	}
 
 	void pop()
 	{
 		check();
-		return (m_) ? stack_.pop() : diskStack_->pop();
+		if (!m_) return diskStack_->pop();
+
+		assert(stack_.size() > 0);
+		DataType* d = stack_[stack_.size() - 1];
+		stack_.pop_back();
+		bytes_.pop_back();
+		discard(d);
+
+		SizeType n = stack_.size();
+		typename MapSnapshotFileType::iterator it = snapshotFiles_.begin();
+		for (; it != snapshotFiles_.end(); ++it)
+			if (it->second.lowWater > n) it->second.lowWater = n;
+
+		// the top is always in memory
+		if (n > 0) unspill(n - 1);
 	}
 
 	const DataType& top() const
 	{
 		check();
-		return (m_) ? stack_.top() : diskStack_->top();
+		if (!m_) return diskStack_->top();
+		assert(stack_.size() > 0);
+		return *(stack_[stack_.size() - 1]);
 	}
 
 	SizeType size() const
@@ -76,10 +142,137 @@ public:
 
 	bool inDisk() const { return !m_; }
 
+	// Bytes of the entries in memory
+	SizeType memoryUsage() const
+	{
+		SizeType total = 0;
+		for (SizeType i = spilled_; i < bytes_.size(); ++i)
+			total += bytes_[i];
+		return total;
+	}
+
+	// Bytes of the entries moved to disk by spill()
+	SizeType spilledBytes() const
+	{
+		SizeType total = 0;
+		for (SizeType i = 0; i < spilled_; ++i)
+			total += bytes_[i];
+		return total;
+	}
+
+	// Only in memory. Moves the oldest entries to disk until at least
+	// bytes are freed, and returns the bytes freed. The top, and entries
+	// not yet in all snapshot files, stay in memory
+	SizeType spill(SizeType bytes)
+	{
+		if (!m_) return 0;
+
+		SizeType limit = stack_.size();
+		if (limit > 0) --limit;
+		typename MapSnapshotFileType::const_iterator it = snapshotFiles_.begin();
+		for (; it != snapshotFiles_.end(); ++it) {
+			SizeType ninstances = it->second.instances.size();
+			limit = std::min(limit, std::min(it->second.lowWater, ninstances));
+		}
+
+		if (spilled_ >= limit) return 0;
+
+		if (spillStack_ == 0) {
+			PsimagLite::String tmpfname = tmpFname();
+			files_.push_back(tmpfname);
+			spillStack_ = new DiskStackType(tmpfname, tmpfname, false, false);
+		}
+
+		SizeType freed = 0;
+		while (spilled_ < limit && freed < bytes) {
+			spillStack_->push(*(stack_[spilled_]));
+			discard(stack_[spilled_]);
+			stack_[spilled_] = 0;
+			freed += bytes_[spilled_++];
+		}
+
+		return freed;
+	}
+
+	// Only in memory. Fills s with the entries not yet in file, and pins them
+	// until unpin() is called. If the file holds more dead entries than
+	// the stack has entries, it is truncated and rewritten
+	void snapshot(SnapshotType& s, PsimagLite::String file) const
+	{
+		if (!m_) err("BaseStack::snapshot: stack is in disk\n");
+		if (pinned_) err("BaseStack::snapshot: previous snapshot still pinned\n");
+
+		SizeType n = stack_.size();
+		typename MapSnapshotFileType::iterator it = snapshotFiles_.find(file);
+		bool fresh = (it == snapshotFiles_.end());
+		if (fresh) {
+			snapshotFiles_[file] = SnapshotFileType();
+			it = snapshotFiles_.find(file);
+		}
+
+		SnapshotFileType& sf = it->second;
+		SizeType ninstances = sf.instances.size();
+		SizeType kept = std::min(sf.lowWater, ninstances);
+		if (sf.total - kept > n) fresh = true;
+		if (fresh) {
+			sf = SnapshotFileType();
+			kept = 0;
+			unlink(file.c_str());
+		}
+
+		unspill(kept);
+
+		sf.instances.resize(kept);
+		s.file = file;
+		s.entries.clear();
+		for (SizeType i = kept; i < n; ++i) {
+			s.entries.push_back(stack_[i]);
+			sf.instances.push_back(sf.total++);
+		}
+
+		sf.lowWater = n;
+		s.instances = sf.instances;
+		s.total = sf.total;
+		pinned_ = true;
+	}
+
+	// Frees the entries popped while the snapshot was pinned
+	void unpin() const
+	{
+		pinned_ = false;
+		for (SizeType i = 0; i < graveyard_.size(); ++i)
+			delete graveyard_[i];
+		graveyard_.clear();
+	}
+
+	// Appends a snapshot to its file, in the format of DiskStack.
+	// Can be called from a background thread while the stack is pinned
+	static void writeSnapshot(const SnapshotType& s)
+	{
+		IoOutType io;
+		io.open(s.file, std::ios_base::app);
+		for (SizeType i = 0; i < s.entries.size(); ++i)
+			s.entries[i]->save(io, DataType::SAVE_ALL);
+
+		typename PsimagLite::Stack<SizeType>::Type meta;
+		for (SizeType i = 0; i < s.instances.size(); ++i)
+			meta.push(s.instances[i]);
+
+		int x = 0;
+		io.printline("#STACKMETARANK=" + ttos(x));
+		io.printline("#STACKMETATOTAL=" + ttos(s.total));
+		io.print("#STACKMETASTACK\n", meta);
+		io.close();
+	}
+
 	void save(IoOutType& io, PsimagLite::String label) const
 	{
 		if (m_) {
-			io.print(label, stack_);
+			unspill(0);
+			typename PsimagLite::Stack<DataType>::Type stack;
+			for (SizeType i = 0; i < stack_.size(); ++i)
+				stack.push(*(stack_[i]));
+			io.print(label, stack);
 			return;
 		}
 
@@ -89,7 +282,19 @@ public:
 	void load(IoInType& io, PsimagLite::String label)
 	{
 		if (m_) {
-			io.read(stack_, label);
+			typename PsimagLite::Stack<DataType>::Type stack;
+			io.read(stack, label);
+			VectorDataPointerType tmp;
+			while (stack.size() > 0) {
+				tmp.push_back(new DataType(stack.top()));
+				stack.pop();
+			}
+
+			for (SizeType i = 0; i < tmp.size(); ++i) {
+				stack_.push_back(tmp[tmp.size() - 1 - i]);
+				bytes_.push_back(stack_.back()->memoryUsage());
+			}
+
 			return;
 		}
 
@@ -98,6 +303,25 @@ public:
 
 private:
 
+	// Brings back the spilled entries from index on
+	void unspill(SizeType index) const
+	{
+		while (spilled_ > index) {
+			--spilled_;
+			stack_[spilled_] = new DataType(spillStack_->top());
+			spillStack_->pop();
+		}
+	}
+
+	// Frees an entry no longer in the stack, unless a snapshot pins it
+	void discard(DataType* d) const
+	{
+		if (pinned_)
+			graveyard_.push_back(d);
+		else
+			delete d;
+	}
+
 	void check() const
 	{
 		if (m_) return;
@@ -130,9 +354,15 @@ private:
 	BaseStack& operator=(const BaseStack&);
 
 	bool m_;
-	typename PsimagLite::Stack<DataType>::Type stack_;
+	mutable VectorDataPointerType stack_; // spilled entries are null
+	VectorSizeType bytes_;
 	DiskStackType* diskStack_;
+	mutable DiskStackType* spillStack_;
+	mutable SizeType spilled_; // number of entries, from the bottom, in spillStack_
 	VectorStringType files_;
+	mutable bool pinned_;
+	mutable VectorDataPointerType graveyard_;
+	mutable MapSnapshotFileType snapshotFiles_;
 };
 }
 #endif // BASESTACK_H
@@ -85,6 +85,10 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "HamiltonianSymmetryLocal.h"
 #include "HamiltonianSymmetrySu2.h"
 #include "ProgressIndicator.h"
+#include "MemoryAccounting.h"
+#include "Concurrency.h"
+#include "Parallelizer.h"
+#include <map>
 
 namespace Dmrg {
 // A class to represent in a light way a Dmrg basis (used only to implement symmetries).
@@ -98,6 +102,8 @@ class Basis {
 	typedef HamiltonianSymmetryLocal<SparseMatrixType_>  HamiltonianSymmetryLocalType;
 	typedef HamiltonianSymmetrySu2<SparseMatrixType_>  HamiltonianSymmetrySu2Type;
 
+	static const SizeType MIN_STATES_FOR_THREADS = 1048576;
+
 public:
 
 	typedef typename PsimagLite::Vector<SizeType>::Type VectorSizeType;
@@ -190,13 +196,14 @@ public:
 			                      su2Symmetry3.electrons_,
 			                      electrons_,
 			                      quantumNumbers_);
+
+			// order quantum numbers of combined basis:
+			findPermutationAndPartition();
+			reorder();
 		} else {
 			SizeType ns = su2Symmetry2.size();
 			SizeType ne = su2Symmetry3.size();
 
-			quantumNumbers_.clear();
-			electrons_.clear();
-
 			unsigned long int check = ns*ne;
 			unsigned int shift = 8*sizeof(SizeType)-1;
 			unsigned long int max = 1;
@@ -208,18 +215,9 @@ public:
 				throw PsimagLite::RuntimeError(msg);
 			}
 
-			for (SizeType j=0;j<ne;j++) for (SizeType i=0;i<ns;i++) {
-				quantumNumbers_.push_back(su2Symmetry2.quantumNumbers_[i]+
-				                          su2Symmetry3.quantumNumbers_[j]);
-				electrons_.push_back(su2Symmetry2.electrons_[i]+
-				                     su2Symmetry3.electrons_[j]);
-			}
+			setToProductLocal(su2Symmetry2,su2Symmetry3);
 		}
 
-		// order quantum numbers of combined basis:
-		findPermutationAndPartition();
-
-		reorder();
 		electronsOld_ = electrons_;
 	}
 
@@ -459,6 +457,16 @@ public:
 	//! Returns true if this basis has been DMRG transformed, or false if it hasn't
 	bool dmrgTransformed() const { return dmrgTransformed_; }
 
+	SizeType memoryUsage() const
+	{
+		return MemoryAccounting::bytes(quantumNumbers_) +
+		        MemoryAccounting::bytes(electrons_) +
+		        MemoryAccounting::bytes(electronsOld_) +
+		        MemoryAccounting::bytes(partition_) +
+		        MemoryAccounting::bytes(permutationVector_) +
+		        MemoryAccounting::bytes(permInverse_);
+	}
+
 	//! Returns the reduced (by the Wigner Eckart theorem) index corresponding to state i
 	SizeType reducedIndex(SizeType i) const
 	{
@@ -652,6 +660,122 @@ private:
 		if (useSu2Symmetry_) symmSu2_.truncate(removedIndices,electrons_);
 	}
 
+	// A block of the product basis: the states i of partition a of basis2
+	// times the states j of partition b of basis3, with j the slow index
+	struct SectorPair {
+		SizeType offset;
+		SizeType start2;
+		SizeType size2;
+		SizeType start3;
+		SizeType size3;
+		SizeType qn;
+	};
+
+	typedef typename PsimagLite::Vector<SectorPair>::Type VectorSectorPairType;
+
+	class ParallelProduct {
+
+	public:
+
+		ParallelProduct(ThisType& basis,
+		                const ThisType& basis2,
+		                const ThisType& basis3,
+		                const VectorSectorPairType& pairs)
+		    : basis_(basis), basis2_(basis2), basis3_(basis3), pairs_(pairs)
+		{}
+
+		SizeType tasks() const { return pairs_.size(); }
+
+		void doTask(SizeType taskNumber, SizeType)
+		{
+			const SectorPair& pair = pairs_[taskNumber];
+			SizeType ns = basis2_.size();
+			SizeType t = pair.offset;
+			for (SizeType j = pair.start3; j < pair.start3 + pair.size3; ++j) {
+				for (SizeType i = pair.start2; i < pair.start2 + pair.size2; ++i) {
+					SizeType x = i + j*ns;
+					basis_.permutationVector_[t] = x;
+					basis_.permInverse_[x] = t;
+					basis_.quantumNumbers_[t] = pair.qn;
+					basis_.electrons_[t] = basis2_.electrons_[i] + basis3_.electrons_[j];
+					++t;
+				}
+			}
+		}
+
+	private:
+
+		ThisType& basis_;
+		const ThisType& basis2_;
+		const ThisType& basis3_;
+		const VectorSectorPairType& pairs_;
+	}; // class ParallelProduct
+
+	// The partitions of basis2 and basis3 are bucketed by the quantum number
+	// of their product, so that the permutation is built without sorting
+	// the ns*ne product states. States with the same quantum number are in
+	// the order of i + j*ns, as a stable sort would give.
+	void setToProductLocal(const ThisType& basis2, const ThisType& basis3)
+	{
+		typedef std::map<SizeType, SizeType> MapSizeType;
+
+		MapSizeType partitionOfQn2;
+		for (SizeType a = 0; a + 1 < basis2.partition_.size(); ++a)
+			partitionOfQn2[basis2.quantumNumbers_[basis2.partition_[a]]] = a;
+
+		MapSizeType sizeOfQn;
+		for (SizeType a = 0; a + 1 < basis2.partition_.size(); ++a) {
+			SizeType size2 = basis2.partition_[a + 1] - basis2.partition_[a];
+			SizeType q2 = basis2.quantumNumbers_[basis2.partition_[a]];
+			for (SizeType b = 0; b + 1 < basis3.partition_.size(); ++b) {
+				SizeType size3 = basis3.partition_[b + 1] - basis3.partition_[b];
+				sizeOfQn[q2 + basis3.quantumNumbers_[basis3.partition_[b]]] += size2*size3;
+			}
+		}
+
+		VectorSectorPairType pairs;
+		partition_.clear();
+		SizeType offset = 0;
+		MapSizeType::const_iterator it = sizeOfQn.begin();
+		for (; it != sizeOfQn.end(); ++it) {
+			SizeType qn = it->first;
+			partition_.push_back(offset);
+			for (SizeType b = 0; b + 1 < basis3.partition_.size(); ++b) {
+				SizeType q3 = basis3.quantumNumbers_[basis3.partition_[b]];
+				if (q3 > qn) continue;
+				MapSizeType::const_iterator a = partitionOfQn2.find(qn - q3);
+				if (a == partitionOfQn2.end()) continue;
+
+				SectorPair pair;
+				pair.offset = offset;
+				pair.start2 = basis2.partition_[a->second];
+				pair.size2 = basis2.partition_[a->second + 1] - pair.start2;
+				pair.start3 = basis3.partition_[b];
+				pair.size3 = basis3.partition_[b + 1] - pair.start3;
+				pair.qn = qn;
+				pairs.push_back(pair);
+				offset += pair.size2*pair.size3;
+			}
+
+			assert(offset == partition_[partition_.size() - 1] + it->second);
+		}
+
+		partition_.push_back(offset);
+		assert(offset == basis2.size()*basis3.size());
+
+		permutationVector_.resize(offset);
+		permInverse_.resize(offset);
+		quantumNumbers_.resize(offset);
+		electrons_.resize(offset);
+
+		SizeType threads = (offset < MIN_STATES_FOR_THREADS) ?
+		            1 : PsimagLite::Concurrency::npthreads;
+		ParallelProduct helper(*this, basis2, basis3, pairs);
+		PsimagLite::Parallelizer<ParallelProduct> threaded(threads,
+		                                                   PsimagLite::MPI::COMM_WORLD);
+		threaded.loopCreate(helper);
+	}
+
 	void reorder()
 	{
 		utils::reorder(electrons_,permutationVector_);
@@ -343,6 +343,11 @@ public:
 
 	SizeType numberOfOperators() const { return operators_.numberOfOperators(); }
 
+	SizeType memoryUsage() const
+	{
+		return BasisType::memoryUsage() + operators_.memoryUsage();
+	}
+
 	SizeType operatorsPerSite(SizeType i) const
 	{
 		assert(i < operatorsPerSite_.size());
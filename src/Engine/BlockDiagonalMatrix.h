@@ -88,6 +88,7 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "PsimagLite.h"
 #include "EnforcePhase.h"
 #include "IoSelector.h"
+#include "MemoryAccounting.h"
 
 namespace Dmrg {
 
@@ -239,6 +240,14 @@ public:
 
 	SizeType blocks() const { return data_.size(); }
 
+	SizeType memoryUsage() const
+	{
+		SizeType total = 0;
+		for (SizeType i = 0; i < data_.size(); ++i)
+			total += MemoryAccounting::bytes(data_[i]);
+		return total;
+	}
+
 	void toSparse(PsimagLite::CrsMatrix<ComplexOrRealType>& fm) const
 	{
 		SizeType r = rows();
@@ -249,6 +249,20 @@ public:
 		return (option == ProgramGlobals::SYSTEM) ? systemStack_ : envStack_;
 	}
 
+	// Moves the oldest entries of the stacks to disk, from the larger
+	// stack first, until bytes are freed; returns the bytes freed
+	SizeType spillStacks(SizeType bytes)
+	{
+		MemoryStackType* first = &systemStack_;
+		MemoryStackType* second = &envStack_;
+		if (envStack_.memoryUsage() > systemStack_.memoryUsage())
+			std::swap(first, second);
+
+		SizeType freed = first->spill(bytes);
+		if (freed < bytes) freed += second->spill(bytes - freed);
+		return freed;
+	}
+
 	template<typename StackType1,typename StackType2>
 	static void loadStack(StackType1& stackInMemory,StackType2& stackInDisk)
 	{
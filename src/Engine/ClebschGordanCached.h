@@ -85,6 +85,12 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 
 namespace Dmrg {
 
+// Table of Clebsch-Gordan coefficients
+//
+// init() computes all coefficients with 2j < jmax for the factors, and
+// operator() only reads the table, so that it can be called concurrently
+// from the SU(2) code. Su2SymmetryGlobals::init() must be called before any
+// threads are started.
 template<typename FieldType>
 class ClebschGordanCached {
 	typedef ClebschGordan<FieldType> ClebschGordanType;
@@ -93,46 +99,68 @@ class ClebschGordanCached {
 public:
 
 	ClebschGordanCached(SizeType jmax)
-	    :  UNDEFINED_VALUE(-1000),
-	      jmax_(jmax),
+	    : jmax_(jmax),
 	      max2_(((jmax_-1)*(jmax_+2))/2+1),max22_(max2_*max2_),
-	      data_(max22_*jmax_*2,UNDEFINED_VALUE),cgObject_(2)
-	{
-		init(jmax,2);
-	}
+	      cgObject_(2)
+	{}
 
 	void init(SizeType jmax,SizeType nfactorials)
 	{
+		if (jmax == jmax_ && data_.size() > 0) return;
+
 		jmax_=jmax;
 		max2_=((jmax_-1)*(jmax_+2))/2+1;
 		max22_=max2_*max2_;
-		data_.resize(max22_*jmax_*2,UNDEFINED_VALUE);
+		data_.clear();
+		data_.resize(max22_*jmax_*2,0.0);
 		cgObject_.init(nfactorials);
 
-		copies_++;
-		if (copies_>2) {
-			std::cerr<<"WARNING: ClebschGordanCached has ";
-			std::cerr<<copies_<<" copies.\n";
+		for (SizeType j1 = 0; j1 < jmax_; ++j1) {
+			for (SizeType m1 = 0; m1 <= j1; ++m1) {
+				PairType jm1(j1,m1);
+				for (SizeType j2 = 0; j2 < jmax_; ++j2) {
+					for (SizeType m2 = 0; m2 <= j2; ++m2) {
+						PairType jm2(j2,m2);
+						fillCouplings(jm1,jm2);
+					}
+				}
+			}
 		}
 	}
 
-	FieldType operator()(const PairType& jm,const PairType& jm1,const PairType& jm2)
+	FieldType operator()(const PairType& jm,const PairType& jm1,const PairType& jm2) const
 	{
 		if (!checkCg(jm,jm1,jm2)) return 0;
 
+		assert(data_.size() > 0);
+		return data_[index(jm.first,jm1,jm2)];
+	}
+
+private:
+
+	// All j for j1 and j2 given, with m fixed by m1 and m2
+	void fillCouplings(const PairType& jm1,const PairType& jm2)
+	{
+		SizeType jmin = (jm1.first > jm2.first) ? jm1.first - jm2.first :
+		                                          jm2.first - jm1.first;
+		for (SizeType j = jmin; j <= jm1.first + jm2.first; j += 2) {
+			int m = calcM(j,jm1,jm2);
+			if (m < 0 || SizeType(m) > j) continue;
+			PairType jm(j,m);
+			data_[index(j,jm1,jm2)] = cgObject_(jm,jm1,jm2);
+		}
+	}
+
+	SizeType index(SizeType j,const PairType& jm1,const PairType& jm2) const
+	{
 		SizeType index1 = calcSubIndex(jm1);
 		SizeType index2 = calcSubIndex(jm2);
 		SizeType jmin=0;
 		if (jm1.first>jm2.first) jmin = jm1.first-jm2.first;
 		else jmin = jm2.first-jm1.first;
-		SizeType x = calcIndex(index1,index2)+(jm.first-jmin)*max22_;
-		if (data_[x]== UNDEFINED_VALUE) {
-			data_[x]=cgObject_(jm,jm1,jm2);
-		}
-		return data_[x];
+		return calcIndex(index1,index2)+(j-jmin)*max22_;
 	}
 
-private:
 	SizeType calcSubIndex(const PairType& jm) const
 	{
 		if (jm.second==0) return jm.first;
@@ -181,17 +209,12 @@ private:
 		return jm1.second+jm2.second-x;
 	}
 
-	static SizeType copies_;
-	int UNDEFINED_VALUE;
 	SizeType jmax_;
 	SizeType max2_,max22_;
 	typename PsimagLite::Vector<FieldType>::Type data_;
 	ClebschGordanType cgObject_;
 }; // class ClebschGordanCached
 
-template<typename FieldType>
-SizeType ClebschGordanCached<FieldType>::copies_=0;
-
 } // namespace Dmrg
 /*@}*/
 #endif
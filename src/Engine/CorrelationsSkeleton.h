@@ -86,7 +86,9 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "Profiling.h"
 #include "ApplyOperatorLocal.h"
 #include "Braket.h"
+#include "RowAccumulator.h"
 #include <numeric>
+#include <algorithm>
 
 namespace Dmrg {
 
@@ -131,6 +133,7 @@ public:
 	typedef PsimagLite::Profiling ProfilingType;
 	typedef typename BasisWithOperatorsType::OperatorType OperatorType;
 	typedef PsimagLite::CrsMatrix<FieldType> SparseMatrixType;
+	typedef RowAccumulator<SparseMatrixType> RowAccumulatorType;
 
 	enum {GROW_RIGHT,GROW_LEFT};
 
@@ -307,45 +310,37 @@ private:
 		SizeType ni=O1.rows();
 
 		helper_.setPointer(threadId,ns);
-		SizeType sprime = helper_.leftRightSuper(threadId).left().size(); //ni*nj;
+		const BasisType& left = helper_.leftRightSuper(threadId).left();
+		SizeType sprime = left.size(); //ni*nj;
 		result.resize(sprime,sprime);
 
-		if (helper_.leftRightSuper(threadId).left().size()!=sprime) {
-			std::cerr<<"WARNING: "<<helper_.leftRightSuper(threadId).left().size();
-			std::cerr<<"!="<<sprime<<"\n";
-			throw PsimagLite::RuntimeError("problem in dmrgMultiply\n");
-		}
-
-		PsimagLite::Vector<SizeType>::Type col(sprime,0);
-		typename PsimagLite::Vector<FieldType>::Type value(sprime,0);
+		const VectorSizeType& permutation = left.permutationVector();
+		const VectorSizeType& permutationInverse = left.permutationInverse();
+		typename PsimagLite::Vector<RealType>::Type signs(ni);
+		for (SizeType e = 0; e < ni; ++e)
+			signs[e] = helper_.fermionicSignLeft(threadId)(e,fermionicSign);
 
+		RowAccumulatorType accumulator(sprime);
 		PackIndicesType pack(ni);
 
 		SizeType counter = 0;
 		for (SizeType r=0;r<sprime;r++) {
 			SizeType e,u;
-			pack.unpack(e,u,helper_.leftRightSuper(threadId).left().permutation(r));
-			RealType f = helper_.fermionicSignLeft(threadId)(e,fermionicSign);
+			pack.unpack(e,u,permutation[r]);
+			RealType f = signs[e];
 			result.setRow(r,counter);
 			for (int k=O1.getRowPtr(e);k<O1.getRowPtr(e+1);k++) {
 				SizeType e2 = O1.getCol(k);
+				FieldType value = O1.getValue(k)*f;
 				for (int k2=O2.getRowPtr(u);k2<O2.getRowPtr(u+1);k2++) {
 					SizeType u2 = O2.getCol(k2);
-					SizeType r2 = helper_.leftRightSuper(threadId).left().
-					        permutationInverse(e2 + u2*ni);
-					value[r2] += O1.getValue(k)*O2.getValue(k2)*f;
-					col[r2] = 1;
+					accumulator.add(permutationInverse[e2 + u2*ni],value*O2.getValue(k2));
 				}
 			}
-			for (SizeType i=0;i<col.size();i++) {
-				if (col[i]==0) continue;
-				result.pushCol(i);
-				result.pushValue(value[i]);
-				counter++;
-				value[i] = 0.0;
-				col[i] = 0;
-			}
+
+			accumulator.flush(result,counter);
 		}
+
 		result.setRow(result.rows(),counter);
 		result.checkValidity();
 	}
@@ -362,18 +357,13 @@ private:
 		SizeType nj=O2.rows();
 
 		helper_.setPointer(threadId,ns);
-		SizeType eprime = helper_.leftRightSuper(threadId).right().size(); //ni*nj;
+		const BasisType& right = helper_.leftRightSuper(threadId).right();
+		SizeType eprime = right.size(); //ni*nj;
 		result.resize(eprime,eprime);
 
-		if (helper_.leftRightSuper(threadId).right().size()!=eprime) {
-			std::cerr<<"WARNING: "<<helper_.leftRightSuper(threadId).right().size();
-			std::cerr<<"!="<<eprime<<"\n";
-			throw PsimagLite::RuntimeError("problem in dmrgMultiply\n");
-		}
-
-		PsimagLite::Vector<SizeType>::Type col(eprime,0);
-		typename PsimagLite::Vector<FieldType>::Type value(eprime,0);
-
+		const VectorSizeType& permutation = right.permutationVector();
+		const VectorSizeType& permutationInverse = right.permutationInverse();
+		RowAccumulatorType accumulator(eprime);
 		PackIndicesType pack(nj);
 
 		SizeType counter = 0;
@@ -381,28 +371,20 @@ private:
 			result.setRow(r,counter);
 			SizeType e,u;
 
-			pack.unpack(e,u,helper_.leftRightSuper(threadId).right().permutation(r));
+			pack.unpack(e,u,permutation[r]);
 
 			for (int k=O2.getRowPtr(e);k<O2.getRowPtr(e+1);k++) {
 				SizeType e2 = O2.getCol(k);
+				FieldType value = O2.getValue(k)*f;
 				for (int k2=O1.getRowPtr(u);k2<O1.getRowPtr(u+1);k2++) {
 					SizeType u2 = O1.getCol(k2);
-					SizeType r2 = helper_.leftRightSuper(threadId).right().
-					        permutationInverse(e2 + u2*nj);
+					SizeType r2 = permutationInverse[e2 + u2*nj];
 					assert(r2<eprime);
-					col[r2] = 1;
-					value[r2] += O2.getValue(k)*O1.getValue(k2)*f;
+					accumulator.add(r2,value*O1.getValue(k2));
 				}
 			}
 
-			for (SizeType i=0;i<col.size();i++) {
-				if (col[i]==0) continue;
-				result.pushCol(i);
-				result.pushValue(value[i]);
-				counter++;
-				value[i] = 0.0;
-				col[i] = 0;
-			}
+			accumulator.flush(result,counter);
 		}
 
 		result.setRow(result.rows(),counter);
@@ -410,6 +392,8 @@ private:
 	}
 
 	// Perfomance critical:
+	// left.permutation(e) = i + k*n (GROW_RIGHT) or k + i*m (GROW_LEFT),
+	// and the result is O(i,j) for e2 with the same k
 	void fluffUpSystem(SparseMatrixType& ret2,
 	                   const SparseMatrixType& O,
 	                   int fermionicSign,
@@ -417,26 +401,23 @@ private:
 	                   bool transform,
 	                   SizeType threadId)
 	{
-		SizeType n =helper_.leftRightSuper(threadId).left().size();
-
-		MatrixType ret(n,n);
-
-		for (SizeType e=0;e<n;e++) {
-			for (SizeType e2=0;e2<n;e2++) {
-				ret(e,e2) = fluffUpSystem_(O,e,e2,fermionicSign,growOption,threadId);
-			}
-		}
-
+		const BasisType& left = helper_.leftRightSuper(threadId).left();
+		SizeType n = O.rows();
+		SizeType m = SizeType(left.size()/n);
+		const FermionSignType& fermionSign = helper_.fermionicSignLeft(threadId);
+		SparseMatrixType ret;
+		fluffUpSparse(ret,O,left,m,growOption,&fermionSign,fermionicSign,1.0);
 		if (transform) {
-			SparseMatrixType ret3(ret);
-			helper_.transform(ret2,ret3,threadId);
+			helper_.transform(ret2,ret,threadId);
 			return;
 		}
 
-		fullMatrixToCrsMatrix(ret2,ret);
+		ret2 = ret;
 	}
 
 	// Perfomance critical:
+	// right.permutation(e) = i + k*n (GROW_RIGHT) or k + i*m (GROW_LEFT),
+	// and the result is O(i,j) for e2 with the same k
 	void fluffUpEnviron(SparseMatrixType& ret2,
 	                    const SparseMatrixType& O,
 	                    int fermionicSign,
@@ -444,88 +425,66 @@ private:
 	                    bool transform,
 	                    SizeType threadId)
 	{
-		SizeType n =helper_.leftRightSuper(threadId).right().size();
-
-		MatrixType ret(n,n);
-		for (SizeType e=0;e<n;e++) {
-			for (SizeType e2=0;e2<n;e2++) {
-				ret(e,e2) = fluffUpEnviron_(
-				            O,e,e2,fermionicSign,growOption,threadId);
-			}
-		}
+		const BasisType& right = helper_.leftRightSuper(threadId).right();
+		SizeType n = O.rows();
+		SizeType m = SizeType(right.size()/n);
+		RealType sign = (growOption == GROW_RIGHT) ?
+		            fermionSignBasis(fermionicSign, helper_.leftRightSuper(threadId).left()) :
+		            fermionSignBasis(fermionicSign, helper_.leftRightSuper(threadId).super());
+		SparseMatrixType ret;
+		fluffUpSparse(ret,O,right,m,growOption,0,fermionicSign,sign);
 		if (transform) {
-			SparseMatrixType ret3(ret);
-			helper_.transform(ret2,ret3,threadId);
+			helper_.transform(ret2,ret,threadId);
 			return;
 		}
 
-		fullMatrixToCrsMatrix(ret2,ret);
+		ret2 = ret;
 	}
 
-	// Perfomance critical:
-	FieldType fluffUpSystem_(const SparseMatrixType& O,
-	                         SizeType e,
-	                         SizeType e2,
-	                         int fermionicSign,
-	                         int growOption,
-	                         SizeType threadId)
+	// With fermionSign, GROW_LEFT rows are multiplied by its value at k
+	void fluffUpSparse(SparseMatrixType& ret,
+	                   const SparseMatrixType& O,
+	                   const BasisType& basis,
+	                   SizeType m,
+	                   int growOption,
+	                   const FermionSignType* fermionSign,
+	                   int fermionicSign,
+	                   RealType sign)
 	{
 		SizeType n = O.rows();
-		SizeType m = SizeType(helper_.leftRightSuper(threadId).left().size()/n);
-		RealType sign = static_cast<RealType>(1.0);
-
-		// Sperm[e] = i +k*n or e= k + i*m
-		// Sperm[e2] = j+k*n or e2=k+j*m
-		SizeType i,j,k,k2;
-		if (growOption==GROW_RIGHT) {
-			if (SizeType(helper_.leftRightSuper(threadId).left().permutation(e)/n)!=
-			    SizeType(helper_.leftRightSuper(threadId).left().permutation(e2)/n))
-				return 0;
-			PackIndicesType pack(n);
-			pack.unpack(i,k,helper_.leftRightSuper(threadId).left().permutation(e));
-			pack.unpack(j,k2,helper_.leftRightSuper(threadId).left().permutation(e2));
-		} else {
-			if (SizeType(helper_.leftRightSuper(threadId).left().permutation(e)%m)!=
-			    SizeType(helper_.leftRightSuper(threadId).left().permutation(e2)%m))
-				return 0;
-			PackIndicesType pack(m);
-			pack.unpack(k,i,helper_.leftRightSuper(threadId).left().permutation(e));
-			pack.unpack(k2,j,helper_.leftRightSuper(threadId).left().permutation(e2));
-			sign = helper_.fermionicSignLeft(threadId)(k,fermionicSign);
-		}
-		if (k!=k2) return 0;
-		return O.element(i,j)*sign;
-	}
+		SizeType total = basis.size();
+		const VectorSizeType& permutation = basis.permutationVector();
+		const VectorSizeType& permutationInverse = basis.permutationInverse();
+		RowAccumulatorType accumulator(total);
+		ret.resize(total,total);
 
-	// Perfomance critical:
-	FieldType fluffUpEnviron_(const SparseMatrixType& O,
-	                          SizeType e,SizeType e2,
-	                          int fermionicSign,
-	                          int growOption,
-	                          SizeType threadId)
-	{
-		SizeType n = O.rows();
-		SizeType m = SizeType(helper_.leftRightSuper(threadId).right().size()/n);
-		RealType sign = 1;
-
-		// Eperm[e] = i +k*n or e= k + i*m
-		// Eperm[e2] = j+k*n or e2=k+j*m
-
-		SizeType i,j,k,k2;
-
-		if (growOption==GROW_RIGHT) {
-			PackIndicesType pack(n);
-			pack.unpack(i,k,helper_.leftRightSuper(threadId).right().permutation(e));
-			pack.unpack(j,k2,helper_.leftRightSuper(threadId).right().permutation(e2));
-			sign = fermionSignBasis(fermionicSign, helper_.leftRightSuper(threadId).left());
-		} else {
-			PackIndicesType pack(m);
-			pack.unpack(k,i,helper_.leftRightSuper(threadId).right().permutation(e));
-			pack.unpack(k2,j,helper_.leftRightSuper(threadId).right().permutation(e2));
-			sign = fermionSignBasis(fermionicSign,  helper_.leftRightSuper(threadId).super());
+		SizeType counter = 0;
+		for (SizeType e = 0; e < total; ++e) {
+			ret.setRow(e,counter);
+			SizeType i = 0;
+			SizeType k = 0;
+			RealType f = sign;
+			if (growOption == GROW_RIGHT) {
+				PackIndicesType pack(n);
+				pack.unpack(i,k,permutation[e]);
+			} else {
+				PackIndicesType pack(m);
+				pack.unpack(k,i,permutation[e]);
+				if (fermionSign) f = (*fermionSign)(k,fermionicSign);
+			}
+
+			for (int kk = O.getRowPtr(i); kk < O.getRowPtr(i + 1); ++kk) {
+				SizeType j = O.getCol(kk);
+				SizeType e2 = (growOption == GROW_RIGHT) ? permutationInverse[j + k*n] :
+				                                           permutationInverse[k + j*m];
+				accumulator.add(e2,O.getValue(kk)*f);
+			}
+
+			accumulator.flush(ret,counter);
 		}
 
-		return (k != k2) ? 0 : O.element(i,j)*sign;
+		ret.setRow(total,counter);
+		ret.checkValidity();
 	}
 
 	FieldType bracket_(const SparseMatrixType& A,
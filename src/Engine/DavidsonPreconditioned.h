@@ -0,0 +1,329 @@
+#ifndef DMRG_DAVIDSON_PRECONDITIONED_H
+#define DMRG_DAVIDSON_PRECONDITIONED_H
+#include <algorithm>
+#include "Matrix.h"
+#include "Random48.h"
+#include "ProgressIndicator.h"
+
+namespace Dmrg {
+
+// Davidson with the diagonal of the Hamiltonian as preconditioner
+//
+// The correction for the Ritz pair (theta, u) with residual r = Hu - theta u
+// is t_i = r_i/(theta - H_ii), orthogonalized to the search space.
+// The diagonal is obtained from MatrixType::diagonal(), which returns false
+// if it is not available, and then t = r.
+// For the n-th excited state the lowest n+1 Ritz pairs are converged, one
+// correction per iteration for the lowest pair not yet converged.
+// The initial vector is followed by the unit vectors of the excited+1 lowest
+// diagonal elements, because the preconditioner steers the search towards
+// states of diagonal close to the Ritz value, and a poor initial vector would
+// steer it to the middle of the spectrum.
+// The search space is restarted from the lowest excited+1 Ritz vectors when it
+// has MAX_SUBSPACE vectors, so that matrix vector products are not repeated.
+// Convergence is |r|^2 < tolerance, as the error in the energy goes as |r|^2.
+template<typename ParametersForSolverType, typename MatrixType, typename VectorType>
+class DavidsonPreconditioned {
+
+	typedef typename VectorType::value_type ComplexOrRealType;
+	typedef typename PsimagLite::Real<ComplexOrRealType>::Type RealType;
+	typedef typename PsimagLite::Vector<RealType>::Type VectorRealType;
+	typedef typename PsimagLite::Vector<VectorType>::Type VectorVectorType;
+	typedef PsimagLite::Matrix<ComplexOrRealType> DenseMatrixType;
+
+	static const SizeType MAX_SUBSPACE = 32;
+
+	class LessDiagonal {
+
+	public:
+
+		LessDiagonal(const VectorRealType& d) : d_(d) {}
+
+		bool operator()(SizeType i, SizeType j) const { return d_[i] < d_[j]; }
+
+	private:
+
+		const VectorRealType& d_;
+	};
+
+public:
+
+	DavidsonPreconditioned(MatrixType& mat, const ParametersForSolverType& params)
+	    : mat_(mat),
+	      params_(params),
+	      progress_("DavidsonPreconditioned"),
+	      rng_(3433117),
+	      steps_(0)
+	{
+		hasDiagonal_ = mat_.diagonal(diagonal_);
+	}
+
+	void computeExcitedState(RealType& energy, VectorType& z, SizeType excited)
+	{
+		SizeType n = mat_.rows();
+		VectorType initialVector(n);
+		for (SizeType i = 0; i < n; ++i)
+			initialVector[i] = rng_() - 0.5;
+
+		computeExcitedState(energy, z, initialVector, excited);
+	}
+
+	void computeExcitedState(RealType& energy,
+	                         VectorType& z,
+	                         const VectorType& initialVector,
+	                         SizeType excited)
+	{
+		SizeType n = mat_.rows();
+		if (excited >= n)
+			err("DavidsonPreconditioned: excited state beyond matrix rank\n");
+
+		SizeType maxSubspace = std::min(n, std::max(SizeType(MAX_SUBSPACE), 2*(excited + 1)));
+		VectorVectorType v;
+		VectorVectorType w;
+		VectorType t = initialVector;
+		SizeType maxSteps = std::max(params_.steps, excited + 2);
+		VectorRealType eigs;
+		DenseMatrixType h; // H in the search space
+		DenseMatrixType s;
+		VectorType u(n);
+		VectorType r(n);
+		RealType theta = 0.0;
+		RealType rnorm = 0.0;
+		bool converged = false;
+		steps_ = 0;
+
+		for (SizeType iter = 0; iter < maxSteps; ++iter) {
+			// t becomes the next search vector
+			if (!orthonormalize(t, v) && !addRandom(t, v)) break;
+
+			v.push_back(t);
+			w.push_back(VectorType(n, 0.0));
+			mat_.matrixVectorProduct(w[w.size() - 1], t);
+			++steps_;
+
+			SizeType k = v.size();
+			grow(h, v, w);
+			s = h;
+			eigs.resize(k);
+			diag(s, eigs, 'V');
+
+			if (hasDiagonal_ && k <= excited + 1 && k < n) {
+				unitVector(t, lowestDiagonal(k - 1));
+				continue;
+			}
+
+			if (!hasDiagonal_ && k <= excited && k < n) {
+				t = w[k - 1];
+				continue;
+			}
+
+			// lowest Ritz pair not converged, or the target one if all are
+			SizeType target = excited;
+			converged = true;
+			for (SizeType j = 0; j <= excited; ++j) {
+				theta = eigs[j];
+				ritz(u, v, s, j);
+				ritz(r, w, s, j);
+				for (SizeType i = 0; i < n; ++i)
+					r[i] -= theta*u[i];
+
+				rnorm = norm(r);
+				if (rnorm*rnorm < params_.tolerance) continue;
+				target = j;
+				converged = false;
+				break;
+			}
+
+			if (k == n) converged = true;
+			if (converged) break;
+
+			if (k == maxSubspace)
+				restart(h, v, w, s, eigs, excited + 1);
+
+			precondition(t, r, eigs[target]);
+		}
+
+		if (eigs.size() <= excited)
+			err("DavidsonPreconditioned: search space smaller than excited state\n");
+
+		theta = eigs[excited];
+		ritz(u, v, s, excited);
+		energy = theta;
+		z = u;
+
+		PsimagLite::OstringStream msg;
+		if (converged)
+			msg<<"Converged after "<<steps_<<" matrix vector products, residual "<<rnorm;
+		else
+			msg<<"WARNING: Not converged after "<<steps_<<" matrix vector products, residual "<<rnorm;
+		msg<<((hasDiagonal_) ? " with " : " without ")<<"diagonal preconditioner";
+		progress_.printline(msg, std::cout);
+	}
+
+	SizeType steps() const { return steps_; }
+
+private:
+
+	void precondition(VectorType& t, const VectorType& r, RealType theta) const
+	{
+		const RealType eps = 1e-8;
+		t = r;
+		if (!hasDiagonal_) return;
+
+		for (SizeType i = 0; i < t.size(); ++i) {
+			RealType denominator = theta - PsimagLite::real(diagonal_[i]);
+			if (fabs(denominator) < eps)
+				denominator = (denominator < 0) ? -eps : eps;
+			t[i] /= denominator;
+		}
+	}
+
+	// Index of the diagonal element that is the count-th lowest
+	SizeType lowestDiagonal(SizeType count) const
+	{
+		SizeType n = diagonal_.size();
+		VectorRealType d(n);
+		for (SizeType i = 0; i < n; ++i)
+			d[i] = PsimagLite::real(diagonal_[i]);
+
+		typename PsimagLite::Vector<SizeType>::Type perm(n);
+		for (SizeType i = 0; i < n; ++i)
+			perm[i] = i;
+
+		count = std::min(count, n - 1);
+		std::nth_element(perm.begin(),
+		                 perm.begin() + count,
+		                 perm.end(),
+		                 LessDiagonal(d));
+		return perm[count];
+	}
+
+	static void unitVector(VectorType& t, SizeType index)
+	{
+		for (SizeType i = 0; i < t.size(); ++i)
+			t[i] = 0.0;
+		t[index] = 1.0;
+	}
+
+	// Adds the row and column of the last search vector to h
+	static void grow(DenseMatrixType& h,
+	                 const VectorVectorType& v,
+	                 const VectorVectorType& w)
+	{
+		SizeType k = v.size();
+		DenseMatrixType hNew(k, k);
+		for (SizeType i = 0; i + 1 < k; ++i)
+			for (SizeType j = 0; j + 1 < k; ++j)
+				hNew(i, j) = h(i, j);
+
+		for (SizeType i = 0; i < k; ++i) {
+			hNew(i, k - 1) = dot(v[i], w[k - 1]);
+			hNew(k - 1, i) = PsimagLite::conj(hNew(i, k - 1));
+		}
+
+		h = hNew;
+	}
+
+	// Collapses the search space into the lowest m Ritz vectors, where h is
+	// diagonal, and s and eigs become those of the collapsed space, so that
+	// the loop can end right after a restart
+	static void restart(DenseMatrixType& h,
+	                    VectorVectorType& v,
+	                    VectorVectorType& w,
+	                    DenseMatrixType& s,
+	                    VectorRealType& eigs,
+	                    SizeType m)
+	{
+		SizeType n = v[0].size();
+		VectorVectorType vNew(m, VectorType(n));
+		VectorVectorType wNew(m, VectorType(n));
+		for (SizeType j = 0; j < m; ++j) {
+			ritz(vNew[j], v, s, j);
+			ritz(wNew[j], w, s, j);
+		}
+
+		v.swap(vNew);
+		w.swap(wNew);
+		eigs.resize(m);
+		h.resize(m, m);
+		s.resize(m, m);
+		for (SizeType i = 0; i < m; ++i) {
+			for (SizeType j = 0; j < m; ++j) {
+				h(i, j) = (i == j) ? eigs[i] : 0.0;
+				s(i, j) = (i == j) ? 1.0 : 0.0;
+			}
+		}
+	}
+
+	static void ritz(VectorType& x,
+	                 const VectorVectorType& basis,
+	                 const DenseMatrixType& s,
+	                 SizeType col)
+	{
+		SizeType n = basis[0].size();
+		x.resize(n);
+		for (SizeType i = 0; i < n; ++i)
+			x[i] = 0.0;
+
+		for (SizeType k = 0; k < basis.size(); ++k) {
+			ComplexOrRealType c = s(k, col);
+			for (SizeType i = 0; i < n; ++i)
+				x[i] += basis[k][i]*c;
+		}
+	}
+
+	// Gram-Schmidt, twice, against v; returns false if nothing is left
+	static bool orthonormalize(VectorType& t, const VectorVectorType& v)
+	{
+		RealType norm0 = norm(t);
+		if (norm0 < 1e-12) return false;
+
+		for (SizeType pass = 0; pass < 2; ++pass) {
+			for (SizeType k = 0; k < v.size(); ++k) {
+				ComplexOrRealType c = dot(v[k], t);
+				for (SizeType i = 0; i < t.size(); ++i)
+					t[i] -= c*v[k][i];
+			}
+		}
+
+		RealType norm1 = norm(t);
+		if (norm1 < 1e-10*norm0) return false;
+
+		for (SizeType i = 0; i < t.size(); ++i)
+			t[i] /= norm1;
+
+		return true;
+	}
+
+	bool addRandom(VectorType& t, const VectorVectorType& v)
+	{
+		for (SizeType i = 0; i < t.size(); ++i)
+			t[i] = rng_() - 0.5;
+
+		return orthonormalize(t, v);
+	}
+
+	static ComplexOrRealType dot(const VectorType& a, const VectorType& b)
+	{
+		ComplexOrRealType sum = 0.0;
+		for (SizeType i = 0; i < a.size(); ++i)
+			sum += PsimagLite::conj(a[i])*b[i];
+		return sum;
+	}
+
+	static RealType norm(const VectorType& a)
+	{
+		return sqrt(PsimagLite::real(dot(a, a)));
+	}
+
+	MatrixType& mat_;
+	const ParametersForSolverType& params_;
+	PsimagLite::ProgressIndicator progress_;
+	PsimagLite::Random48<RealType> rng_;
+	VectorType diagonal_;
+	bool hasDiagonal_;
+	SizeType steps_;
+}; // class DavidsonPreconditioned
+} // namespace Dmrg
+
+#endif // DMRG_DAVIDSON_PRECONDITIONED_H
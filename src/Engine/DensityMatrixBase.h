@@ -101,14 +101,29 @@ public:
 
 	struct Params {
 
-		Params(bool u, ProgramGlobals::DirectionEnum d, bool v, bool de)
-		    : useSvd(u), direction(d), verbose(v), debug(de)
+		Params(bool u,
+		       ProgramGlobals::DirectionEnum d,
+		       bool v,
+		       bool de,
+		       SizeType k,
+		       bool t,
+		       RealType pe = 0.0)
+		    : useSvd(u),
+		      direction(d),
+		      verbose(v),
+		      debug(de),
+		      keptStates(k),
+		      truncatedSvd(t),
+		      perturbation(pe)
 		{}
 
 		bool useSvd;
 		ProgramGlobals::DirectionEnum direction;
 		bool verbose;
 		bool debug;
+		SizeType keptStates;
+		bool truncatedSvd;
+		RealType perturbation;
 	};
 
 	typedef typename BlockDiagonalMatrixType::BuildingBlockType BuildingBlockType;
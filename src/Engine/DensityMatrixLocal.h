@@ -134,13 +134,16 @@ public:
 		        (p.direction == ProgramGlobals::EXPAND_SYSTEM) ? lrs.right() :
 		                                                         lrs.left();
 
+		typename PsimagLite::Vector<BuildingBlockType>::Type blocks(pBasis.partition()-1);
 		//loop over all partitions:
 		for (SizeType m=0;m<pBasis.partition()-1;m++) {
 			// size of this partition
 			SizeType bs = pBasis.partition(m+1)-pBasis.partition(m);
 
 			// density matrix block for this partition:
-			BuildingBlockType matrixBlock(bs,bs);
+			BuildingBlockType& matrixBlock = blocks[m];
+			matrixBlock.resize(bs,bs);
+			matrixBlock.setTo(0.0);
 
 			// weight of the ground state:
 			RealType w = target.gsWeight();
@@ -163,10 +166,14 @@ public:
 				initPartition(matrixBlock,pBasis,m,target(ix),
 				              pBasisSummed,lrs.super(),p.direction,w);
 			}
-
-			// set this matrix block into data_
-			data_.setBlock(m,pBasis.partition(m),matrixBlock);
 		}
+
+		if (p.perturbation > 0) perturb(blocks,pBasis,p.direction,p.perturbation);
+
+		// set the matrix blocks into data_
+		for (SizeType m = 0; m < blocks.size(); ++m)
+			data_.setBlock(m,pBasis.partition(m),blocks[m]);
+
 		{
 			PsimagLite::OstringStream msg;
 			msg<<"Done with init partition";
@@ -222,6 +229,108 @@ private:
 
 	}
 
+	/* PSIDOC DensityMatrixPerturbation
+	With DensityMatrixPerturbation=$\alpha$ the density matrix of the
+	growing block is replaced by
+	$\rho + \alpha\sum_a (A_a\rho A_a^\dagger + A_a^\dagger\rho A_a)$,
+	normalized to the trace of $\rho$, where the $A_a$ are the operators
+	of the site just added to the block. The $A_a$ change the symmetry sector,
+	so that each block of the perturbation is a sum over the blocks of $\rho$
+	that $A_a$ connects to it.
+	*/
+	void perturb(typename PsimagLite::Vector<BuildingBlockType>::Type& blocks,
+	             const BasisWithOperatorsType& pBasis,
+	             ProgramGlobals::DirectionEnum direction,
+	             RealType alpha)
+	{
+		SizeType total = pBasis.size();
+		typename PsimagLite::Vector<SizeType>::Type partitionOf(total);
+		for (SizeType m = 0; m < blocks.size(); ++m)
+			for (SizeType i = pBasis.partition(m); i < pBasis.partition(m+1); ++i)
+				partitionOf[i] = m;
+
+		// operators of the site just added: the last site of the system,
+		// and the first site of the environ
+		SizeType sites = pBasis.block().size();
+		SizeType opsPerSite = (direction == ProgramGlobals::EXPAND_SYSTEM) ?
+		            pBasis.operatorsPerSite(sites - 1) : pBasis.operatorsPerSite(0);
+		SizeType start = (direction == ProgramGlobals::EXPAND_SYSTEM) ?
+		            pBasis.numberOfOperators() - opsPerSite : 0;
+
+		typename PsimagLite::Vector<BuildingBlockType>::Type perturbation(blocks.size());
+		for (SizeType m = 0; m < blocks.size(); ++m) {
+			perturbation[m].resize(blocks[m].rows(),blocks[m].cols());
+			perturbation[m].setTo(0.0);
+		}
+
+		SizeType counter = 0;
+		for (SizeType i = start; i < start + opsPerSite; ++i) {
+			const SparseMatrixType& a = pBasis.getOperatorByIndex(i).data;
+			if (a.rows() != total) continue;
+			SparseMatrixType aDagger;
+			transposeConjugate(aDagger,a);
+			addSandwich(perturbation,a,blocks,pBasis,partitionOf);
+			addSandwich(perturbation,aDagger,blocks,pBasis,partitionOf);
+			++counter;
+		}
+
+		RealType traceRho = 0;
+		RealType tracePerturbation = 0;
+		for (SizeType m = 0; m < blocks.size(); ++m) {
+			for (SizeType i = 0; i < blocks[m].rows(); ++i) {
+				traceRho += PsimagLite::real(blocks[m](i,i));
+				tracePerturbation += PsimagLite::real(perturbation[m](i,i));
+			}
+		}
+
+		RealType factor = traceRho + alpha*tracePerturbation;
+		if (fabs(factor) < 1e-12) return;
+		factor = traceRho/factor;
+		for (SizeType m = 0; m < blocks.size(); ++m) {
+			for (SizeType i = 0; i < blocks[m].rows(); ++i)
+				for (SizeType j = 0; j < blocks[m].cols(); ++j)
+					blocks[m](i,j) = (blocks[m](i,j) + alpha*perturbation[m](i,j))*factor;
+		}
+
+		PsimagLite::OstringStream msg;
+		msg<<"Perturbation "<<alpha<<" with "<<counter<<" operators, trace ";
+		msg<<tracePerturbation;
+		progress_.printline(msg,std::cout);
+	}
+
+	// perturbation += a rho a^\dagger, where rho is block diagonal in the
+	// partitions of pBasis, and a connects partitions
+	static void addSandwich(typename PsimagLite::Vector<BuildingBlockType>::Type& perturbation,
+	                        const SparseMatrixType& a,
+	                        const typename PsimagLite::Vector<BuildingBlockType>::Type& blocks,
+	                        const BasisWithOperatorsType& pBasis,
+	                        const typename PsimagLite::Vector<SizeType>::Type& partitionOf)
+	{
+		SizeType total = a.rows();
+		for (SizeType i = 0; i < total; ++i) {
+			if (a.getRowPtr(i) == a.getRowPtr(i + 1)) continue;
+			SizeType m = partitionOf[i];
+			SizeType offset = pBasis.partition(m);
+			SizeType end = pBasis.partition(m + 1);
+			for (SizeType j = offset; j < end; ++j) {
+				DensityMatrixElementType sum = 0;
+				for (int k = a.getRowPtr(i); k < a.getRowPtr(i + 1); ++k) {
+					SizeType col = a.getCol(k);
+					SizeType mk = partitionOf[col];
+					SizeType offsetK = pBasis.partition(mk);
+					for (int l = a.getRowPtr(j); l < a.getRowPtr(j + 1); ++l) {
+						SizeType col2 = a.getCol(l);
+						if (partitionOf[col2] != mk) continue;
+						sum += a.getValue(k)*blocks[mk](col - offsetK, col2 - offsetK)*
+						        PsimagLite::conj(a.getValue(l));
+					}
+				}
+
+				perturbation[m](i - offset, j - offset) += sum;
+			}
+		}
+	}
+
 	ProgressIndicatorType progress_;
 	BlockDiagonalMatrixType data_;
 	ProgramGlobals::DirectionEnum direction_;
@@ -76,6 +76,9 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "NoPthreads.h"
 #include "Concurrency.h"
 #include "MatrixVectorKron/GenIjPatch.h"
+#include "BLAS.h"
+#include "Random48.h"
+#include <limits>
 
 namespace Dmrg {
 
@@ -346,16 +349,32 @@ class DensityMatrixSvd : public DensityMatrixBase<TargettingType> {
 		GroupsStructType& allTargets_;
 	};
 
+	// With keptStates > 0, a block with many more rows and columns than keptStates
+	// gets only its leading keptStates singular vectors, computed with a
+	// randomized SVD (Halko, Martinsson and Tropp, SIAM Review 53, 217 (2011)).
+	// The other columns of the block are placeholders that share the weight of
+	// the block not in the kept states, and are truncated because their
+	// eigenvalues are the smallest. If the spectrum of the block is too flat
+	// for the leading vectors to be trusted, the full SVD is used instead.
 	class ParallelSvd {
 
+		static const SizeType OVERSAMPLING = 10;
+
+		static const SizeType POWER_ITERATIONS = 2;
+
 	public:
 
+		enum KindEnum {FULL, TRUNCATED, FLAT};
+
 		ParallelSvd(BlockDiagonalMatrixType& blockDiagonalMatrix,
 		            GroupsStructType& allTargets,
-		            VectorRealType& eigs)
+		            VectorRealType& eigs,
+		            SizeType keptStates)
 		    :  blockDiagonalMatrix_(blockDiagonalMatrix),
 		      allTargets_(allTargets),
-		      eigs_(eigs)
+		      eigs_(eigs),
+		      keptStates_(keptStates),
+		      kind_(allTargets.size(), FULL)
 		{
 			SizeType oneSide = allTargets.basis().size();
 			eigs_.resize(oneSide);
@@ -366,15 +385,30 @@ class DensityMatrixSvd : public DensityMatrixBase<TargettingType> {
 		{
 			SizeType igroup = allTargets_.groupFromIndex(ipatch);
 			MatrixType& m = allTargets_.matrix(igroup);
-			MatrixType vt;
 			VectorRealType eigsOnePatch;
 
-			svd('A', m, eigsOnePatch, vt);
-
 			const BasisType& basis = allTargets_.basis();
 			SizeType offset = basis.partition(igroup);
 			SizeType partSize = basis.partition(igroup + 1) - offset;
 			assert(m.rows() == partSize);
+
+			SizeType smaller = std::min(m.rows(), m.cols());
+			if (keptStates_ > 0 && 2*keptStates_ + OVERSAMPLING < smaller) {
+				MatrixType u;
+				RealType weight = 0;
+				if (truncatedSvd(u, eigsOnePatch, weight, m, igroup)) {
+					kind_[ipatch] = TRUNCATED;
+					setTruncated(u, eigsOnePatch, weight, igroup, offset, partSize);
+					return;
+				}
+
+				kind_[ipatch] = FLAT;
+			}
+
+			MatrixType vt;
+
+			svd('A', m, eigsOnePatch, vt);
+
 			assert(m.rows() == m.cols());
 			blockDiagonalMatrix_.setBlock(igroup, offset, m);
 			SizeType x = eigsOnePatch.size();
@@ -389,11 +423,206 @@ class DensityMatrixSvd : public DensityMatrixBase<TargettingType> {
 			return allTargets_.size();
 		}
 
+		SizeType count(KindEnum kind) const
+		{
+			return std::count(kind_.begin(), kind_.end(), kind);
+		}
+
 	private:
 
+		// weight is the squared norm of the block
+		void setTruncated(const MatrixType& u,
+		                  const VectorRealType& s,
+		                  RealType weight,
+		                  SizeType igroup,
+		                  SizeType offset,
+		                  SizeType partSize)
+		{
+			MatrixType block(partSize, partSize);
+			block.setTo(0.0);
+			for (SizeType j = 0; j < keptStates_; ++j)
+				for (SizeType i = 0; i < partSize; ++i)
+					block(i, j) = u(i, j);
+
+			// placeholders, truncated because their eigenvalue is the smallest
+			for (SizeType j = keptStates_; j < partSize; ++j)
+				block(j, j) = 1.0;
+
+			blockDiagonalMatrix_.setBlock(igroup, offset, block);
+
+			// strictly positive, so that placeholders are truncated first
+			assert(partSize + offset <= eigs_.size());
+			RealType kept = 0;
+			for (SizeType i = 0; i < keptStates_; ++i) {
+				eigs_[i + offset] = std::max(s[i]*s[i], std::numeric_limits<RealType>::min());
+				kept += s[i]*s[i];
+			}
+
+			// The weight not in the kept states is shared by the placeholders, so
+			// that the discarded weight of the truncation includes it. The share
+			// is at most the mean of the exact tail eigenvalues, which are not
+			// larger than the smallest kept one
+			SizeType placeholders = partSize - keptStates_;
+			RealType tail = (weight > kept) ? (weight - kept)/placeholders : 0;
+			RealType smallest = eigs_[keptStates_ - 1 + offset];
+			RealType eps = std::numeric_limits<RealType>::epsilon();
+			tail = std::min(tail, smallest*(1 - eps));
+			for (SizeType j = keptStates_; j < partSize; ++j)
+				eigs_[j + offset] = tail;
+		}
+
+		// Leading singular vectors u and values s of m, and its squared norm
+		// total; returns false if m is rank deficient or its spectrum too flat
+		bool truncatedSvd(MatrixType& u,
+		                  VectorRealType& s,
+		                  RealType& total,
+		                  const MatrixType& m,
+		                  SizeType seed) const
+		{
+			SizeType rows = m.rows();
+			SizeType cols = m.cols();
+			SizeType l = keptStates_ + OVERSAMPLING;
+			PsimagLite::Random48<RealType> rng(1234567 + seed);
+			MatrixType omega(cols, l);
+			for (SizeType j = 0; j < l; ++j)
+				for (SizeType i = 0; i < cols; ++i)
+					randomValue(omega(i, j), rng);
+
+			MatrixType y(rows, l);
+			gemm(y, 'N', m, 'N', omega);
+			if (!orthonormalize(y)) return false;
+
+			MatrixType z(cols, l);
+			for (SizeType it = 0; it < POWER_ITERATIONS; ++it) {
+				gemm(z, 'C', m, 'N', y);
+				if (!orthonormalize(z)) return false;
+				gemm(y, 'N', m, 'N', z);
+				if (!orthonormalize(y)) return false;
+			}
+
+			MatrixType b(l, cols);
+			gemm(b, 'C', y, 'N', m);
+
+			// Left singular vectors and values of b from the eigenpairs of
+			// b b^dagger, which is l times l, so that no cols times cols factor
+			// is built. Eigenvalues are ascending, singular values descending
+			MatrixType g(l, l);
+			gemm(g, 'N', b, 'C', b);
+			VectorRealType eigs;
+			diag(g, eigs, 'V');
+			assert(eigs.size() == l && l >= keptStates_);
+			MatrixType w(l, l);
+			s.resize(l);
+			for (SizeType j = 0; j < l; ++j) {
+				SizeType k = l - 1 - j;
+				s[j] = (eigs[k] > 0) ? sqrt(eigs[k]) : 0;
+				for (SizeType i = 0; i < l; ++i)
+					w(i, j) = g(i, k);
+			}
+
+			u.resize(rows, l);
+			gemm(u, 'N', y, 'N', w);
+
+			// Weight of m outside the l singular vectors found; if it's larger than
+			// the smallest kept value, a missed singular value could be larger too
+			total = 0;
+			for (SizeType j = 0; j < cols; ++j)
+				for (SizeType i = 0; i < rows; ++i)
+					total += absSquared(m(i, j));
+
+			RealType captured = 0;
+			for (SizeType i = 0; i < l; ++i)
+				captured += s[i]*s[i];
+
+			RealType tail = total - captured;
+			RealType smallest = s[keptStates_ - 1]*s[keptStates_ - 1];
+			return (tail <= smallest || tail <= 1e-14*total);
+		}
+
+		// c = op(a)*op(b), with c already sized
+		static void gemm(MatrixType& c,
+		                 char transA,
+		                 const MatrixType& a,
+		                 char transB,
+		                 const MatrixType& b)
+		{
+			int k = (transA == 'N') ? a.cols() : a.rows();
+			if (c.rows() == 0 || c.cols() == 0 || k == 0) {
+				c.setTo(0.0);
+				return;
+			}
+
+			ComplexOrRealType one = 1.0;
+			ComplexOrRealType zero = 0.0;
+			psimag::BLAS::GEMM(transA,
+			                   transB,
+			                   c.rows(),
+			                   c.cols(),
+			                   k,
+			                   one,
+			                   &(a(0,0)),
+			                   a.rows(),
+			                   &(b(0,0)),
+			                   b.rows(),
+			                   zero,
+			                   &(c(0,0)),
+			                   c.rows());
+		}
+
+		// Gram-Schmidt, twice; returns false if the columns are linearly dependent
+		static bool orthonormalize(MatrixType& a)
+		{
+			SizeType rows = a.rows();
+			SizeType cols = a.cols();
+			for (SizeType j = 0; j < cols; ++j) {
+				RealType before = columnNorm(a, j);
+				if (before == 0) return false;
+				for (SizeType pass = 0; pass < 2; ++pass) {
+					for (SizeType k = 0; k < j; ++k) {
+						ComplexOrRealType dot = 0.0;
+						for (SizeType i = 0; i < rows; ++i)
+							dot += PsimagLite::conj(a(i, k))*a(i, j);
+						for (SizeType i = 0; i < rows; ++i)
+							a(i, j) -= dot*a(i, k);
+					}
+				}
+
+				RealType after = columnNorm(a, j);
+				if (after < 1e-8*before) return false;
+				for (SizeType i = 0; i < rows; ++i)
+					a(i, j) /= after;
+			}
+
+			return true;
+		}
+
+		static RealType columnNorm(const MatrixType& a, SizeType j)
+		{
+			RealType sum = 0;
+			for (SizeType i = 0; i < a.rows(); ++i)
+				sum += absSquared(a(i, j));
+			return sqrt(sum);
+		}
+
+		static RealType absSquared(const RealType& x) { return x*x; }
+
+		static RealType absSquared(const std::complex<RealType>& x) { return std::norm(x); }
+
+		static void randomValue(RealType& x, PsimagLite::Random48<RealType>& rng)
+		{
+			x = rng() - 0.5;
+		}
+
+		static void randomValue(std::complex<RealType>& x, PsimagLite::Random48<RealType>& rng)
+		{
+			x = std::complex<RealType>(rng() - 0.5, rng() - 0.5);
+		}
+
 		BlockDiagonalMatrixType& blockDiagonalMatrix_;
 		GroupsStructType& allTargets_;
 		VectorRealType& eigs_;
+		SizeType keptStates_;
+		typename PsimagLite::Vector<KindEnum>::Type kind_;
 	};
 
 public:
@@ -467,10 +696,19 @@ public:
 		typedef PsimagLite::Parallelizer<ParallelSvd> ParallelizerType;
 		ParallelizerType threaded(PsimagLite::Concurrency::npthreads,
 		                          PsimagLite::MPI::COMM_WORLD);
+		SizeType keptStates = (params_.truncatedSvd) ? params_.keptStates : 0;
 		ParallelSvd parallelSvd(data_,
 		                        allTargets_,
-		                        eigs);
+		                        eigs,
+		                        keptStates);
 		threaded.loopCreate(parallelSvd);
+		if (keptStates > 0) {
+			PsimagLite::OstringStream msg;
+			msg<<"truncatedSvd: "<<parallelSvd.count(ParallelSvd::TRUNCATED);
+			msg<<" blocks truncated, "<<parallelSvd.count(ParallelSvd::FLAT);
+			msg<<" with flat spectrum, "<<parallelSvd.count(ParallelSvd::FULL)<<" small";
+			progress_.printline(msg,std::cout);
+		}
 		for (SizeType i = 0; i < data_.blocks(); ++i) {
 			SizeType n = data_(i).rows();
 			if (n > 0) continue;
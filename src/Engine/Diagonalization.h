@@ -82,9 +82,14 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "VectorWithOffsets.h" // includes the PsimagLite::norm functions
 #include "ProgramGlobals.h"
 #include "LanczosSolver.h"
-#include "DavidsonSolver.h"
+#include "DavidsonPreconditioned.h"
+#include "LanczosThickRestart.h"
+#include "LanczosTolerancePolicy.h"
 #include "ParametersForSolver.h"
 #include "Concurrency.h"
+#include "Parallelizer.h"
+#include "PhaseProfiler.h"
+#include "MemoryAccounting.h"
 #include "SymmetryElectronsSz.h"
 
 namespace Dmrg {
@@ -119,12 +124,75 @@ public:
 	typedef PsimagLite::LanczosOrDavidsonBase<ParametersForSolverType,
 	MatrixVectorType,
 	TargetVectorType> LanczosOrDavidsonBaseType;
-	typedef PsimagLite::DavidsonSolver<ParametersForSolverType,
+	typedef DavidsonPreconditioned<ParametersForSolverType,
 	MatrixVectorType,
 	TargetVectorType> DavidsonSolverType;
+	typedef LanczosThickRestart<ParametersForSolverType,
+	MatrixVectorType,
+	TargetVectorType> LanczosThickRestartType;
 	typedef PsimagLite::LanczosSolver<ParametersForSolverType,
 	MatrixVectorType,
 	TargetVectorType> LanczosSolverType;
+	typedef LanczosTolerancePolicy<RealType> LanczosTolerancePolicyType;
+
+	class ParallelSectors {
+
+	public:
+
+		ParallelSectors(Diagonalization& diag,
+		                const VectorSizeType& sectors,
+		                typename PsimagLite::Vector<TargetVectorType>::Type& vecSaved,
+		                VectorRealType& energySaved,
+		                const LeftRightSuperType& lrs,
+		                RealType targetTime,
+		                const typename PsimagLite::Vector<TargetVectorType>::Type&
+		                initialVectors,
+		                SizeType saveOption,
+		                const ParametersForSolverType& params)
+		    : diag_(diag),
+		      sectors_(sectors),
+		      vecSaved_(vecSaved),
+		      energySaved_(energySaved),
+		      lrs_(lrs),
+		      targetTime_(targetTime),
+		      initialVectors_(initialVectors),
+		      saveOption_(saveOption),
+		      params_(params)
+		{}
+
+		SizeType tasks() const { return sectors_.size(); }
+
+		void doTask(SizeType taskNumber, SizeType threadNum)
+		{
+			SizeType i = sectors_[taskNumber];
+			ParametersForSolverType params = params_;
+			params.threadId = threadNum;
+			diag_.diagonaliseOneBlock(i,
+			                          vecSaved_[i],
+			                          energySaved_[i],
+			                          lrs_,
+			                          targetTime_,
+			                          initialVectors_[i],
+			                          saveOption_,
+			                          params,
+			                          threadNum,
+			                          1);
+		}
+
+	private:
+
+		Diagonalization& diag_;
+		const VectorSizeType& sectors_;
+		typename PsimagLite::Vector<TargetVectorType>::Type& vecSaved_;
+		VectorRealType& energySaved_;
+		const LeftRightSuperType& lrs_;
+		RealType targetTime_;
+		const typename PsimagLite::Vector<TargetVectorType>::Type& initialVectors_;
+		SizeType saveOption_;
+		const ParametersForSolverType& params_;
+	};
+
+	friend class ParallelSectors;
 
 	Diagonalization(const ParametersType& parameters,
 	                const ModelType& model,
@@ -142,8 +210,21 @@ public:
 	      progress_("Diag."),
 	      quantumSector_(quantumSector),
 	      wft_(waveFunctionTransformation),
-	      oldEnergy_(oldEnergy)
-	{}
+	      oldEnergy_(oldEnergy),
+	      tolerancePolicy_(parameters.options.find("adaptiveLanczosTolerance") !=
+	                       PsimagLite::String::npos,
+	                       parameters.finiteLoop.size())
+	{
+		// The other matrix vector classes would do full-size products
+		if (parameters_.useReflectionSymmetry && !MatrixVectorType::reflectionSupported())
+			reflectionOperator_.switchOff("it needs SolverOptions=MatrixVectorStored");
+
+		if (parameters_.options.find("concurrentSectors") == PsimagLite::String::npos)
+			return;
+		if (!ModelHelperType::isSu2()) return;
+		PsimagLite::String str("Diagonalization: SolverOptions=concurrentSectors");
+		throw PsimagLite::RuntimeError(str + " is not supported with SU(2)\n");
+	}
 
 	//!PTEX_LABEL{Diagonalization}
 	RealType operator()(TargettingType& target,
@@ -152,12 +233,14 @@ public:
 	                    const BlockType& blockRight)
 	{
 		assert(direction == ProgramGlobals::INFINITE);
+		PhaseProfiler::Scope scope("diagonalization");
 		SizeType loopIndex = 0;
 		VectorSizeType sectors;
 		targetedSymmetrySectors(sectors,target.lrs());
 		reflectionOperator_.update(sectors);
 		RealType gsEnergy = internalMain_(target,direction,loopIndex,false,blockLeft);
 		//  targetting:
+		PhaseProfiler::Scope targetingScope("targeting");
 		target.evolve(gsEnergy,direction,blockLeft,blockRight,loopIndex);
 		wft_.triggerOff(target.lrs());
 		return gsEnergy;
@@ -170,14 +253,28 @@ public:
 	                    bool)
 	{
 		assert(direction != ProgramGlobals::INFINITE);
+		PhaseProfiler::Scope scope("diagonalization");
 
 		RealType gsEnergy = internalMain_(target,direction,loopIndex,false,block);
 		//  targetting:
+		PhaseProfiler::Scope targetingScope("targeting");
 		target.evolve(gsEnergy,direction,block,block,loopIndex);
 		wft_.triggerOff(target.lrs());
 		return gsEnergy;
 	}
 
+	// discarded weight of the last truncation
+	void truncationError(RealType error)
+	{
+		tolerancePolicy_.truncationError(error);
+	}
+
+	// called once, after the last finite loop
+	void finiteLoopsDone()
+	{
+		tolerancePolicy_.printSaved();
+	}
+
 private:
 
 	void targetedSymmetrySectors(VectorSizeType& mVector,
@@ -265,8 +362,11 @@ private:
 		        VectorWithOffsetType;
 		VectorWithOffsetType initialVector(weights,lrs.super());
 
+		PhaseProfiler::Scope wftScope("wft");
 		target.initialGuess(initialVector, block, noguess);
+		wftScope.stop();
 
+		typename PsimagLite::Vector<TargetVectorType>::Type initialVectors(total);
 		for (SizeType i=0;i<total;i++) {
 			if (weights[i]==0) continue;
 			PsimagLite::OstringStream msg;
@@ -282,7 +382,8 @@ private:
 				msg<<" and weight="<<weights[i];
 			}
 			progress_.printline(msg,std::cout);
-			TargetVectorType initialVectorBySector(weights[i]);
+			TargetVectorType& initialVectorBySector = initialVectors[i];
+			initialVectorBySector.resize(weights[i]);
 			initialVector.extract(initialVectorBySector,i);
 			RealType norma = PsimagLite::norm(initialVectorBySector);
 			if (fabs(norma)<1e-12) {
@@ -292,26 +393,27 @@ private:
 				initialVectorBySector /= norma;
 			}
 
-			if (onlyWft) {
-				vecSaved[i]=initialVectorBySector;
-				gsEnergy = oldEnergy_;
-				PsimagLite::OstringStream msg;
-				msg<<"Early exit due to user requesting (fast) WFT only, ";
-				msg<<"(non updated) energy= "<<gsEnergy;
-				progress_.printline(msg,std::cout);
-			} else {
-				diagonaliseOneBlock(i,
-				                    vecSaved[i],
-				                    gsEnergy,
-				                    lrs,
-				                    target.time(),
-				                    initialVectorBySector,
-				                    saveOption);
-			}
+			if (!onlyWft) continue;
 
-			energySaved[i]=gsEnergy;
+			vecSaved[i]=initialVectorBySector;
+			energySaved[i] = oldEnergy_;
+			PsimagLite::OstringStream msg2;
+			msg2<<"Early exit due to user requesting (fast) WFT only, ";
+			msg2<<"(non updated) energy= "<<oldEnergy_;
+			progress_.printline(msg2,std::cout);
 		}
 
+		if (!onlyWft)
+			diagonaliseSectors(vecSaved,
+			                   energySaved,
+			                   weights,
+			                   lrs,
+			                   target.time(),
+			                   initialVectors,
+			                   saveOption,
+			                   direction,
+			                   loopIndex);
+
 		// calc gs energy
 		if (verbose_ && PsimagLite::Concurrency::root())
 			std::cerr<<"About to calc gs energy\n";
@@ -325,6 +427,13 @@ private:
 		msg3<<"Ground state energy= "<<gsEnergy;
 		progress_.printline(msg3,std::cout);
 
+		if (!onlyWft) {
+			SizeType matvecs = 0;
+			for (SizeType i = 0; i < matvecs_.size(); ++i)
+				matvecs += matvecs_[i];
+			tolerancePolicy_.endStep(direction,loopIndex,gsEnergy,matvecs);
+		}
+
 		if (verbose_ && PsimagLite::Concurrency::root())
 			std::cerr<<"About to calc gs vector\n";
 
@@ -361,8 +470,113 @@ private:
 		return gsEnergy;
 	}
 
+	// Diagonalises the sectors with non-zero weight, one after the other,
+	// each using all threads for its matrix-vector products.
+	// With SolverOptions containing concurrentSectors, sectors whose cost,
+	// estimated by their size, is below the average cost per thread are
+	// instead diagonalised concurrently, one per thread, with serial
+	// matrix-vector products. The cost of a product is about the size times
+	// the number of connections, but the connections are those of the
+	// superblock and are the same for all its sectors, so the size alone
+	// gives the same choice and order. Results are stored by sector, so that
+	// the selection of the lowest energy does not depend on the schedule.
+	void diagonaliseSectors(typename PsimagLite::Vector<TargetVectorType>::Type& vecSaved,
+	                        VectorRealType& energySaved,
+	                        const VectorSizeType& weights,
+	                        const LeftRightSuperType& lrs,
+	                        RealType targetTime,
+	                        const typename PsimagLite::Vector<TargetVectorType>::Type&
+	                        initialVectors,
+	                        SizeType saveOption,
+	                        ProgramGlobals::DirectionEnum direction,
+	                        SizeType loopIndex)
+	{
+		const PsimagLite::String& options = parameters_.options;
+		ParametersForSolverType params(io_,"Lanczos");
+		tolerancePolicy_.adjust(params,direction,loopIndex);
+
+		VectorSizeType serialSectors;
+		VectorSizeType concurrentSectors;
+		SizeType total = weights.size();
+		SizeType weightsTotal = 0;
+		for (SizeType i = 0; i < total; ++i)
+			weightsTotal += weights[i];
+
+		// matrix vector products by sector
+		matvecs_.assign(total,0);
+
+		SizeType threads = PsimagLite::Concurrency::npthreads;
+		bool concurrent = (options.find("concurrentSectors") != PsimagLite::String::npos &&
+		                   threads > 1 &&
+		                   !reflectionOperator_.isEnabled() &&
+		                   options.find("KroneckerDumper") == PsimagLite::String::npos &&
+		                   options.find("debugmatrix") == PsimagLite::String::npos);
+
+		for (SizeType i = 0; i < total; ++i) {
+			if (weights[i] == 0) continue;
+			if (concurrent && weights[i]*threads < weightsTotal)
+				concurrentSectors.push_back(i);
+			else
+				serialSectors.push_back(i);
+		}
+
+		if (concurrentSectors.size() < 2) {
+			serialSectors.clear();
+			for (SizeType i = 0; i < total; ++i)
+				if (weights[i] > 0) serialSectors.push_back(i);
+			concurrentSectors.clear();
+		}
+
+		for (SizeType k = 0; k < serialSectors.size(); ++k) {
+			SizeType i = serialSectors[k];
+			diagonaliseOneBlock(i,
+			                    vecSaved[i],
+			                    energySaved[i],
+			                    lrs,
+			                    targetTime,
+			                    initialVectors[i],
+			                    saveOption,
+			                    params,
+			                    0,
+			                    threads);
+		}
+
+		SizeType n = concurrentSectors.size();
+		if (n == 0) return;
+
+		// largest sectors first
+		for (SizeType k = 1; k < n; ++k) {
+			SizeType i = concurrentSectors[k];
+			SizeType l = k;
+			for (; l > 0 && weights[concurrentSectors[l - 1]] < weights[i]; --l)
+				concurrentSectors[l] = concurrentSectors[l - 1];
+			concurrentSectors[l] = i;
+		}
+
+		PsimagLite::OstringStream msg;
+		msg<<"Diagonalizing "<<n<<" sectors concurrently";
+		progress_.printline(msg,std::cout);
+
+		threads = std::min(n, threads);
+		ParallelSectors helper(*this,
+		                       concurrentSectors,
+		                       vecSaved,
+		                       energySaved,
+		                       lrs,
+		                       targetTime,
+		                       initialVectors,
+		                       saveOption,
+		                       params);
+
+		// matrix-vector products inside each sector are serial
+		typedef PsimagLite::Parallelizer<ParallelSectors> ParallelizerType;
+		ParallelizerType parallelSectors(threads, PsimagLite::MPI::COMM_WORLD);
+		parallelSectors.loopCreate(helper);
+	}
+
 	/** Diagonalise the i-th block of the matrix, return its eigenvectors
-			in tmpVec and its eigenvalues in energyTmp
+			in tmpVec and its eigenvalues in energyTmp; threads is the number
+			of threads of its matrix-vector products
 		!PTEX_LABEL{diagonaliseOneBlock} */
 	void diagonaliseOneBlock(int i,
 	                         TargetVectorType &tmpVec,
@@ -370,10 +584,12 @@ private:
 	                         const LeftRightSuperType& lrs,
 	                         RealType targetTime,
 	                         const TargetVectorType& initialVector,
-	                         SizeType saveOption)
+	                         SizeType saveOption,
+	                         const ParametersForSolverType& params,
+	                         SizeType threadId,
+	                         SizeType threads)
 	{
 		PsimagLite::String options = parameters_.options;
-		SizeType threadId = 0;
 
 		SizeType nOfQns = model_.targetQuantum().other.size() + 1;
 		bool dumperEnabled = (options.find("KroneckerDumper") != PsimagLite::String::npos);
@@ -387,6 +603,7 @@ private:
 			paramsKrDumperPtr = &paramsKrDumper;
 
 		ModelHelperType modelHelper(i,lrs,targetTime,threadId, paramsKrDumperPtr);
+		modelHelper.threads(threads);
 
 		if (options.find("debugmatrix")!=PsimagLite::String::npos && !(saveOption & 4) ) {
 			SparseMatrixType fullm;
@@ -424,7 +641,7 @@ private:
 		PsimagLite::OstringStream msg;
 		msg<<"I will now diagonalize a matrix of size="<<modelHelper.size();
 		progress_.printline(msg,std::cout);
-		diagonaliseOneBlock(i,tmpVec,energyTmp,modelHelper,initialVector,saveOption);
+		diagonaliseOneBlock(i,tmpVec,energyTmp,modelHelper,initialVector,saveOption,params);
 	}
 
 	void diagonaliseOneBlock(int i,
@@ -432,18 +649,22 @@ private:
 	                         RealType &energyTmp,
 	                         ModelHelperType& modelHelper,
 	                         const TargetVectorType& initialVector,
-	                         SizeType saveOption)
+	                         SizeType saveOption,
+	                         const ParametersForSolverType& params)
 	{
 		int n = modelHelper.size();
 		if (verbose_)
 			std::cerr<<"Lanczos: About to do block number="<<i<<" of size="<<n<<"\n";
 
 		ReflectionSymmetryType *rs = 0;
-		if (reflectionOperator_.isEnabled()) rs = &reflectionOperator_;
+		if (reflectionOperator_.isEnabled() && (saveOption & 4) == 0)
+			rs = &reflectionOperator_;
 
+		PhaseProfiler::Scope setupScope("hamiltonianSetup");
 		typename LanczosOrDavidsonBaseType::MatrixType lanczosHelper(&model_,
 		                                                             &modelHelper,
 		                                                             rs);
+		setupScope.stop();
 
 		if ((saveOption & 4)>0) {
 			energyTmp = slowWft(lanczosHelper,tmpVec,initialVector);
@@ -453,16 +674,18 @@ private:
 			return;
 		}
 
-		ParametersForSolverType params(io_,"Lanczos");
-		LanczosOrDavidsonBaseType* lanczosOrDavidson = 0;
-
 		bool useDavidson = (parameters_.options.find("useDavidson") !=
 		        PsimagLite::String::npos);
-		if (useDavidson) {
-			lanczosOrDavidson = new DavidsonSolverType(lanczosHelper,params);
-		} else {
-			lanczosOrDavidson = new LanczosSolverType(lanczosHelper,params);
-		}
+		bool useThickRestart = (parameters_.options.find("useThickRestart") !=
+		        PsimagLite::String::npos);
+
+		// Lanczos vectors, if kept, and the initial and output vectors
+		SizeType vectors = (params.lotaMemory) ? params.steps + 2 : 5;
+		if (useThickRestart)
+			vectors = LanczosThickRestartType::peakVectors(parameters_.thickRestartVectors,
+			                                               parameters_.excited);
+		MemoryAccounting::peak("lanczos",
+		                       vectors*lanczosHelper.rows()*sizeof(ComplexOrRealType));
 
 		if (lanczosHelper.rows()==0) {
 			energyTmp=10000;
@@ -470,14 +693,37 @@ private:
 			msg<<"Early exit due to matrix rank being zero.";
 			msg<<" BOGUS energy= "<<energyTmp;
 			progress_.printline(msg,std::cout);
-			if (lanczosOrDavidson) delete lanczosOrDavidson;
 			return;
 		}
 
-		if (!reflectionOperator_.isEnabled()) {
+		if (useDavidson) {
+			DavidsonSolverType davidson(lanczosHelper,params);
+			solveOneBlock(davidson,lanczosHelper,tmpVec,energyTmp,initialVector,rs);
+		} else if (useThickRestart) {
+			LanczosThickRestartType lanczos(lanczosHelper,
+			                                params,
+			                                parameters_.thickRestartVectors);
+			solveOneBlock(lanczos,lanczosHelper,tmpVec,energyTmp,initialVector,rs);
+		} else {
+			LanczosSolverType lanczos(lanczosHelper,params);
+			solveOneBlock(lanczos,lanczosHelper,tmpVec,energyTmp,initialVector,rs);
+		}
+
+		matvecs_[i] = lanczosHelper.matvecs();
+	}
+
+	template<typename SolverType>
+	void solveOneBlock(SolverType& solver,
+	                   typename LanczosOrDavidsonBaseType::MatrixType& lanczosHelper,
+	                   TargetVectorType &tmpVec,
+	                   RealType &energyTmp,
+	                   const TargetVectorType& initialVector,
+	                   ReflectionSymmetryType* rs)
+	{
+		if (!rs) {
 			tmpVec.resize(lanczosHelper.rows());
 			try {
-				energyTmp = computeLevel(*lanczosOrDavidson,tmpVec,initialVector);
+				energyTmp = computeLevel(solver,tmpVec,initialVector);
 			} catch (std::exception& e) {
 				PsimagLite::OstringStream msg0;
 				msg0<<e.what()<<"\n";
@@ -497,38 +743,37 @@ private:
 				progress_.printline(msg1,std::cout);
 			}
 
-			if (lanczosOrDavidson) delete lanczosOrDavidson;
 			return;
 		}
 
 		TargetVectorType initialVector1,initialVector2;
 		reflectionOperator_.setInitState(initialVector,initialVector1,initialVector2);
 		tmpVec.resize(initialVector1.size());
-		energyTmp = computeLevel(*lanczosOrDavidson,tmpVec,initialVector1);
+		energyTmp = computeLevel(solver,tmpVec,initialVector1);
 
 		RealType gsEnergy1 = energyTmp;
 		TargetVectorType gsVector1 = tmpVec;
 
 		lanczosHelper.reflectionSector(1);
 		TargetVectorType gsVector2(initialVector2.size());
-		RealType gsEnergy2 = computeLevel(*lanczosOrDavidson,gsVector2,initialVector2);
+		RealType gsEnergy2 = computeLevel(solver,gsVector2,initialVector2);
 
 		energyTmp=reflectionOperator_.setGroundState(tmpVec,
 		                                             gsEnergy1,
 		                                             gsVector1,
 		                                             gsEnergy2,
 		                                             gsVector2);
-
-		if (lanczosOrDavidson) delete lanczosOrDavidson;
 	}
 
-	RealType computeLevel(LanczosOrDavidsonBaseType& object,
+	template<typename SolverType>
+	RealType computeLevel(SolverType& object,
 	                      TargetVectorType &gsVector,
 	                      const TargetVectorType &initialVector) const
 	{
 		SizeType excited = parameters_.excited;
 		RealType norma = PsimagLite::norm(initialVector);
 		RealType gsEnergy = 0;
+		PhaseProfiler::Scope scope("solver");
 		if (fabs(norma)<1e-12) {
 			PsimagLite::OstringStream msg;
 			msg<<"WARNING: diagonaliseOneBlock: Norm of guess vector is zero, ";
@@ -595,6 +840,8 @@ private:
 	const SizeType& quantumSector_;
 	WaveFunctionTransfType& wft_;
 	RealType oldEnergy_;
+	LanczosTolerancePolicyType tolerancePolicy_;
+	VectorSizeType matvecs_;
 }; // class Diagonalization
 } // namespace Dmrg
 
@@ -110,7 +110,8 @@ public:
 
 		int x = 0;
 		ioIn_.readline(x,"#STACKMETARANK=",IoInType::LAST_INSTANCE);
-		ioIn_.read(stack_, "#STACKMETASTACK");
+		// recovery stacks are appended to, and their last index is the valid one
+		ioIn_.read(stack_, "#STACKMETASTACK", IoInType::LAST_INSTANCE);
 		ioIn_.close();
 		PsimagLite::OstringStream msg;
 		msg<<"Attempt to read from file " + fileIn_ + " succeeded";
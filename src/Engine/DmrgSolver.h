@@ -88,6 +88,7 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "Recovery.h"
 #include "Truncation.h"
 #include "ObservablesInSitu.h"
+#include "ObservablesInSweep.h"
 #include "TargetingGroundState.h"
 #include "TargetingTimeStep.h"
 #include "TargetingDynamic.h"
@@ -102,6 +103,9 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "PsiBase64.h"
 #include "PrinterInDetail.h"
 #include "IoSelector.h"
+#include "PhaseProfiler.h"
+#include "MemoryAccounting.h"
+#include "StepArena.h"
 
 namespace Dmrg {
 
@@ -158,6 +162,7 @@ public:
 	typedef TargetingRixsStatic<LanczosSolverType,VectorWithOffsetType> TargetingRixsStaticType;
 	typedef TargetingRixsDynamic<LanczosSolverType,VectorWithOffsetType> TargetingRixsDynamicType;
 	typedef PrinterInDetail<LeftRightSuperType> PrinterInDetailType;
+	typedef ObservablesInSweep<LeftRightSuperType,ModelType> ObservablesInSweepType;
 	typedef typename DiagonalizationType::BasisWithOperatorsType BasisWithOperatorsType;
 	typedef typename BasisWithOperatorsType::BlockDiagonalMatrixType BlockDiagonalMatrixType;
 
@@ -194,6 +199,7 @@ public:
 	                parameters_,
 	                model.geometry().maxConnections(),
 	                verbose_),
+	      inSweep_(model, parameters_.inSweepObservables),
 	      energy_(0.0),
 	      saveData_(parameters_.options.find("noSaveData") == PsimagLite::String::npos)
 	{
@@ -210,10 +216,15 @@ public:
 		ioOut_.print("PARAMETERS\n", parameters_);
 		ioOut_.print(model);
 		if (parameters_.options.find("verbose")!=PsimagLite::String::npos) verbose_=true;
+
+		PhaseProfiler::init(parameters_.profiler,
+		                    utils::pathPrepend("Profile",parameters_.filename));
 	}
 
 	~DmrgSolver()
 	{
+		PhaseProfiler::finalize();
+
 		ioOut_.printline(appInfo_.finalize());
 
 		PsimagLite::OstringStream msg2;
@@ -288,6 +299,8 @@ public:
 
 		inSitu_.init(*psi,geometry.numberOfSites());
 
+		printInSweep();
+
 		delete psi;
 		psi = 0;
 	}
@@ -368,6 +381,7 @@ private:
 			progress_.printline(msg,std::cout);
 			printerInDetail.print(std::cout, "infinite");
 
+			PhaseProfiler::Scope growthScope("growth");
 			lrs_.growLeftBlock(model_,pS,X[step],time); // grow system
 			bool needsRightPush = false;
 			if (step < Y.size()) {
@@ -375,6 +389,8 @@ private:
 				needsRightPush = true;
 			}
 
+			growthScope.stop();
+
 			progress_.print("Growth done.\n",std::cout);
 			lrs_.printSizes("Infinite",std::cout);
 
@@ -386,8 +402,12 @@ private:
 			energy_ = diagonalization_(psi,ProgramGlobals::INFINITE,X[step],ystep);
 			printEnergy(energy_);
 
+			PhaseProfiler::Scope truncationScope("truncation");
 			truncate_.changeBasis(pS,pE,psi,parameters_.keptStatesInfinite);
+			truncationScope.stop();
+			diagonalization_.truncationError(truncate_.error());
 
+			PhaseProfiler::Scope checkpointScope("checkpoint");
 			if (needsRightPush) {
 				if (!twoSiteDmrg) checkpoint_.push(pS,pE);
 				else checkpoint_.push(lrs_.left(),lrs_.right());
@@ -396,8 +416,13 @@ private:
 				                 ProgramGlobals::SYSTEM);
 			}
 
+			checkpointScope.stop();
+			StepArenas::reset();
+			accountMemory();
 			progress_.printMemoryUsage();
 		}
+
+		PhaseProfiler::infinite();
 		progress_.print("Infinite dmrg loop has been done!\n",std::cout);
 	}
 
@@ -455,6 +480,9 @@ private:
 		}
 
 		stepCurrent_ = sc; // phew!!, that's all folks, now bugs, go away!!
+
+		if (inSweep_.enabled() && parameters_.finiteLoop.back().stepLength < 0)
+			err("InSweepObservables= needs a last finite loop going to the right\n");
 		int lastSign = 1;
 
 		for (SizeType i=0;i<parameters_.finiteLoop.size();i++)  {
@@ -476,10 +504,19 @@ private:
 			}
 
 			finiteStep(S,E,pS,pE,i,psi);
-			if (psi.end()) break;
+			if (psi.end()) {
+				PhaseProfiler::sweep(i);
+				break;
+			}
+
+			PhaseProfiler::Scope recoveryScope("recovery");
 			recovery.save(psi,sitesIndices_[stepCurrent_],lastSign,false);
+			recoveryScope.stop();
+			PhaseProfiler::sweep(i);
 		}
 
+		diagonalization_.finiteLoopsDone();
+
 		if (!saveData_) return;
 		checkpoint_.save(pS,pE,ioOut_);
 		psi.save(sitesIndices_[stepCurrent_],ioOut_);
@@ -518,8 +555,10 @@ private:
 			if (SizeType(stepCurrent_)>=sitesIndices_.size())
 				throw PsimagLite::RuntimeError("stepCurrent_ too large!\n");
 
+			PhaseProfiler::Scope stepScope("step");
 			RealType time = target.time();
 			printerInDetail.print(std::cout, "finite");
+			PhaseProfiler::Scope growthScope("growth");
 			if (direction == ProgramGlobals::EXPAND_SYSTEM) {
 				lrs_.growLeftBlock(model_,pS,sitesIndices_[stepCurrent_],time);
 				lrs_.right(checkpoint_.shrink(ProgramGlobals::ENVIRON,target));
@@ -528,6 +567,8 @@ private:
 				lrs_.left(checkpoint_.shrink(ProgramGlobals::SYSTEM,target));
 			}
 
+			growthScope.stop();
+
 			lrs_.printSizes("finite",std::cout);
 			if (verbose_) {
 				PsimagLite::OstringStream msg;
@@ -552,6 +593,18 @@ private:
 			printEnergy(energy_);
 
 			changeTruncateAndSerialize(pS,pE,target,keptStates,direction,saveOption);
+			diagonalization_.truncationError(truncate_.error());
+			if (loopIndex + 1 == parameters_.finiteLoop.size())
+				measureInSweep(target);
+			StepArenas::reset();
+			accountMemory();
+
+			stepScope.stop();
+			PhaseProfiler::step(loopIndex,
+			                    stepCurrent_,
+			                    sitesIndices_[stepCurrent_][0],
+			                    (direction == ProgramGlobals::EXPAND_SYSTEM) ?
+			                        "EXPAND_SYSTEM" : "EXPAND_ENVIRON");
 
 			if (finalStep(stepLength,stepFinal)) break;
 			if (stepCurrent_<0) {
@@ -591,16 +644,21 @@ private:
 		const VectorSizeType& eE = pS.electronsVector(BasisWithOperatorsType::AFTER_TRANSFORM);
 		FermionSignType fsE(eE);
 
+		PhaseProfiler::Scope truncationScope("truncation");
 		truncate_(pS,pE,target,keptStates,direction);
+		truncationScope.stop();
 		PsimagLite::OstringStream msg2;
 		msg2<<"#Error="<<truncate_.error();
 		if (saveData_) ioOut_.printline(msg2);
 
+		PhaseProfiler::Scope checkpointScope("checkpoint");
 		if (direction == ProgramGlobals::EXPAND_SYSTEM)
 			checkpoint_.push((twoSiteDmrg) ? lrs_.left() : pS, ProgramGlobals::SYSTEM);
 		else
 			checkpoint_.push((twoSiteDmrg) ? lrs_.right() : pE, ProgramGlobals::ENVIRON);
+		checkpointScope.stop();
 
+		PhaseProfiler::Scope serializeScope("serialize");
 		serialize(fsS,fsE,target,direction,saveOption);
 	}
 
@@ -623,6 +681,57 @@ private:
 		target.save(sitesIndices_[stepCurrent_],ioOut_);
 	}
 
+	void measureInSweep(const TargettingType& target)
+	{
+		if (!inSweep_.enabled()) return;
+
+		PhaseProfiler::Scope inSweepScope("inSweep");
+		SparseMatrixType transform;
+		truncate_.transform(ProgramGlobals::EXPAND_SYSTEM).toSparse(transform);
+		inSweep_.measure(lrs_, target.gs(), transform);
+	}
+
+	void printInSweep()
+	{
+		if (!inSweep_.enabled()) return;
+
+		PsimagLite::OstringStream msg;
+		msg.precision(parameters_.precision);
+		inSweep_.print(msg);
+		std::cout<<msg.str();
+		if (saveData_) ioOut_.print(msg.str());
+	}
+
+	// Prints the bytes held by the main structures, and moves stack
+	// entries to disk if the MemoryBudget is approached
+	void accountMemory()
+	{
+		MemoryAccounting accounting(parameters_.memoryBudget);
+		accounting.add("stackS",
+		               checkpoint_.memoryStack(ProgramGlobals::SYSTEM).memoryUsage());
+		accounting.add("stackE",
+		               checkpoint_.memoryStack(ProgramGlobals::ENVIRON).memoryUsage());
+		accounting.add("left", lrs_.left().memoryUsage());
+		accounting.add("right", lrs_.right().memoryUsage());
+		accounting.add("wft", wft_.memoryUsage());
+		accounting.addPeaks();
+
+		PsimagLite::OstringStream msg;
+		msg<<accounting.toString();
+		SizeType excess = accounting.excess();
+		if (excess > 0) {
+			SizeType freed = checkpoint_.spillStacks(excess);
+			msg<<" movedToDisk="<<MemoryAccounting::toMb(freed);
+			if (freed < excess)
+				msg<<" (cannot move more, budget exceeded)";
+		}
+
+		SizeType spilled = checkpoint_.memoryStack(ProgramGlobals::SYSTEM).spilledBytes() +
+		        checkpoint_.memoryStack(ProgramGlobals::ENVIRON).spilledBytes();
+		if (spilled > 0) msg<<" stacksInDisk="<<MemoryAccounting::toMb(spilled);
+		progress_.printline(msg,std::cout);
+	}
+
 	bool finalStep(int stepLength,int stepFinal)
 	{
 		if (stepLength<0) {
@@ -709,6 +818,7 @@ private:
 	DiagonalizationType diagonalization_;
 	TruncationType truncate_;
 	ObservablesInSituType inSitu_;
+	ObservablesInSweepType inSweep_;
 	RealType energy_;
 	bool saveData_;
 }; //class DmrgSolver
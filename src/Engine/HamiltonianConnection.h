@@ -82,6 +82,7 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "Concurrency.h"
 #include <cassert>
 #include "ProgramGlobals.h"
+#include "StepArena.h"
 
 namespace Dmrg {
 
@@ -100,6 +101,7 @@ public:
 	typedef typename PsimagLite::Vector<SparseElementType>::Type VectorType;
 	typedef typename PsimagLite::Vector<VectorType>::Type VectorVectorType;
 	typedef typename PsimagLite::Concurrency ConcurrencyType;
+	typedef StepArena<VectorType> StepArenaType;
 
 	HamiltonianConnection(const GeometryType& geometry,
 	                      const ModelHelperType& modelHelper,
@@ -113,10 +115,16 @@ public:
 	      envBlock_(modelHelper.leftRightSuper().right().block()),
 	      smax_(*std::max_element(systemBlock_.begin(),systemBlock_.end())),
 	      emin_(*std::min_element(envBlock_.begin(),envBlock_.end())),
-	      xtemp_(ConcurrencyType::storageSize(ConcurrencyType::npthreads)),
+	      xtemp_(ConcurrencyType::storageSize(modelHelper.threads())),
 	      total_(0)
 	{}
 
+	~HamiltonianConnection()
+	{
+		for (SizeType threadNum = 0; threadNum < xtemp_.size(); threadNum++)
+			StepArenaType::give(xtemp_[threadNum],threadNum);
+	}
+
 	bool compute(SizeType i,
 	             SizeType j,
 	             SparseMatrixType* matrixBlock,
@@ -181,7 +189,7 @@ public:
 	void doTask(SizeType taskNumber ,SizeType threadNum)
 	{
 		if (xtemp_[threadNum].size() != x_.size())
-			xtemp_[threadNum].resize(x_.size(),0.0);
+			StepArenaType::take(xtemp_[threadNum],x_.size(),threadNum);
 
 		SparseElementType tmp = 0.0;
 
@@ -218,7 +226,8 @@ public:
 		for (SizeType threadNum = 0; threadNum < xtemp_.size(); threadNum++)
 			if (xtemp_[threadNum].size() == x_.size()) total++;
 
-		typename PsimagLite::Vector<SparseElementType>::Type x(x_.size(),0);
+		VectorType x;
+		StepArenaType::take(x,x_.size());
 		for (SizeType threadNum = 0; threadNum < total; threadNum++)
 			for (SizeType i=0;i<x_.size();i++)
 				x[i]+=xtemp_[threadNum][i];
@@ -228,6 +237,8 @@ public:
 
 		for (SizeType i=0;i<x_.size();i++)
 			x_[i] += x[i];
+
+		StepArenaType::give(x);
 	}
 
 	void prepare(SizeType ix,
@@ -152,6 +152,7 @@ public:
 		knownLabels_.push_back("TSPRngSeed");
 		knownLabels_.push_back("TSPOperatorMultiplier");
 		knownLabels_.push_back("MettsCollapse");
+		knownLabels_.push_back("MettsChains");
 		knownLabels_.push_back("HeisenbergTwiceS");
 		knownLabels_.push_back("TargetElectronsTotal");
 		knownLabels_.push_back("TargetSzPlusConst");
@@ -196,6 +197,12 @@ public:
 		knownLabels_.push_back("LanczosNoSaveLanczosVectors");
 		knownLabels_.push_back("DenseSparseThreshold");
 		knownLabels_.push_back("TridiagonalEps");
+		knownLabels_.push_back("Profiler");
+		knownLabels_.push_back("MemoryBudget");
+		knownLabels_.push_back("InSweepObservables");
+		knownLabels_.push_back("UseReflectionSymmetry");
+		knownLabels_.push_back("DensityMatrixPerturbation");
+		knownLabels_.push_back("ThickRestartVectors");
 	}
 
 	~InputCheck()
@@ -294,7 +301,13 @@ public:
 			superblock
 			\item[exactdiag] Do exact diagonalization with LAPACK instead of Lanczos
 			\item[nodmrgtransform] Do not DMRG transform bases
-			\item[useDavidson] Use Davidson instead of Lanczos
+			\item[useDavidson] Use Davidson, preconditioned with the diagonal of the
+			superblock Hamiltonian, instead of Lanczos
+			\item[useThickRestart] Use thick-restart Lanczos, with at most
+			ThickRestartVectors Lanczos vectors, instead of Lanczos
+			\item[adaptiveLanczosTolerance] Loosen the tolerance and the maximum
+			number of steps of the solver in finite loops but the last one,
+			following the discarded weight and the change of the energy
 			\item[verbose] Enable verbose output
 			\item[nowft] Disable the Wave Function Transformation (WFT)
 			\item[useComplex] TBW
@@ -328,6 +341,10 @@ public:
 			\item [KroneckerDumper] TBW
 			\item [extendedPrint] TBW
 			\item [useSvd] TBW
+			\item [truncatedSvd] Only meaningful with useSvd. Computes only the leading
+							   singular vectors of each large symmetry block,
+							   with a randomized SVD, falling back to the full SVD
+							   of the block if its spectrum is too flat
 			\item [KronNoLoadBalance] Disable load balancing for MatrixVectorKron
 			\item [setAffinities] TBW
 			\item [wftInPatches] WFT calculation will be done using symmetry patches
@@ -335,10 +352,18 @@ public:
 							   instead of to and from memory
 			\item [wftInBlocks] Accelerate the WFT by using dense blocks
 			\item [wftStacksInDisk] Save and load stacks for WFT to and from disk,
-							   instead of to and from memory. Cannot be used with restart yet.
+							   instead of to and from memory. With restart, the stacks
+							   are reopened from the WftSystemStack and WftEnvironStack
+							   files of the previous run, which must itself have used
+							   wftStacksInDisk.
 			\item [BatchedGemm] Only meaningful with MatrixVectorKron. Enables
 			                    batched gemm and might need plugin sc
 			\item [KrylovAbridge] TBW
+			\item [concurrentSectors] Diagonalize small symmetry sectors concurrently,
+			                          one per thread, instead of one after the other.
+			                          Useful with findSymmetrySector or with SU(2).
+			                          Ignored with reflection symmetry, KroneckerDumper
+			                          or debugmatrix
 		\end{itemize}
 		*/
 	void check(const PsimagLite::String& label,
@@ -354,6 +379,8 @@ public:
 		registerOpts.push_back("exactdiag");
 		registerOpts.push_back("nodmrgtransform");
 		registerOpts.push_back("useDavidson");
+		registerOpts.push_back("useThickRestart");
+		registerOpts.push_back("adaptiveLanczosTolerance");
 		registerOpts.push_back("verbose");
 		registerOpts.push_back("nofiniteloops");
 		registerOpts.push_back("nowft");
@@ -395,6 +422,7 @@ public:
 		registerOpts.push_back("doNotCheckTwoSiteDmrg");
 		registerOpts.push_back("extendedPrint");
 		registerOpts.push_back("useSvd");
+		registerOpts.push_back("truncatedSvd");
 		registerOpts.push_back("KronNoLoadBalance");
 		registerOpts.push_back("setAffinities");
 		registerOpts.push_back("wftInPatches");
@@ -404,6 +432,7 @@ public:
 		registerOpts.push_back("wftStacksInDisk");
 		registerOpts.push_back("BatchedGemm");
 		registerOpts.push_back("KrylovAbridge");
+		registerOpts.push_back("concurrentSectors");
 
 		PsimagLite::Options::Writeable optWriteable(registerOpts,
 		                                            PsimagLite::Options::Writeable::PERMISSIVE);
@@ -0,0 +1,309 @@
+#ifndef DMRG_LANCZOS_THICK_RESTART_H
+#define DMRG_LANCZOS_THICK_RESTART_H
+#include <algorithm>
+#include <cmath>
+#include "Matrix.h"
+#include "Random48.h"
+#include "ProgressIndicator.h"
+
+namespace Dmrg {
+
+// Thick-restart Lanczos with at most maxVectors stored Lanczos vectors
+//
+// The lowest excited+1 eigenpairs are found in one Krylov run. When the
+// basis is full, it is restarted with the lowest Ritz vectors, built in place
+// of the Lanczos vectors, and with the last Lanczos vector. The projected
+// matrix is then an arrowhead followed by a tridiagonal matrix.
+// The residual of the Ritz pair i is |beta y(last, i)|, and the pairs are
+// converged when |r|^2 < tolerance, as the error in the energy goes as |r|^2.
+// At each restart the lowest converged pairs are locked: they stay at the
+// front of the basis, out of the projected matrix, and H is not applied to
+// them again. Lanczos vectors are fully reorthogonalized, against the locked
+// vectors too.
+template<typename ParametersForSolverType, typename MatrixType, typename VectorType>
+class LanczosThickRestart {
+
+	typedef typename VectorType::value_type ComplexOrRealType;
+	typedef typename PsimagLite::Real<ComplexOrRealType>::Type RealType;
+	typedef typename PsimagLite::Vector<RealType>::Type VectorRealType;
+	typedef typename PsimagLite::Vector<VectorType>::Type VectorVectorType;
+	typedef PsimagLite::Matrix<ComplexOrRealType> DenseMatrixType;
+
+	static const SizeType MIN_EXTRA_VECTORS = 4;
+
+public:
+
+	LanczosThickRestart(MatrixType& mat,
+	                    const ParametersForSolverType& params,
+	                    SizeType maxVectors)
+	    : mat_(mat),
+	      params_(params),
+	      maxVectors_(maxVectors),
+	      progress_("LanczosThickRestart"),
+	      rng_(3433117),
+	      steps_(0)
+	{}
+
+	void computeExcitedState(RealType& energy, VectorType& z, SizeType excited)
+	{
+		SizeType n = mat_.rows();
+		VectorType initialVector(n);
+		for (SizeType i = 0; i < n; ++i)
+			initialVector[i] = rng_() - 0.5;
+
+		computeExcitedState(energy, z, initialVector, excited);
+	}
+
+	void computeExcitedState(RealType& energy,
+	                         VectorType& z,
+	                         const VectorType& initialVector,
+	                         SizeType excited)
+	{
+		SizeType n = mat_.rows();
+		SizeType nev = excited + 1;
+		if (nev > n)
+			err("LanczosThickRestart: excited state beyond matrix rank\n");
+
+		SizeType m = std::min(n, std::max(maxVectors_, nev + MIN_EXTRA_VECTORS));
+		SizeType maxSteps = params_.steps*nev + m;
+
+		VectorVectorType v(1, initialVector);
+		if (!normalize(v[0])) addRandom(v[0], VectorVectorType());
+
+		VectorRealType alpha(m, 0.0);
+		VectorRealType beta(m, 0.0);
+		VectorRealType thetaKept;
+		VectorType coupling;
+		SizeType locked = 0;
+		SizeType kept = 0;
+		VectorRealType eigs;
+		DenseMatrixType t;
+		SizeType restarts = 0;
+		steps_ = 0;
+
+		while (true) {
+			SizeType built = expand(v, alpha, beta, locked, kept, coupling, m);
+			SizeType active = built - locked;
+
+			// projected matrix of the vectors not locked:
+			// arrowhead for the kept Ritz pairs, then tridiagonal
+			t.resize(active, active);
+			for (SizeType i = 0; i < active; ++i)
+				for (SizeType j = 0; j < active; ++j)
+					t(i, j) = 0.0;
+
+			for (SizeType i = 0; i < kept; ++i) {
+				t(i, i) = thetaKept[i];
+				t(kept, i) = coupling[i];
+				t(i, kept) = PsimagLite::conj(coupling[i]);
+			}
+
+			for (SizeType j = kept; j < active; ++j) {
+				t(j, j) = alpha[locked + j];
+				if (j + 1 < active) t(j, j + 1) = t(j + 1, j) = beta[locked + j];
+			}
+
+			eigs.resize(active);
+			diag(t, eigs, 'V');
+
+			// of the wanted pairs not locked yet, the lowest newLocked are converged
+			SizeType wanted = nev - locked;
+			SizeType newLocked = 0;
+			RealType residual = 0.0;
+			for (SizeType i = 0; i < wanted; ++i) {
+				RealType r = beta[built - 1]*std::abs(t(active - 1, i));
+				if (newLocked == i && r*r < params_.tolerance) ++newLocked;
+				residual = std::max(residual, r);
+			}
+
+			bool exact = (built == n);
+			bool converged = (exact || newLocked == wanted);
+			if (converged || steps_ >= maxSteps) {
+				// fewer than nev pairs are locked, so that excited is not
+				ritz(z, v, t, excited - locked, locked, active);
+				energy = eigs[excited - locked];
+				PsimagLite::OstringStream msg;
+				if (converged)
+					msg<<"Converged after "<<steps_<<" matrix vector products and ";
+				else
+					msg<<"WARNING: Not converged after "<<steps_<<" matrix vector products and ";
+				msg<<restarts<<" restarts, with "<<m<<" vectors, "<<locked<<" locked, ";
+				msg<<"residual "<<residual;
+				progress_.printline(msg, std::cout);
+				return;
+			}
+
+			// lock the newLocked pairs, keep the next lowest Ritz pairs, up to
+			// at least the wanted ones, and keep the last Lanczos vector
+			SizeType keptNew = std::min(active - 1, wanted + (m - locked - wanted)/2);
+			ritzInPlace(v, t, keptNew, locked, active);
+			kept = keptNew - newLocked;
+			thetaKept.resize(kept);
+			coupling.resize(kept);
+			for (SizeType i = 0; i < kept; ++i) {
+				thetaKept[i] = eigs[newLocked + i];
+				coupling[i] = beta[built - 1]*t(active - 1, newLocked + i);
+			}
+
+			v[locked + keptNew].swap(v[built]);
+			v.resize(locked + keptNew + 1);
+			locked += newLocked;
+			++restarts;
+		}
+	}
+
+	SizeType steps() const { return steps_; }
+
+	// Vectors of the rank of the matrix held at the same time, including the
+	// initial and output vectors of the caller
+	static SizeType peakVectors(SizeType maxVectors, SizeType excited)
+	{
+		return std::max(maxVectors, excited + 1 + MIN_EXTRA_VECTORS) + 3;
+	}
+
+private:
+
+	// Lanczos steps from locked + kept up to m, or up to an exhausted space;
+	// returns the number of vectors, the locked ones included, in the basis.
+	// On return v has one more vector than that, unless the space is exhausted
+	SizeType expand(VectorVectorType& v,
+	                VectorRealType& alpha,
+	                VectorRealType& beta,
+	                SizeType locked,
+	                SizeType kept,
+	                const VectorType& coupling,
+	                SizeType m)
+	{
+		SizeType n = v[0].size();
+		SizeType start = locked + kept;
+		for (SizeType j = start; j < m; ++j) {
+			VectorType w(n, 0.0);
+			mat_.matrixVectorProduct(w, v[j]);
+			++steps_;
+
+			if (j == start) {
+				for (SizeType i = 0; i < kept; ++i)
+					axpy(w, -PsimagLite::conj(coupling[i]), v[locked + i]);
+			} else {
+				axpy(w, -beta[j - 1], v[j - 1]);
+			}
+
+			alpha[j] = PsimagLite::real(dot(v[j], w));
+			axpy(w, -alpha[j], v[j]);
+
+			for (SizeType pass = 0; pass < 2; ++pass)
+				for (SizeType i = 0; i <= j; ++i)
+					axpy(w, -dot(v[i], w), v[i]);
+
+			if (j + 1 == n) return n;
+
+			beta[j] = norm(w);
+			if (beta[j] < 1e-12) {
+				// invariant subspace: continue with a vector orthogonal to it
+				beta[j] = 0.0;
+				if (!addRandom(w, v)) return j + 1;
+			} else {
+				scale(w, 1.0/beta[j]);
+			}
+
+			v.push_back(w);
+		}
+
+		return m;
+	}
+
+	// x = sum_k basis[offset + k] y(k, col) for k < active
+	static void ritz(VectorType& x,
+	                 const VectorVectorType& basis,
+	                 const DenseMatrixType& y,
+	                 SizeType col,
+	                 SizeType offset,
+	                 SizeType active)
+	{
+		SizeType n = basis[0].size();
+		x.resize(n);
+		for (SizeType i = 0; i < n; ++i)
+			x[i] = 0.0;
+
+		for (SizeType k = 0; k < active; ++k)
+			axpy(x, y(k, col), basis[offset + k]);
+	}
+
+	// v[offset + i] = sum_k v[offset + k] y(k, i) for i < count and k < active,
+	// row by row, so that only count scalars are needed besides the Lanczos vectors
+	static void ritzInPlace(VectorVectorType& v,
+	                        const DenseMatrixType& y,
+	                        SizeType count,
+	                        SizeType offset,
+	                        SizeType active)
+	{
+		SizeType n = v[0].size();
+		VectorType row(count);
+		for (SizeType r = 0; r < n; ++r) {
+			for (SizeType i = 0; i < count; ++i) {
+				ComplexOrRealType sum = 0.0;
+				for (SizeType k = 0; k < active; ++k)
+					sum += v[offset + k][r]*y(k, i);
+				row[i] = sum;
+			}
+
+			for (SizeType i = 0; i < count; ++i)
+				v[offset + i][r] = row[i];
+		}
+	}
+
+	bool addRandom(VectorType& t, const VectorVectorType& v)
+	{
+		for (SizeType i = 0; i < t.size(); ++i)
+			t[i] = rng_() - 0.5;
+
+		for (SizeType pass = 0; pass < 2; ++pass)
+			for (SizeType k = 0; k < v.size(); ++k)
+				axpy(t, -dot(v[k], t), v[k]);
+
+		return normalize(t);
+	}
+
+	static bool normalize(VectorType& t)
+	{
+		RealType tnorm = norm(t);
+		if (tnorm < 1e-12) return false;
+		scale(t, 1.0/tnorm);
+		return true;
+	}
+
+	static void axpy(VectorType& y, ComplexOrRealType a, const VectorType& x)
+	{
+		for (SizeType i = 0; i < y.size(); ++i)
+			y[i] += a*x[i];
+	}
+
+	static void scale(VectorType& y, RealType a)
+	{
+		for (SizeType i = 0; i < y.size(); ++i)
+			y[i] *= a;
+	}
+
+	static ComplexOrRealType dot(const VectorType& a, const VectorType& b)
+	{
+		ComplexOrRealType sum = 0.0;
+		for (SizeType i = 0; i < a.size(); ++i)
+			sum += PsimagLite::conj(a[i])*b[i];
+		return sum;
+	}
+
+	static RealType norm(const VectorType& a)
+	{
+		return sqrt(PsimagLite::real(dot(a, a)));
+	}
+
+	MatrixType& mat_;
+	const ParametersForSolverType& params_;
+	SizeType maxVectors_;
+	PsimagLite::ProgressIndicator progress_;
+	PsimagLite::Random48<RealType> rng_;
+	SizeType steps_;
+}; // class LanczosThickRestart
+} // namespace Dmrg
+
+#endif // DMRG_LANCZOS_THICK_RESTART_H
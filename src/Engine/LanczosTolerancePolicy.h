@@ -0,0 +1,149 @@
+#ifndef DMRG_LANCZOS_TOLERANCE_POLICY_H
+#define DMRG_LANCZOS_TOLERANCE_POLICY_H
+#include <algorithm>
+#include <cmath>
+#include "ProgressIndicator.h"
+#include "ProgramGlobals.h"
+
+namespace Dmrg {
+
+// Tolerance and maximum steps of the Lanczos or Davidson solver for each step
+//
+// Enabled with SolverOptions=adaptiveLanczosTolerance. A finite step, except
+// those of the last finite loop, uses the tolerance
+//   min(LOOSEST, FACTOR*max(e, |dE|)),
+// or LanczosEps if that is larger, where e is the discarded weight of the
+// previous truncation and dE the change of the energy in the previous finite
+// step, because the ground state is not more accurate than the truncation
+// allows. The maximum number of steps, LanczosSteps, is scaled by the ratio of
+// the digits of both tolerances, but is never less than half of LanczosSteps.
+// The last finite loop uses LanczosEps and LanczosSteps. The matrix vector
+// products saved are estimated with the average number of products of the
+// steps of the last finite loop, and printed once after it. Products are
+// those counted by the matrix vector classes, as the solvers may repeat some
+// of them, as LanczosSolver does to build the ground state.
+template<typename RealType>
+class LanczosTolerancePolicy {
+
+public:
+
+	LanczosTolerancePolicy(bool enabled, SizeType finiteLoops)
+	    : enabled_(enabled),
+	      finiteLoops_(finiteLoops),
+	      progress_("LanczosTolerancePolicy"),
+	      truncationError_(0.0),
+	      energyChange_(0.0),
+	      energy_(0.0),
+	      hasTruncationError_(false),
+	      hasEnergy_(false),
+	      loose_(false),
+	      looseSteps_(0),
+	      looseMatvecs_(0),
+	      tightSteps_(0),
+	      tightMatvecs_(0)
+	{}
+
+	template<typename ParametersForSolverType>
+	void adjust(ParametersForSolverType& params,
+	            ProgramGlobals::DirectionEnum direction,
+	            SizeType loopIndex)
+	{
+		loose_ = false;
+		if (!enabled_ || direction == ProgramGlobals::INFINITE) return;
+		if (loopIndex + 1 >= finiteLoops_ || !hasTruncationError_) return;
+
+		RealType tolerance = FACTOR*std::max(truncationError_, energyChange_);
+		tolerance = std::min(LOOSEST, tolerance);
+		if (tolerance <= params.tolerance || params.tolerance <= 0) return;
+
+		SizeType steps = params.steps;
+		if (params.tolerance < 1) {
+			RealType ratio = log(tolerance)/log(params.tolerance);
+			steps = static_cast<SizeType>(ceil(ratio*params.steps));
+			steps = std::max(params.steps/2, steps);
+		}
+
+		PsimagLite::OstringStream msg;
+		msg<<"Solver tolerance "<<tolerance<<" instead of "<<params.tolerance;
+		msg<<", and "<<steps<<" steps at most instead of "<<params.steps;
+		progress_.printline(msg,std::cout);
+
+		params.tolerance = tolerance;
+		params.steps = steps;
+		loose_ = true;
+	}
+
+	// matvecs is the total for all sectors of the step
+	void endStep(ProgramGlobals::DirectionEnum direction,
+	             SizeType loopIndex,
+	             RealType energy,
+	             SizeType matvecs)
+	{
+		if (!enabled_ || direction == ProgramGlobals::INFINITE) {
+			hasEnergy_ = false;
+			return;
+		}
+
+		if (hasEnergy_) energyChange_ = fabs(energy - energy_);
+		energy_ = energy;
+		hasEnergy_ = true;
+
+		if (loose_) {
+			++looseSteps_;
+			looseMatvecs_ += matvecs;
+			return;
+		}
+
+		if (loopIndex + 1 < finiteLoops_ || looseSteps_ == 0) return;
+
+		++tightSteps_;
+		tightMatvecs_ += matvecs;
+	}
+
+	void printSaved()
+	{
+		if (!enabled_ || looseSteps_ == 0 || tightSteps_ == 0) return;
+
+		RealType average = static_cast<RealType>(tightMatvecs_)/tightSteps_;
+		RealType saved = average*looseSteps_ - looseMatvecs_;
+		PsimagLite::OstringStream msg;
+		msg<<"Estimated matrix vector products saved "<<saved<<" in ";
+		msg<<looseSteps_<<" steps with looser tolerance, which used ";
+		msg<<looseMatvecs_;
+		progress_.printline(msg,std::cout);
+	}
+
+	void truncationError(RealType error)
+	{
+		truncationError_ = error;
+		hasTruncationError_ = true;
+	}
+
+private:
+
+	static const RealType FACTOR;
+	static const RealType LOOSEST;
+
+	bool enabled_;
+	SizeType finiteLoops_;
+	PsimagLite::ProgressIndicator progress_;
+	RealType truncationError_;
+	RealType energyChange_;
+	RealType energy_;
+	bool hasTruncationError_;
+	bool hasEnergy_;
+	bool loose_;
+	SizeType looseSteps_;
+	SizeType looseMatvecs_;
+	SizeType tightSteps_;
+	SizeType tightMatvecs_;
+}; // class LanczosTolerancePolicy
+
+template<typename RealType>
+const RealType LanczosTolerancePolicy<RealType>::FACTOR = 0.1;
+
+template<typename RealType>
+const RealType LanczosTolerancePolicy<RealType>::LOOSEST = 1e-5;
+} // namespace Dmrg
+
+#endif // DMRG_LANCZOS_TOLERANCE_POLICY_H
@@ -80,6 +80,7 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #ifndef LINK_PRODUCT_STRUCT_H
 #define LINK_PRODUCT_STRUCT_H
 #include "ProgramGlobals.h"
+#include <algorithm>
 
 namespace Dmrg {
 	template<typename FieldType>
@@ -119,6 +120,26 @@ namespace Dmrg {
 			}
 		}
 
+		// Sorts the links so that those with the same connection type,
+		// site on the left, term and dof, that is, with the same
+		// left operator, are contiguous, and then seals
+		void seal()
+		{
+			SizeType total = typesaved.size();
+			typename PsimagLite::Vector<SizeType>::Type perm(total);
+			for (SizeType i = 0; i < total; ++i) perm[i] = i;
+
+			std::sort(perm.begin(), perm.end(), LinkLess(*this));
+
+			permute(isaved, perm);
+			permute(jsaved, perm);
+			permute(typesaved, perm);
+			permute(tmpsaved, perm);
+			permute(dofssaved, perm);
+			permute(termsaved, perm);
+			sealed = true;
+		}
+
 		bool sealed;
 		typename PsimagLite::Vector<SizeType>::Type isaved;
 		typename PsimagLite::Vector<SizeType>::Type jsaved;
@@ -129,6 +150,44 @@ namespace Dmrg {
 #ifdef NOMUTEX
 		mutable typename PsimagLite::Vector<PsimagLite::Vector<FieldType>::Type::Type > xtemp;
 #endif
+
+	private:
+
+		class LinkLess {
+
+		public:
+
+			LinkLess(const LinkProductStruct& lps) : lps_(lps) {}
+
+			bool operator()(SizeType a, SizeType b) const
+			{
+				if (lps_.typesaved[a] != lps_.typesaved[b])
+					return (lps_.typesaved[a] < lps_.typesaved[b]);
+				if (lps_.isaved[a] != lps_.isaved[b])
+					return (lps_.isaved[a] < lps_.isaved[b]);
+				if (lps_.termsaved[a] != lps_.termsaved[b])
+					return (lps_.termsaved[a] < lps_.termsaved[b]);
+				if (lps_.dofssaved[a] != lps_.dofssaved[b])
+					return (lps_.dofssaved[a] < lps_.dofssaved[b]);
+				if (lps_.jsaved[a] != lps_.jsaved[b])
+					return (lps_.jsaved[a] < lps_.jsaved[b]);
+				return (a < b);
+			}
+
+		private:
+
+			const LinkProductStruct& lps_;
+		};
+
+		template<typename SomeVectorType>
+		static void permute(SomeVectorType& v,
+		                    const typename PsimagLite::Vector<SizeType>::Type& perm)
+		{
+			SomeVectorType tmp(v.size());
+			for (SizeType i = 0; i < perm.size(); ++i)
+				tmp[i] = v[perm[i]];
+			v.swap(tmp);
+		}
 	}; //
 } // namespace Dmrg
 /*@}*/
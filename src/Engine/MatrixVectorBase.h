@@ -81,6 +81,8 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #define DMRG_MATRIX_VECTOR_BASE_H
 
 #include <vector>
+#include <algorithm>
+#include "ProgramGlobals.h"
 
 namespace Dmrg {
 template<typename ModelType_>
@@ -97,6 +99,16 @@ public:
 	typedef typename PsimagLite::Vector<ComplexOrRealType>::Type VectorType;
 	typedef PsimagLite::Matrix<ComplexOrRealType> FullMatrixType;
 
+	MatrixVectorBase() : matvecs_(0) {}
+
+	// Matrix vector products done by the solvers, including those that
+	// LanczosSolver repeats to build the ground state
+	SizeType matvecs() const { return matvecs_; }
+
+	// Whether the products can be done in the even and odd subspaces of
+	// the reflection, with half-size vectors
+	static bool reflectionSupported() { return false; }
+
 	SizeType reflectionSector() const { return 0; }
 
 	void reflectionSector(SizeType) {  }
@@ -117,6 +129,83 @@ public:
 		fm = matrixStored.toDense();
 		diag(fm,eigs,'V');
 	}
+
+	static void diagonalOf(VectorType& d, const SparseMatrixType& matrix)
+	{
+		SizeType n = matrix.rows();
+		d.resize(n);
+		for (SizeType i = 0; i < n; ++i) {
+			d[i] = 0.0;
+			for (int k = matrix.getRowPtr(i); k < matrix.getRowPtr(i + 1); ++k) {
+				if (static_cast<SizeType>(matrix.getCol(k)) != i) continue;
+				d[i] = matrix.getValue(k);
+				break;
+			}
+		}
+	}
+
+	// Diagonal of the Hamiltonian in the sector of modelHelper, from the
+	// diagonals of the block Hamiltonians and of the connection operators,
+	// in the same way that InitKronHamiltonian builds the connections
+	static bool diagonalFromLinks(VectorType& d,
+	                              const ModelType& model,
+	                              const ModelHelperType& modelHelper)
+	{
+		typedef typename ModelHelperType::LeftRightSuperType LeftRightSuperType;
+		typedef typename LeftRightSuperType::BasisType BasisType;
+		typedef typename ModelHelperType::LinkType LinkType;
+
+		if (BasisType::useSu2Symmetry()) return false;
+
+		const LeftRightSuperType& lrs = modelHelper.leftRightSuper();
+		SizeType offset = lrs.super().partition(modelHelper.m());
+		SizeType n = modelHelper.size();
+		SizeType nl = lrs.left().size();
+		const typename PsimagLite::Vector<SizeType>::Type& electrons =
+		        lrs.left().electronsVector(BasisType::AFTER_TRANSFORM);
+
+		VectorType diagL;
+		VectorType diagR;
+		diagonalOf(diagL, lrs.left().hamiltonian());
+		diagonalOf(diagR, lrs.right().hamiltonian());
+		d.resize(n);
+		for (SizeType r = 0; r < n; ++r) {
+			SizeType s = lrs.super().permutation(r + offset);
+			d[r] = diagL[s % nl] + diagR[s / nl];
+		}
+
+		SizeType total = model.getLinkProductStruct(modelHelper);
+		for (SizeType ix = 0; ix < total; ++ix) {
+			SparseMatrixType const* A = 0;
+			SparseMatrixType const* B = 0;
+			LinkType link = model.getConnection(&A,&B,ix,modelHelper);
+			if (link.type == ProgramGlobals::ENVIRON_SYSTEM) {
+				std::swap(A,B);
+				if (link.fermionOrBoson == ProgramGlobals::FERMION)
+					link.value *= -1.0;
+			}
+
+			diagonalOf(diagL, *A);
+			diagonalOf(diagR, *B);
+			for (SizeType r = 0; r < n; ++r) {
+				SizeType s = lrs.super().permutation(r + offset);
+				SizeType i = s % nl;
+				RealType sign = (link.fermionOrBoson == ProgramGlobals::FERMION &&
+				                 (electrons[i] & 1)) ? -1.0 : 1.0;
+				d[r] += diagL[i]*diagR[s / nl]*sign*link.value;
+			}
+		}
+
+		return true;
+	}
+
+protected:
+
+	void countMatvec() const { ++matvecs_; }
+
+private:
+
+	mutable SizeType matvecs_;
 }; // class MatrixVectorBase
 } // namespace Dmrg
 
@@ -150,6 +150,15 @@ public:
 		return *data_(i,j);
 	}
 
+	SizeType memoryUsage() const
+	{
+		SizeType total = 0;
+		for (SizeType i = 0; i < data_.n_row(); ++i)
+			for (SizeType j = 0; j < data_.n_col(); ++j)
+				if (data_(i,j)) total += data_(i,j)->memoryUsage();
+		return total;
+	}
+
 	~ArrayOfMatStruct()
 	{
 		for (SizeType i = 0; i < data_.n_row(); ++i)
@@ -179,6 +179,14 @@ public:
 
 	SizeType connections() const { return xc_.size(); }
 
+	SizeType memoryUsage() const
+	{
+		SizeType total = 0;
+		for (SizeType ic = 0; ic < xc_.size(); ++ic) total += xc_[ic]->memoryUsage();
+		for (SizeType ic = 0; ic < yc_.size(); ++ic) total += yc_[ic]->memoryUsage();
+		return total;
+	}
+
 	SizeType size(WhatBasisEnum what) const
 	{
 		return (what == OLD) ? sizeInternal(ijpatchesOld_, mOld_) :
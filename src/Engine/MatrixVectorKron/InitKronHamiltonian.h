@@ -79,7 +79,9 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #define INITKRON_HAMILTONIAN_H
 #include "ProgramGlobals.h"
 #include "InitKronBase.h"
+#include "MatrixVectorBase.h"
 #include "Vector.h"
+#include "StepArena.h"
 
 namespace Dmrg {
 
@@ -104,6 +106,9 @@ public:
 	typedef typename PsimagLite::Vector<ArrayOfMatStructType*>::Type VectorArrayOfMatStructType;
 	typedef typename PsimagLite::Vector<ComplexOrRealType>::Type VectorType;
 	typedef typename ArrayOfMatStructType::VectorSizeType VectorSizeType;
+	typedef typename ArrayOfMatStructType::MatrixDenseOrSparseType MatrixDenseOrSparseType;
+	typedef StepArena<VectorType> StepArenaType;
+	typedef MatrixVectorBase<ModelType> MatrixVectorBaseType;
 
 	InitKronHamiltonian(const ModelType& model,
 	                    const ModelHelperType& modelHelper)
@@ -122,13 +127,21 @@ public:
 		assert(vstart_.size() > 0);
 		SizeType nsize = vstart_[vstart_.size() - 1];
 		assert(nsize > 0);
-		yin_.resize(nsize, 0.0);
-		xout_.resize(nsize, 0.0);
+		StepArenaType::take(yin_, nsize);
+		StepArenaType::take(xout_, nsize);
 		BaseType::computeOffsets(offsetForPatches_, BaseType::NEW);
 	}
 
+	~InitKronHamiltonian()
+	{
+		StepArenaType::give(yin_);
+		StepArenaType::give(xout_);
+	}
+
 	bool isWft() const {return false; }
 
+	SizeType threads() const { return modelHelper_.threads(); }
+
 	bool loadBalance() const
 	{
 		return (model_.params().options.find("KronLoadBalance") != PsimagLite::String::npos);
@@ -212,6 +225,39 @@ public:
 		return  offsetForPatches_[ind];
 	}
 
+	// Diagonal of the Hamiltonian, from the diagonal patches of the connections
+	void diagonal(VectorType& d) const
+	{
+		SizeType npatches = BaseType::numberOfPatches(BaseType::NEW);
+		const BasisType& left = BaseType::lrs(BaseType::NEW).left();
+		const BasisType& right = BaseType::lrs(BaseType::NEW).right();
+		VectorType dPatches(vstart_[npatches], 0.0);
+		VectorType diagA;
+		VectorType diagB;
+		for (SizeType ipatch = 0; ipatch < npatches; ++ipatch) {
+			SizeType igroup = BaseType::patch(BaseType::NEW, GenIjPatchType::LEFT)[ipatch];
+			SizeType jgroup = BaseType::patch(BaseType::NEW, GenIjPatchType::RIGHT)[ipatch];
+			SizeType sizeLeft =  left.partition(igroup+1) - left.partition(igroup);
+			SizeType sizeRight = right.partition(jgroup+1) - right.partition(jgroup);
+			for (SizeType ic = 0; ic < BaseType::connections(); ++ic) {
+				const MatrixDenseOrSparseType& a = BaseType::xc(ic)(ipatch, ipatch);
+				const MatrixDenseOrSparseType& b = BaseType::yc(ic)(ipatch, ipatch);
+				if (a.isZero() || b.isZero()) continue;
+				MatrixVectorBaseType::diagonalOf(diagA, a.sparse());
+				MatrixVectorBaseType::diagonalOf(diagB, b.sparse());
+				for (SizeType ileft = 0; ileft < sizeLeft; ++ileft) {
+					if (diagA[ileft] == static_cast<ComplexOrRealType>(0.0)) continue;
+					for (SizeType iright = 0; iright < sizeRight; ++iright)
+						dPatches[vstart_[ipatch] + iright + ileft*sizeRight] +=
+						        diagA[ileft]*diagB[iright];
+				}
+			}
+		}
+
+		d.resize(BaseType::size(BaseType::NEW));
+		BaseType::copyOut(d, dPatches, vstart_);
+	}
+
 	bool batchedGemm() const
 	{
 		return (model_.params().options.find("BatchedGemm") != PsimagLite::String::npos);
@@ -85,6 +85,7 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "Parallelizer.h"
 #include "PsimagLite.h"
 #include "ProgressIndicator.h"
+#include "StepArena.h"
 #ifdef PLUGIN_SC
 #include "BatchedGemmPluginSc.h"
 #else
@@ -129,11 +130,14 @@ public:
 
 		if (batchedGemm_.enabled()) {
 			VectorType& xout = initKron_.xout();
-			VectorType xoutTmp(xout.size(), 0.0);
+			VectorType xoutTmp;
+			StepArena<VectorType>::take(xoutTmp, xout.size());
 			batchedGemm_.matrixVector(xoutTmp, initKron_.yin());
 			for(SizeType i = 0; i < xoutTmp.size(); ++i)
 				xout[i] += xoutTmp[i];
 
+			StepArena<VectorType>::give(xoutTmp);
+
 			initKron_.copyOut(vout);
 			return;
 		}
@@ -141,7 +145,7 @@ public:
 		KronConnectionsType kc(initKron_);
 
 		typedef PsimagLite::Parallelizer<KronConnectionsType> ParallelizerType;
-		ParallelizerType parallelConnections(PsimagLite::Concurrency::npthreads,
+		ParallelizerType parallelConnections(initKron_.threads(),
 		                                     PsimagLite::MPI::COMM_WORLD);
 
 		if (initKron_.loadBalance())
@@ -84,6 +84,8 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "InitKronHamiltonian.h"
 #include "KronMatrix.h"
 #include "MatrixVectorBase.h"
+#include "PhaseProfiler.h"
+#include "MemoryAccounting.h"
 
 namespace Dmrg {
 template<typename ModelType_>
@@ -115,10 +117,13 @@ public:
 	      initKron_(*model,*modelHelper),
 	      kronMatrix_(initKron_, "Hamiltonian")
 	{
+		MemoryAccounting::peak("kron", initKron_.memoryUsage());
+
 		int maxMatrixRankStored = model->params().maxMatrixRankStored;
 		if (modelHelper->size() > maxMatrixRankStored) return;
 
 		model->fullHamiltonian(matrixStored_,*modelHelper);
+		MemoryAccounting::peak("hamiltonian", MemoryAccounting::bytes(matrixStored_));
 		assert(isHermitian(matrixStored_,true));
 
 		checkKron();
@@ -129,12 +134,23 @@ public:
 	template<typename SomeVectorType>
 	void matrixVectorProduct(SomeVectorType &x,SomeVectorType const &y) const
 	{
+		PhaseProfiler::Scope scope("matvec", false);
+		BaseType::countMatvec();
 		if (matrixStored_.rows() > 0)
 			matrixStored_.matrixVectorProduct(x,y);
 		else
 			kronMatrix_.matrixVectorProduct(x,y);
 	}
 
+	bool diagonal(VectorType& d) const
+	{
+		if (matrixStored_.rows() > 0)
+			BaseType::diagonalOf(d, matrixStored_);
+		else
+			initKron_.diagonal(d);
+		return true;
+	}
+
 	void fullDiag(VectorRealType& eigs,FullMatrixType& fm) const
 	{
 		BaseType::fullDiag(eigs,fm,matrixStored_,model_->params().maxMatrixRankStored);
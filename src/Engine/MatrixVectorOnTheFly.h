@@ -82,6 +82,7 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 
 #include <vector>
 #include "MatrixVectorBase.h"
+#include "PhaseProfiler.h"
 
 namespace Dmrg {
 template<typename ModelType_>
@@ -99,6 +100,7 @@ public:
 	typedef typename SparseMatrixType::value_type value_type;
 	typedef typename SparseMatrixType::value_type ComplexOrRealType;
 	typedef typename PsimagLite::Vector<RealType>::Type VectorRealType;
+	typedef typename PsimagLite::Vector<ComplexOrRealType>::Type VectorType;
 	typedef PsimagLite::Matrix<ComplexOrRealType> FullMatrixType;
 
 	MatrixVectorOnTheFly(ModelType const *model,
@@ -118,12 +120,24 @@ public:
 	template<typename SomeVectorType>
 	void matrixVectorProduct(SomeVectorType &x,SomeVectorType const &y) const
 	{
+		PhaseProfiler::Scope scope("matvec", false);
+		BaseType::countMatvec();
 		if (matrixStored_.rows() > 0)
 			matrixStored_.matrixVectorProduct(x,y);
 		else
 			model_->matrixVectorProduct(x,y,*modelHelper_);
 	}
 
+	bool diagonal(VectorType& d) const
+	{
+		if (matrixStored_.rows() > 0) {
+			BaseType::diagonalOf(d, matrixStored_);
+			return true;
+		}
+
+		return BaseType::diagonalFromLinks(d, *model_, *modelHelper_);
+	}
+
 	void fullDiag(VectorRealType& eigs,FullMatrixType& fm) const
 	{
 		int mrs = model_->params().maxMatrixRankStored;
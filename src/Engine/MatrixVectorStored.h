@@ -83,6 +83,8 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include <vector>
 #include "ProgressIndicator.h"
 #include "MatrixVectorBase.h"
+#include "PhaseProfiler.h"
+#include "MemoryAccounting.h"
 
 namespace Dmrg {
 template<typename ModelType_>
@@ -100,6 +102,7 @@ public:
 	typedef typename SparseMatrixType::value_type value_type;
 	typedef typename SparseMatrixType::value_type ComplexOrRealType;
 	typedef typename PsimagLite::Vector<RealType>::Type VectorRealType;
+	typedef typename PsimagLite::Vector<ComplexOrRealType>::Type VectorType;
 	typedef PsimagLite::Matrix<ComplexOrRealType> FullMatrixType;
 
 	MatrixVectorStored(ModelType const *model,
@@ -121,6 +124,7 @@ public:
 			msg<<"fullHamiltonian has rank="<<matrixStored_[0].rows();
 			msg<<" nonzeros="<<matrixStored_[0].nonZeros();
 			progress_.printline(msg,std::cout);
+			MemoryAccounting::peak("hamiltonian", MemoryAccounting::bytes(matrixStored_[0]));
 			if (debugMatrix)
 				printFullMatrix(matrixStored_[0],"matrix",1);
 			return;
@@ -132,6 +136,9 @@ public:
 		PsimagLite::OstringStream msg;
 		msg<<" sector="<<matrixStored_[0].rows()<<" and sector="<<matrixStored_[1].rows();
 		progress_.printline(msg,std::cout);
+		MemoryAccounting::peak("hamiltonian",
+		                       MemoryAccounting::bytes(matrixStored_[0]) +
+		                       MemoryAccounting::bytes(matrixStored_[1]));
 	}
 
 	SizeType rows() const { return matrixStored_[pointer_].rows(); }
@@ -139,6 +146,8 @@ public:
 	template<typename SomeVectorType>
 	void matrixVectorProduct(SomeVectorType &x, SomeVectorType const &y) const
 	{
+		PhaseProfiler::Scope scope("matvec", false);
+		BaseType::countMatvec();
 		matrixStored_[pointer_].matrixVectorProduct(x,y);
 	}
 
@@ -147,6 +156,15 @@ public:
 		return matrixStored_[pointer_](i,j);
 	}
 
+	bool diagonal(VectorType& d) const
+	{
+		BaseType::diagonalOf(d, matrixStored_[pointer_]);
+		return true;
+	}
+
+	// the stored Hamiltonian is projected into both subspaces
+	static bool reflectionSupported() { return true; }
+
 	SizeType reflectionSector() const { return pointer_; }
 
 	void reflectionSector(SizeType p) { pointer_=p; }
@@ -0,0 +1,149 @@
+#ifndef MEMORYACCOUNTING_H
+#define MEMORYACCOUNTING_H
+#include <map>
+#include "Vector.h"
+#include "Matrix.h"
+#include "CrsMatrix.h"
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#endif
+
+namespace Dmrg {
+
+// Bytes held by the large data structures of a DMRG run
+//
+// Whereas memResolv() describes the layout of an object, memoryUsage()
+// functions count the heap bytes that an object holds, with the help of the
+// bytes() functions here. Persistent structures, like the stacks, are added to
+// the report of each step. Transient structures, like Kron patches or
+// Lanczos vectors, are recorded with peak(), and the largest value since the
+// last report is added to it.
+// With MemoryBudget= (in MB) in the input, DmrgSolver moves older stack entries
+// to disk when the total reaches HIGH_PERCENT of the budget, until the total
+// is below LOW_PERCENT of the budget.
+class MemoryAccounting {
+
+	typedef std::pair<PsimagLite::String, SizeType> PairStringSizeType;
+	typedef PsimagLite::Vector<PairStringSizeType>::Type VectorPairStringSizeType;
+	typedef std::map<PsimagLite::String, SizeType> MapStringSizeType;
+
+	static const SizeType MEGABYTE = 1048576;
+
+	static const SizeType HIGH_PERCENT = 90;
+
+	static const SizeType LOW_PERCENT = 80;
+
+public:
+
+	explicit MemoryAccounting(SizeType budgetMb)
+	    : budget_(budgetMb*MEGABYTE)
+	{}
+
+	template<typename T>
+	static SizeType bytes(const PsimagLite::CrsMatrix<T>& m)
+	{
+		return m.nonZeros()*(sizeof(T) + sizeof(int)) + (m.rows() + 1)*sizeof(int);
+	}
+
+	template<typename T>
+	static SizeType bytes(const PsimagLite::Matrix<T>& m)
+	{
+		return m.n_row()*m.n_col()*sizeof(T);
+	}
+
+	// Only for vectors of types that do not hold heap memory
+	template<typename T, typename A>
+	static SizeType bytes(const std::vector<T, A>& v)
+	{
+		return v.capacity()*sizeof(T);
+	}
+
+	// Records the size of a transient structure; can be called from any thread
+	static void peak(PsimagLite::String name, SizeType bytes)
+	{
+#ifdef USE_PTHREADS
+		pthread_mutex_lock(&mutex());
+#endif
+		SizeType& value = peaks()[name];
+		if (value < bytes) value = bytes;
+#ifdef USE_PTHREADS
+		pthread_mutex_unlock(&mutex());
+#endif
+	}
+
+	void add(PsimagLite::String name, SizeType bytes)
+	{
+		entries_.push_back(PairStringSizeType(name, bytes));
+	}
+
+	// Adds the transient structures recorded since the last call
+	void addPeaks()
+	{
+#ifdef USE_PTHREADS
+		pthread_mutex_lock(&mutex());
+#endif
+		MapStringSizeType& p = peaks();
+		MapStringSizeType::const_iterator it = p.begin();
+		for (; it != p.end(); ++it)
+			add(it->first, it->second);
+		p.clear();
+#ifdef USE_PTHREADS
+		pthread_mutex_unlock(&mutex());
+#endif
+	}
+
+	SizeType total() const
+	{
+		SizeType sum = 0;
+		for (SizeType i = 0; i < entries_.size(); ++i)
+			sum += entries_[i].second;
+		return sum;
+	}
+
+	// Bytes to be moved to disk, 0 if there is no budget or it's not yet approached
+	SizeType excess() const
+	{
+		if (budget_ == 0) return 0;
+		SizeType sum = total();
+		if (sum*100 < budget_*HIGH_PERCENT) return 0;
+		return sum - budget_*LOW_PERCENT/100;
+	}
+
+	PsimagLite::String toString() const
+	{
+		PsimagLite::OstringStream msg;
+		msg.precision(4);
+		msg<<"MemoryAccounting (MB):";
+		for (SizeType i = 0; i < entries_.size(); ++i)
+			msg<<" "<<entries_[i].first<<"="<<toMb(entries_[i].second);
+		msg<<" total="<<toMb(total());
+		if (budget_ > 0) msg<<" budget="<<toMb(budget_);
+		return msg.str();
+	}
+
+	static double toMb(SizeType x)
+	{
+		return static_cast<double>(x)/MEGABYTE;
+	}
+
+private:
+
+	static MapStringSizeType& peaks()
+	{
+		static MapStringSizeType p;
+		return p;
+	}
+
+#ifdef USE_PTHREADS
+	static pthread_mutex_t& mutex()
+	{
+		static pthread_mutex_t m = PTHREAD_MUTEX_INITIALIZER;
+		return m;
+	}
+#endif
+
+	SizeType budget_;
+	VectorPairStringSizeType entries_;
+};
+}
+#endif // MEMORYACCOUNTING_H
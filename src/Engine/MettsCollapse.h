@@ -112,10 +112,11 @@ public:
 
 	MettsCollapse(const MettsStochasticsType& mettsStochastics,
 	              const LeftRightSuperType& lrs,
-	              const TargetParamsType& targetParams)
+	              const TargetParamsType& targetParams,
+	              int long seed)
 	    : mettsStochastics_(mettsStochastics),
 	      lrs_(lrs),
-	      rng_(targetParams.rngSeed),
+	      rng_(seed),
 	      targetParams_(targetParams),
 	      progress_("MettsCollapse"),
 	      prevDirection_(ProgramGlobals::INFINITE),
@@ -207,11 +208,14 @@ private:
 
 		SizeType volumeOfIndexFixed = mettsStochastics_.chooseRandomState(p);
 
+		// one line per call, as chains collapse concurrently
+		PsimagLite::OstringStream msg;
 		for (SizeType i=0;i<block.size();i++)
-			std::cerr<<"SITES="<<block[i]<<" ";
-		std::cerr<<" PROBS=";
-		for (SizeType i=0;i<p.size();i++) std::cerr<<p[i]<<" ";
-		std::cerr<<" CHOSEN="<<volumeOfIndexFixed<<" BORDER="<<border<<"\n";
+			msg<<"SITES="<<block[i]<<" ";
+		msg<<" PROBS=";
+		for (SizeType i=0;i<p.size();i++) msg<<p[i]<<" ";
+		msg<<" CHOSEN="<<volumeOfIndexFixed<<" BORDER="<<border;
+		progress_.printline(msg,std::cerr);
 		// m1 == indexFixed in FIXME write paper reference here
 
 		VectorWithOffsetType dest;
@@ -219,7 +223,9 @@ private:
 		RealType x = norm(dest);
 
 		if (x<1e-6 && dest.sectors()==0) {
-			std::cout<<"norm of dest2= "<<norm(dest2)<<"\n";
+			PsimagLite::OstringStream msg2;
+			msg2<<"norm of dest2= "<<norm(dest2);
+			progress_.printline(msg2,std::cout);
 			dest2 = dest;
 			return;
 		}
@@ -245,7 +251,9 @@ private:
 		dest.collapseSectors();
 
 		dest2 =  dest;
-		std::cerr<<" Norm of the collapsed="<<norm(dest2)<<"\n";
+		PsimagLite::OstringStream msg;
+		msg<<"Norm of the collapsed="<<norm(dest2);
+		progress_.printline(msg,std::cerr);
 	}
 
 	void collapseVector(VectorWithOffsetType& w, // <<---- CPS
@@ -432,8 +440,11 @@ private:
 	                 bool border) const
 	{
 		RealType tmp = norm(src);
-		if (fabs(tmp-1.0)>1e-3)
-			std::cerr<<"probability "<<tmp<<"\n";
+		if (fabs(tmp-1.0)>1e-3) {
+			PsimagLite::OstringStream msg;
+			msg<<"probability "<<tmp;
+			progress_.printline(msg,std::cerr);
+		}
 
 		RealType sum = 0;
 		for (SizeType alpha=0;alpha<volumeOfNk;alpha++) {
@@ -443,8 +454,11 @@ private:
 			sum += x*x;
 			p[alpha] = x*x;
 		}
-		if (fabs(sum-1.0)>1e-3)
-			std::cerr<<"probability sum="<<sum<<"\n";
+		if (fabs(sum-1.0)>1e-3) {
+			PsimagLite::OstringStream msg;
+			msg<<"probability sum="<<sum;
+			progress_.printline(msg,std::cerr);
+		}
 		assert(fabs(sum)>1e-6);
 		for (SizeType alpha=0;alpha<p.size();alpha++) {
 			p[alpha] /= sum;
@@ -454,10 +468,11 @@ private:
 
 	bool checkSites(SizeType site) const
 	{
-		std::cerr<<"MettsCollapse: SITES SEEN ";
+		PsimagLite::OstringStream msg;
+		msg<<"SITES SEEN ";
 		for (SizeType i=0;i<sitesSeen_.size();++i)
-			std::cerr<<sitesSeen_[i]<<" ";
-		std::cerr<<"\n";
+			msg<<sitesSeen_[i]<<" ";
+		progress_.printline(msg,std::cerr);
 
 		SizeType sitesPerBlock = mettsStochastics_.model().params().sitesPerBlock;
 		for (SizeType i=sitesPerBlock;i<site+1;i++) {
@@ -490,8 +505,9 @@ private:
 		if (targetParams_.collapse.find("particle")!=PsimagLite::String::npos)
 			particleCollapse(collapseBasis_);
 
-		std::cout<<"Collapse basis:\n";
-		std::cout<<collapseBasis_;
+		PsimagLite::OstringStream msg;
+		msg<<"Collapse basis:\n"<<collapseBasis_;
+		progress_.printline(msg,std::cout);
 		checkBasis();
 	}
 
@@ -543,7 +559,9 @@ private:
 
 	void rotation2d(MatrixType& m,SizeType x,SizeType y,const RealType& theta) const
 	{
-		std::cout<<"Theta="<<theta<<"\n";
+		PsimagLite::OstringStream msg;
+		msg<<"Theta="<<theta;
+		progress_.printline(msg,std::cout);
 		for (SizeType i=0;i<m.rows();i++) m(i,i) = 1.0;
 		m(x,x) = m(y,y) = cos(theta);
 		m(x,y) = sin(theta);
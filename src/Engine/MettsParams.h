@@ -100,8 +100,14 @@ public:
 
 	template<typename IoInputter>
 	MettsParams(IoInputter& io,const ModelType& model)
-	    : TimeVectorParamsType(io,model)
+	    : TimeVectorParamsType(io,model),
+	      chains(1)
 	{
+		/*PSIDOC MettsParams
+		\item[MettsChains] [Integer] Optional. Number of independent METTS
+		chains carried together through the same sweep, each with its own
+		random number stream. Defaults to 1.
+		*/
 		io.readline(beta,"BetaDividedByTwo=");
 		io.readline(rngSeed,"TSPRngSeed=");
 		io.readline(collapse,"MettsCollapse=");
@@ -109,6 +115,13 @@ public:
 			io.read(pure,"MettsPure");
 		} catch (std::exception& e) {}
 
+		try {
+			io.readline(chains,"MettsChains=");
+		} catch (std::exception&) {}
+
+		if (chains == 0)
+			throw PsimagLite::RuntimeError("MettsParams: MettsChains must be positive\n");
+
 		SizeType n = model.geometry().numberOfSites();
 		if (pure.size() > 0 && pure.size() != n) {
 			PsimagLite::String msg("MettsParams: If provided, MettsPure must be");
@@ -123,6 +136,7 @@ public:
 	RealType beta;
 	PsimagLite::String collapse;
 	VectorSizeType pure;
+	SizeType chains;
 }; // class MettsParams
 
 template<typename ModelType>
@@ -135,6 +149,7 @@ inline std::ostream& operator<<(std::ostream& os,const MettsParams<ModelType>& t
 	os<<"#TSPRngSeed="<<t.rngSeed<<"\n";
 	os<<"#MettsCollapse="<<t.collapse<<"\n";
 	os<<"#MettsPure="<<t.pure<<"\n";
+	os<<"#MettsChains="<<t.chains<<"\n";
 	return os;
 }
 
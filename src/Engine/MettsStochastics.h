@@ -142,12 +142,11 @@ public:
 	// call only from INFINITE
 	void update(SizeType qn,
 	            const typename PsimagLite::Vector<SizeType>::Type& block1,
-	            const typename PsimagLite::Vector<SizeType>::Type& block2,
-	            SizeType seed)
+	            const typename PsimagLite::Vector<SizeType>::Type& block2)
 	{
 		if (addedSites_.size()==0) {
 			pureStates_.resize(block2[block2.size()-1]+block2.size()+1);
-			initialSetOfPures(seed);
+			initialSetOfPures();
 			for (SizeType i=0;i<block1.size();i++)
 				for (SizeType j=0;j<block1.size();j++)
 					addedSites_.push_back(block1[i]+j-block1.size());
@@ -178,7 +177,7 @@ public:
 
 private:
 
-	void initialSetOfPures(LongType)
+	void initialSetOfPures()
 	{
 		for (SizeType i=0;i<pureStates_.size();i++)
 			pureStates_[i] = SizeType(rng_()*model_.hilbertSize(i));
@@ -80,7 +80,7 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #ifndef MODEL_BASE_H
 #define MODEL_BASE_H
 
-#include "ReflectionOperatorEmpty.h"
+#include "ReflectionOperator.h"
 #include "ModelCommonBase.h"
 #include "Vector.h"
 #include "Sort.h"
@@ -108,7 +108,7 @@ public:
 	typedef typename ModelHelperType::BasisType MyBasis;
 	typedef typename ModelHelperType::BasisWithOperatorsType BasisWithOperatorsType;
 	typedef typename ModelHelperType::LeftRightSuperType LeftRightSuperType;
-	typedef ReflectionOperatorEmpty<LeftRightSuperType> ReflectionSymmetryType;
+	typedef ReflectionOperator<LeftRightSuperType> ReflectionSymmetryType;
 	typedef typename OperatorsType::OperatorType OperatorType;
 	typedef typename PsimagLite::Vector<OperatorType>::Type VectorOperatorType;
 	typedef typename MyBasis::SymmetryElectronsSzType SymmetryElectronsSzType;
@@ -82,6 +82,7 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #ifndef MODEL_COMMON_H
 #define MODEL_COMMON_H
 #include <iostream>
+#include <algorithm>
 
 #include "VerySparseMatrix.h"
 #include "HamiltonianConnection.h"
@@ -91,6 +92,7 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "ProgressIndicator.h"
 #include "NoPthreads.h"
 #include "Sort.h"
+#include "RowAccumulator.h"
 
 namespace Dmrg {
 
@@ -106,6 +108,113 @@ class ModelCommon : public ModelBaseType::ModelCommonBaseType {
 	typedef VerySparseMatrix<SparseElementType> VerySparseMatrixType;
 	typedef typename ModelHelperType::LinkType LinkType;
 	typedef typename GeometryType::AdditionalDataType AdditionalDataType;
+	typedef typename PsimagLite::Vector<SparseMatrixType>::Type VectorSparseMatrixType;
+	typedef PsimagLite::Vector<SizeType>::Type VectorSizeType;
+	typedef RowAccumulator<SparseMatrixType> RowAccumulatorType;
+	typedef typename PsimagLite::Vector<RowAccumulatorType>::Type VectorRowAccumulatorType;
+	typedef HamiltonianConnection<GeometryType,
+	ModelHelperType,
+	LinkProductType> HamiltonianConnectionPrivateType;
+
+	// Builds, in parallel, the system and environ parts of the Hamiltonian
+	// (terms 0 and 1) and the matrix of each system-environ connection
+	class ParallelHamiltonianTerms {
+
+	public:
+
+		ParallelHamiltonianTerms(VectorSparseMatrixType& terms,
+		                         const ModelHelperType& modelHelper,
+		                         const HamiltonianConnectionPrivateType& hc)
+		    : terms_(terms), modelHelper_(modelHelper), hc_(hc)
+		{}
+
+		SizeType tasks() const { return terms_.size(); }
+
+		void doTask(SizeType index, SizeType)
+		{
+			SparseMatrixType& matrix = terms_[index];
+			if (index < 2)
+				return modelHelper_.calcHamiltonianPart(matrix, (index == 0));
+
+			SizeType i = 0;
+			SizeType j = 0;
+			ProgramGlobals::ConnectionEnum type;
+			SizeType term = 0;
+			SizeType dofs = 0;
+			SparseElementType tmp = 0.0;
+			AdditionalDataType additionalData;
+			hc_.prepare(index - 2, i, j, type, tmp, term, dofs, additionalData);
+
+			const SparseMatrixType* A = 0;
+			const SparseMatrixType* B = 0;
+			LinkType link2 = hc_.getKron(&A, &B, i, j, type, tmp, term, dofs, additionalData);
+			modelHelper_.fastOpProdInter(*A, *B, matrix, link2);
+		}
+
+	private:
+
+		VectorSparseMatrixType& terms_;
+		const ModelHelperType& modelHelper_;
+		const HamiltonianConnectionPrivateType& hc_;
+	};
+
+	// Sums the terms row by row, in two phases: the first counts the
+	// nonzeros of each row, and the second fills the preallocated matrix.
+	// Each thread sums its rows with its own RowAccumulator
+	class ParallelHamiltonianRows {
+
+	public:
+
+		ParallelHamiltonianRows(SparseMatrixType& matrix,
+		                        const VectorSparseMatrixType& terms,
+		                        SizeType rows,
+		                        VectorSizeType& nonZerosPerRow,
+		                        SizeType threads)
+		    : matrix_(matrix),
+		      terms_(terms),
+		      rows_(rows),
+		      nonZerosPerRow_(nonZerosPerRow),
+		      fill_(false),
+		      accumulators_(threads, RowAccumulatorType(rows))
+		{}
+
+		void fill() { fill_ = true; }
+
+		SizeType tasks() const { return rows_; }
+
+		void doTask(SizeType row, SizeType threadNum)
+		{
+			RowAccumulatorType& accumulator = accumulators_[threadNum];
+			SizeType nterms = terms_.size();
+			for (SizeType t = 0; t < nterms; ++t) {
+				const SparseMatrixType& m = terms_[t];
+				if (m.rows() == 0) continue;
+				assert(row < m.rows());
+				for (int k = m.getRowPtr(row); k < m.getRowPtr(row + 1); ++k)
+					accumulator.add(m.getCol(k), m.getValue(k));
+			}
+
+			if (!fill_) {
+				nonZerosPerRow_[row] = accumulator.size();
+				accumulator.clear();
+				return;
+			}
+
+			SizeType ip = matrix_.getRowPtr(row);
+			assert(static_cast<SizeType>(matrix_.getRowPtr(row + 1)) ==
+			       ip + accumulator.size());
+			accumulator.flushAt(matrix_, ip);
+		}
+
+	private:
+
+		SparseMatrixType& matrix_;
+		const VectorSparseMatrixType& terms_;
+		SizeType rows_;
+		VectorSizeType& nonZerosPerRow_;
+		bool fill_;
+		VectorRowAccumulatorType accumulators_;
+	};
 
 public:
 
@@ -123,7 +232,6 @@ public:
 	typedef typename PsimagLite::Vector<OperatorType>::Type VectorOperatorType;
 	typedef typename ModelBaseType::SolverParamsType SolverParamsType;
 	typedef typename PsimagLite::Vector<LinkProductStructType>::Type VectorLinkProductStructType;
-	typedef PsimagLite::Vector<SizeType>::Type VectorSizeType;
 
 	ModelCommon(const SolverParamsType& params,const GeometryType& geometry)
 	    : ModelCommonBaseType(params,geometry),progress_("ModelCommon")
@@ -226,33 +334,12 @@ private:
 	                                  const typename PsimagLite::Vector<SparseElementType>::Type& y,
 	                                  const ModelHelperType& modelHelper) const
 	{
-		const LinkProductStructType& lpsConst = modelHelper.lps();
-		LinkProductStructType& lps = const_cast<LinkProductStructType&>(lpsConst);
-		LinkProductStructType lpsOne(ProgramGlobals::MAX_LPS);
-		HamiltonianConnectionType hc(this->geometry(),modelHelper,&lps,&x,&y);
-
-		SizeType n=modelHelper.leftRightSuper().super().block().size();
-		SizeType total = 0;
-		for (SizeType i=0;i<n;i++) {
-			for (SizeType j=0;j<n;j++) {
-				SizeType totalOne = 0;
-				hc.compute(i,j,0,&lpsOne,totalOne);
-				if (!lps.sealed)
-					lps.push(lpsOne,totalOne);
-				else
-					lps.copy(lpsOne,totalOne,total);
-				total += totalOne;
-			}
-		}
+		bool sealed = modelHelper.lps().sealed;
+		SizeType total = getLinkProductStruct(modelHelper);
+		HamiltonianConnectionType hc(this->geometry(),modelHelper,&modelHelper.lps(),&x,&y);
 
 		hc.tasks(total + 2);
-		assert(lps.typesaved.size() == total);
-		if (!lps.sealed) {
-			PsimagLite::OstringStream msg;
-			msg<<"LinkProductStructSize="<<total;
-			progress_.printline(msg,std::cout);
-			lps.sealed = true;
-
+		if (!sealed) {
 			PsimagLite::OstringStream msg2;
 			// add left and right contributions
 			msg2<<"PthreadsTheoreticalLimitForThisPart="<<(total+2);
@@ -281,18 +368,24 @@ private:
 		}
 
 		typedef PsimagLite::Parallelizer<HamiltonianConnectionType> ParallelizerType;
-		ParallelizerType parallelConnections(PsimagLite::Concurrency::npthreads,
+		ParallelizerType parallelConnections(modelHelper.threads(),
 		                                     PsimagLite::MPI::COMM_WORLD);
 		parallelConnections.loopCreate(hc);
 
 		hc.sync();
 	}
 
+	// The links of a superblock depend only on the superblock and on the
+	// time of the ModelHelper, and both are fixed for its lifetime.
+	// Therefore the n*n site pairs are enumerated once, and later calls
+	// return the sealed list, sorted so that links sharing operators
+	// are contiguous
 	SizeType getLinkProductStruct(const ModelHelperType& modelHelper) const
 	{
-		typename PsimagLite::Vector<SparseElementType>::Type x,y; // bogus
-
 		const LinkProductStructType& lpsConst = modelHelper.lps();
+		if (lpsConst.sealed) return lpsConst.typesaved.size();
+
+		typename PsimagLite::Vector<SparseElementType>::Type x,y; // bogus
 		LinkProductStructType& lps = const_cast<LinkProductStructType&>(lpsConst);
 		LinkProductStructType lpsOne(ProgramGlobals::MAX_LPS);
 		HamiltonianConnectionType hc(this->geometry(),modelHelper,&lps,&x,&y);
@@ -303,10 +396,7 @@ private:
 			for (SizeType j=0;j<n;j++) {
 				SizeType totalOne = 0;
 				hc.compute(i,j,0,&lpsOne,totalOne);
-				if (!lps.sealed)
-					lps.push(lpsOne,totalOne);
-				else
-					lps.copy(lpsOne,totalOne,total);
+				lps.push(lpsOne,totalOne);
 				total += totalOne;
 			}
 		}
@@ -316,12 +406,10 @@ private:
 			throw PsimagLite::RuntimeError(str);
 		}
 
-		if (!lps.sealed) {
-			PsimagLite::OstringStream msg;
-			msg<<"LinkProductStructSize="<<total;
-			progress_.printline(msg,std::cout);
-			lps.sealed = true;
-		}
+		lps.seal();
+		PsimagLite::OstringStream msg;
+		msg<<"LinkProductStructSize="<<total;
+		progress_.printline(msg,std::cout);
 
 		return total;
 	}
@@ -349,26 +437,54 @@ private:
 	/**
 		Returns H, the hamiltonian for basis1 and partition
 		$m$ consisting of the external product of basis2$\otimes$basis3
-		Note: Used only for debugging purposes
+		Used by MatrixVectorStored, and by the other MatrixVector classes
+		when the rank is not larger than MaxMatrixRankStored
 		*/
 	void fullHamiltonian(SparseMatrixType& matrix,const ModelHelperType& modelHelper) const
 	{
-		SparseMatrixType matrixBlock;
+		SizeType connections = getLinkProductStruct(modelHelper);
+		typename PsimagLite::Vector<SparseElementType>::Type x,y; // bogus
+		HamiltonianConnectionType hc(this->geometry(),modelHelper,&modelHelper.lps(),&x,&y);
+
+		SizeType rows = modelHelper.size();
+		matrix.clear();
+		if (rows == 0) return;
+
+		SizeType nterms = connections + 2;
+		SizeType threads = std::min(nterms, modelHelper.threads());
+		VectorSparseMatrixType terms(nterms);
+		typedef PsimagLite::Parallelizer<ParallelHamiltonianTerms> ParallelizerTermsType;
+		ParallelizerTermsType parallelTerms(threads, PsimagLite::MPI::COMM_WORLD);
+		ParallelHamiltonianTerms helperTerms(terms, modelHelper, hc);
+		parallelTerms.loopCreate(helperTerms);
+
+		VectorSizeType nonZerosPerRow(rows, 0);
+		threads = std::min(rows, modelHelper.threads());
+		typedef PsimagLite::Parallelizer<ParallelHamiltonianRows> ParallelizerRowsType;
+		ParallelHamiltonianRows helperRows(matrix, terms, rows, nonZerosPerRow, threads);
+		{
+			ParallelizerRowsType parallelCount(threads, PsimagLite::MPI::COMM_WORLD);
+			parallelCount.loopCreate(helperRows);
+		}
 
-		//! contribution to Hamiltonian from current system
-		modelHelper.calcHamiltonianPart(matrixBlock,true);
-		matrix = matrixBlock;
+		SizeType count = 0;
+		for (SizeType row = 0; row < rows; ++row)
+			count += nonZerosPerRow[row];
 
-		//! contribution to Hamiltonian from current envirnoment
-		modelHelper.calcHamiltonianPart(matrixBlock,false);
-		matrix += matrixBlock;
+		matrix.resize(rows, rows, count);
+		count = 0;
+		for (SizeType row = 0; row < rows; ++row) {
+			matrix.setRow(row, count);
+			count += nonZerosPerRow[row];
+		}
 
-		matrixBlock.clear();
+		matrix.setRow(rows, count);
 
-		VerySparseMatrixType vsm(matrix);
-		addHamiltonianConnection(vsm,modelHelper);
+		helperRows.fill();
+		ParallelizerRowsType parallelFill(threads, PsimagLite::MPI::COMM_WORLD);
+		parallelFill.loopCreate(helperRows);
 
-		matrix = vsm;
+		matrix.checkValidity();
 	}
 
 	void addConnectionsInNaturalBasis(SparseMatrixType& hmatrix,
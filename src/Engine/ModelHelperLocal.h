@@ -122,6 +122,7 @@ public:
 	      lrs_(lrs),
 	      targetTime_(targetTime),
 	      threadId_(threadId),
+	      threads_(PsimagLite::Concurrency::npthreads),
 	      buffer_(lrs_.left().size()),
 	      basis2tc_(lrs_.left().numberOfOperators()),
 	      basis3tc_(lrs_.right().numberOfOperators()),
@@ -228,65 +229,34 @@ public:
 	// Does x+= (AB)y, where A belongs to pSprime and B  belongs to pEprime or
 	// viceversa (inter)
 	// Has been changed to accomodate for reflection symmetry
+	// Orientation and fermion sign are resolved here, once per link: rows are
+	// grouped by the fermion sign of their system state, so that the kernel
+	// below is called once per group with the signed value, and has no
+	// branches on them
 	void fastOpProdInter(VectorSparseElementType& x,
 	                     const VectorSparseElementType& y,
 	                     const SparseMatrixType& A,
 	                     const SparseMatrixType& B,
 	                     const LinkType& link) const
 	{
-		RealType fermionSign =  (link.fermionOrBoson==ProgramGlobals::FERMION) ? -1 : 1;
-
-		if (link.type==ProgramGlobals::ENVIRON_SYSTEM)  {
-			LinkType link2 = link;
-			link2.value *= fermionSign;
-			link2.type = ProgramGlobals::SYSTEM_ENVIRON;
-			fastOpProdInter(x,y,B,A,link2);
-			return;
-		}
-
-		//! work only on partition m
-		int m = m_;
-		int offset = lrs_.super().partition(m);
-		int total = lrs_.super().partition(m+1) - offset;
-
-		for (int i=0;i<total;++i) {
-			// row i of the ordered product basis
-			int alpha=alpha_[i];
-			int beta=beta_[i];
-			SparseElementType sum = 0.0;
-			int startkk = B.getRowPtr(beta);
-			int endkk = B.getRowPtr(beta+1);
-			int startk = A.getRowPtr(alpha);
-			int endk = A.getRowPtr(alpha+1);
-			/* fermion signs note:
-			 * here the environ is applied first and has to "cross"
-			 * the system, hence the sign factor pSprime.fermionicSign(alpha,tmp)
-			 */
-
-			SparseElementType fsValue = (fermionSign < 0 && fermionSigns_[i])
-			        ? -link.value
-			        : link.value;
-
-			for (int k=startk;k<endk;++k) {
-				int alphaPrime = A.getCol(k);
-				SparseElementType tmp2 = A.getValue(k) *fsValue;
-				const typename PsimagLite::Vector<int>::Type& bufferTmp =
-				        buffer_[alphaPrime];
-
-				for (int kk=startkk;kk<endkk;++kk) {
-					int betaPrime= B.getCol(kk);
-					int j = bufferTmp[betaPrime];
-					if (j<0) continue;
-
-					SparseElementType tmp = tmp2 * B.getValue(kk);
-					sum += tmp * y[j];
-				}
-			}
-
-			x[i] += sum;
+		bool isFermion = (link.fermionOrBoson == ProgramGlobals::FERMION);
+
+		// ENVIRON_SYSTEM is SYSTEM_ENVIRON with A and B swapped,
+		// and B crossing A if fermionic
+		bool swapped = (link.type == ProgramGlobals::ENVIRON_SYSTEM);
+		const SparseMatrixType& opSystem = (swapped) ? B : A;
+		const SparseMatrixType& opEnviron = (swapped) ? A : B;
+		SparseElementType value = (swapped && isFermion) ? -link.value : link.value;
+		SizeType total = rowsBySign_.size();
+
+		if (isFermion) {
+			fastOpProdInterKernel(x, y, opSystem, opEnviron, value, 0, evenRows_);
+			fastOpProdInterKernel(x, y, opSystem, opEnviron, -value, evenRows_, total);
+		} else {
+			fastOpProdInterKernel(x, y, opSystem, opEnviron, value, 0, total);
 		}
 
-		kroneckerDumper_.push(A,B,link.value,link.fermionOrBoson,y);
+		kroneckerDumper_.push(opSystem, opEnviron, value, link.fermionOrBoson, y);
 	}
 
 	// Let H_{alpha,beta; alpha',beta'} =
@@ -422,10 +392,56 @@ public:
 
 	SizeType threadId() const { return threadId_; }
 
+	// Threads for the matrix vector products of this helper
+	SizeType threads() const { return threads_; }
+
+	void threads(SizeType n) { threads_ = n; }
+
 	const LinkProductStructType& lps() const { return lps_; }
 
 private:
 
+	// Does x += (AB)y, where A belongs to pSprime and B belongs to pEprime,
+	// for the rows rowsBySign_[first] to rowsBySign_[last - 1], which must all
+	// have the same fermion sign, already included in value
+	void fastOpProdInterKernel(VectorSparseElementType& x,
+	                           const VectorSparseElementType& y,
+	                           const SparseMatrixType& A,
+	                           const SparseMatrixType& B,
+	                           const SparseElementType& value,
+	                           SizeType first,
+	                           SizeType last) const
+	{
+		for (SizeType r=first;r<last;++r) {
+			// row i of the ordered product basis
+			int i = rowsBySign_[r];
+			int alpha=alpha_[i];
+			int beta=beta_[i];
+			SparseElementType sum = 0.0;
+			int startkk = B.getRowPtr(beta);
+			int endkk = B.getRowPtr(beta+1);
+			int startk = A.getRowPtr(alpha);
+			int endk = A.getRowPtr(alpha+1);
+
+			for (int k=startk;k<endk;++k) {
+				int alphaPrime = A.getCol(k);
+				SparseElementType tmp2 = A.getValue(k) *value;
+				const typename PsimagLite::Vector<int>::Type& bufferTmp =
+				        buffer_[alphaPrime];
+
+				for (int kk=startkk;kk<endkk;++kk) {
+					int betaPrime= B.getCol(kk);
+					int j = bufferTmp[betaPrime];
+					if (j<0) continue;
+
+					sum += tmp2 * B.getValue(kk) * y[j];
+				}
+			}
+
+			x[i] += sum;
+		}
+	}
+
 	const SparseMatrixType& getTcOperator(int i,SizeType sigma,SizeType type) const
 	{
 		if (type==System) {
@@ -503,16 +519,33 @@ private:
 			int fs = lrs_.left().fermionicSign(alpha_[i],-1);
 			fermionSigns_[i] = (fs < 0) ? true : false;
 		}
+
+		/* fermion signs note:
+		 * the environ is applied first and has to "cross"
+		 * the system, hence the sign factor pSprime.fermionicSign(alpha,tmp);
+		 * rows with sign +1 go first, each group in increasing order
+		 */
+		rowsBySign_.resize(total);
+		evenRows_ = 0;
+		for (int i=0;i<total;i++)
+			if (!fermionSigns_[i]) rowsBySign_[evenRows_++] = i;
+
+		SizeType odd = evenRows_;
+		for (int i=0;i<total;i++)
+			if (fermionSigns_[i]) rowsBySign_[odd++] = i;
 	}
 
 	int m_;
 	const LeftRightSuperType& lrs_;
 	RealType targetTime_;
 	SizeType threadId_;
+	SizeType threads_;
 	typename PsimagLite::Vector<PsimagLite::Vector<int>::Type>::Type buffer_;
 	VectorSparseMatrixType basis2tc_,basis3tc_;
 	typename PsimagLite::Vector<SizeType>::Type alpha_,beta_;
 	typename PsimagLite::Vector<bool>::Type fermionSigns_;
+	typename PsimagLite::Vector<int>::Type rowsBySign_;
+	SizeType evenRows_;
 	mutable KroneckerDumperType kroneckerDumper_;
 	mutable LinkProductStructType lps_;
 }; // class ModelHelperLocal
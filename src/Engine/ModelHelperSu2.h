@@ -75,6 +75,7 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "Su2Reduced.h"
 #include "Link.h"
 #include "LinkProductStruct.h"
+#include "Concurrency.h"
 
 /** \ingroup DMRG */
 /*@{*/
@@ -92,6 +93,7 @@ template<typename LeftRightSuperType_>
 class ModelHelperSu2  {
 
 	typedef std::pair<SizeType,SizeType> PairType;
+	typedef typename PsimagLite::Vector<SizeType>::Type VectorSizeType;
 
 public:
 
@@ -121,8 +123,11 @@ public:
 	      lrs_(lrs),
 	      targetTime_(targetTime),
 	      threadId_(threadId),
+	      threads_(PsimagLite::Concurrency::npthreads),
 	      su2reduced_(m,lrs)
-	{}
+	{
+		createRows();
+	}
 
 	static bool isSu2() { return true; }
 
@@ -232,71 +237,29 @@ public:
 	// Does x+= (AB)y, where A belongs to pSprime and B
 	// belongs to pEprime or viceversa (inter)
 	// Has been changed to accomodate for reflection symmetry
+	// Orientation and fermion sign are resolved here, once per link: the
+	// kernel below is instantiated per orientation, and called once per group
+	// of rows of the same fermion sign, with the signed value
 	void fastOpProdInter(VectorSparseElementType& x,
 	                     const VectorSparseElementType& y,
 	                     SparseMatrixType const &A,
 	                     SparseMatrixType const &B,
-	                     const LinkType& link,
-	                     bool flipped=false) const
+	                     const LinkType& link) const
 	{
-		//int const SystemEnviron=1,EnvironSystem=2;
-		RealType fermionSign =  (link.fermionOrBoson==ProgramGlobals::FERMION) ? -1 : 1;
-
-		if (link.type == ProgramGlobals::ENVIRON_SYSTEM)  {
-			LinkType link2 = link;
-			link2.value *= fermionSign;
-			link2.type = ProgramGlobals::SYSTEM_ENVIRON;
-			fastOpProdInter(x,y,B,A,link2,true);
-			return;
-		}
-
-		//! work only on partition m
-		int m = m_;
-		int offset = lrs_.super().partition(m);
-
-		for (SizeType i=0;i<su2reduced_.reducedEffectiveSize();i++) {
-			int ix = su2reduced_.flavorMapping(i)-offset;
-			if (ix<0 || ix>=int(x.size())) continue;
-
-			SizeType i1=su2reduced_.reducedEffective(i).first;
-			SizeType i2=su2reduced_.reducedEffective(i).second;
-			PairType jm1 = lrs_.left().jmValue(lrs_.left().reducedIndex(i1));
-			SizeType n1=lrs_.left().electrons(lrs_.left().reducedIndex(i1));
-			RealType fsign=1;
-
-			if (n1>0 && n1%2!=0) fsign= fermionSign;
-
-			PairType jm2 = lrs_.right().jmValue(lrs_.right().reducedIndex(i2));
-			SizeType lf1 =jm1.first + jm2.first*lrs_.left().jMax();
-
-			for (int k1=A.getRowPtr(i1);k1<A.getRowPtr(i1+1);k1++) {
-				SizeType i1prime = A.getCol(k1);
-				PairType jm1prime = lrs_.left().jmValue(lrs_.left().
-				                                        reducedIndex(i1prime));
-
-				for (int k2=B.getRowPtr(i2);k2<B.getRowPtr(i2+1);k2++) {
-					SizeType i2prime = B.getCol(k2);
-					PairType jm2prime = lrs_.right().jmValue(lrs_.right().
-					                                         reducedIndex(i2prime));
-					SparseElementType lfactor;
-					SizeType lf2 =jm1prime.first + jm2prime.first*lrs_.left().jMax();
-
-					lfactor=su2reduced_.reducedFactor(link.angularMomentum,
-					                                  link.category,
-					                                  flipped,
-					                                  lf1,
-					                                  lf2);
-					if (lfactor==static_cast<SparseElementType>(0)) continue;
-					lfactor *= link.angularFactor;
-
-					int jx = su2reduced_.flavorMapping(i1prime,i2prime)-offset;
-					if (jx<0 || jx >= int(y.size()) ) continue;
-
-					x[ix] += fsign*link.value*lfactor*
-					        A.getValue(k1)*B.getValue(k2)*y[jx];
-				}
-			}
-		}
+		bool isFermion = (link.fermionOrBoson == ProgramGlobals::FERMION);
+
+		// ENVIRON_SYSTEM is SYSTEM_ENVIRON with A and B swapped,
+		// and B crossing A if fermionic
+		bool flipped = (link.type == ProgramGlobals::ENVIRON_SYSTEM);
+		const SparseMatrixType& opSystem = (flipped) ? B : A;
+		const SparseMatrixType& opEnviron = (flipped) ? A : B;
+		SparseElementType value = (flipped && isFermion) ? -link.value : link.value;
+		value *= link.angularFactor;
+
+		if (flipped)
+			fastOpProdInterSigned<true>(x, y, opSystem, opEnviron, link, value, isFermion);
+		else
+			fastOpProdInterSigned<false>(x, y, opSystem, opEnviron, link, value, isFermion);
 	}
 
 	// Let H_{alpha,beta; alpha',beta'} = basis2.hamiltonian_{alpha,alpha'}
@@ -472,16 +435,128 @@ public:
 
 	SizeType threadId() const { return threadId_; }
 
+	// Threads for the matrix vector products of this helper
+	SizeType threads() const { return threads_; }
+
+	void threads(SizeType n) { threads_ = n; }
+
 	const LinkProductStructType& lps() const { return lps_; }
 
 private:
 
+	template<bool flipped>
+	void fastOpProdInterSigned(VectorSparseElementType& x,
+	                           const VectorSparseElementType& y,
+	                           SparseMatrixType const &A,
+	                           SparseMatrixType const &B,
+	                           const LinkType& link,
+	                           const SparseElementType& value,
+	                           bool isFermion) const
+	{
+		SizeType total = rowsBySign_.size();
+		if (isFermion) {
+			fastOpProdInterKernel<flipped>(x, y, A, B, link, value, 0, evenRows_);
+			fastOpProdInterKernel<flipped>(x, y, A, B, link, -value, evenRows_, total);
+		} else {
+			fastOpProdInterKernel<flipped>(x, y, A, B, link, value, 0, total);
+		}
+	}
+
+	// Does x += (AB)y, where A belongs to pSprime and B belongs to pEprime,
+	// for the reduced rows rowsBySign_[first] to rowsBySign_[last - 1], which
+	// must all have the same fermion sign; value includes the fermion sign and
+	// the angular factor of the link
+	template<bool flipped>
+	void fastOpProdInterKernel(VectorSparseElementType& x,
+	                           const VectorSparseElementType& y,
+	                           SparseMatrixType const &A,
+	                           SparseMatrixType const &B,
+	                           const LinkType& link,
+	                           const SparseElementType& value,
+	                           SizeType first,
+	                           SizeType last) const
+	{
+		//! work only on partition m
+		int offset = lrs_.super().partition(m_);
+
+		for (SizeType r=first;r<last;r++) {
+			SizeType i = rowsBySign_[r];
+			int ix = su2reduced_.flavorMapping(i)-offset;
+			SizeType i1=su2reduced_.reducedEffective(i).first;
+			SizeType i2=su2reduced_.reducedEffective(i).second;
+			SizeType lf1 =leftJ_[i1] + rightJ_[i2]*jMax_;
+
+			for (int k1=A.getRowPtr(i1);k1<A.getRowPtr(i1+1);k1++) {
+				SizeType i1prime = A.getCol(k1);
+				SizeType j1prime = leftJ_[i1prime];
+				SparseElementType tmp1 = value*A.getValue(k1);
+
+				for (int k2=B.getRowPtr(i2);k2<B.getRowPtr(i2+1);k2++) {
+					SizeType i2prime = B.getCol(k2);
+					SizeType lf2 =j1prime + rightJ_[i2prime]*jMax_;
+
+					SparseElementType lfactor=su2reduced_.reducedFactor(link.angularMomentum,
+					                                                    link.category,
+					                                                    flipped,
+					                                                    lf1,
+					                                                    lf2);
+					if (lfactor==static_cast<SparseElementType>(0)) continue;
+
+					int jx = su2reduced_.flavorMapping(i1prime,i2prime)-offset;
+					if (jx<0 || jx >= int(y.size()) ) continue;
+
+					x[ix] += tmp1*lfactor*B.getValue(k2)*y[jx];
+				}
+			}
+		}
+	}
+
+	// Tables for the kernel: j of each reduced state, and the reduced rows
+	// of this partition, those with an even number of electrons in the
+	// system first
+	void createRows()
+	{
+		const BasisType& left = lrs_.left();
+		const BasisType& right = lrs_.right();
+		leftJ_.resize(left.reducedSize());
+		for (SizeType i = 0; i < leftJ_.size(); ++i)
+			leftJ_[i] = left.jmValue(left.reducedIndex(i)).first;
+
+		rightJ_.resize(right.reducedSize());
+		for (SizeType i = 0; i < rightJ_.size(); ++i)
+			rightJ_[i] = right.jmValue(right.reducedIndex(i)).first;
+
+		jMax_ = left.jMax();
+
+		int offset = lrs_.super().partition(m_);
+		int total = size();
+		VectorSizeType odd;
+		rowsBySign_.clear();
+		for (SizeType i=0;i<su2reduced_.reducedEffectiveSize();i++) {
+			int ix = su2reduced_.flavorMapping(i)-offset;
+			if (ix<0 || ix>=total) continue;
+			SizeType i1=su2reduced_.reducedEffective(i).first;
+			SizeType n1=left.electrons(left.reducedIndex(i1));
+			if (n1 & 1) odd.push_back(i);
+			else rowsBySign_.push_back(i);
+		}
+
+		evenRows_ = rowsBySign_.size();
+		rowsBySign_.insert(rowsBySign_.end(), odd.begin(), odd.end());
+	}
+
 	int m_;
 	const LeftRightSuperType&  lrs_;
 	RealType targetTime_;
 	SizeType threadId_;
+	SizeType threads_;
 	Su2Reduced<LeftRightSuperType> su2reduced_;
 	LinkProductStructType lps_;
+	VectorSizeType leftJ_;
+	VectorSizeType rightJ_;
+	SizeType jMax_;
+	VectorSizeType rowsBySign_;
+	SizeType evenRows_;
 };
 } // namespace Dmrg
 /*@}*/
@@ -0,0 +1,399 @@
+#ifndef DMRG_OBSERVABLES_IN_SWEEP_H
+#define DMRG_OBSERVABLES_IN_SWEEP_H
+#include "Braket.h"
+#include "FermionSign.h"
+#include "PackIndices.h"
+#include "MemoryAccounting.h"
+#include "RowAccumulator.h"
+
+namespace Dmrg {
+
+// One-point and two-point observables measured during the last finite loop
+//
+// With InSweepObservables=<gs|n|gs>,<gs|c';c|gs> in the input, the last finite
+// loop, which must go from left to right, measures the observables with the
+// live LeftRightSuper and ground state after each step, so that no
+// transforms need to be saved for the observe program. A two-point
+// observable <A_i B_j> is computed for i <= j: the operator A of each site
+// already in the system block is carried in the basis of the block, and
+// transformed with each step's truncation. Fermion signs follow the
+// Jordan-Wigner ordering of the sites from left to right.
+// Sites in the initial system block of one site, and in the final
+// environ block of one site are measured too; other sites not visited by the
+// last loop are not.
+template<typename LeftRightSuperType, typename ModelType>
+class ObservablesInSweep {
+
+	typedef typename LeftRightSuperType::BasisWithOperatorsType BasisWithOperatorsType;
+	typedef typename LeftRightSuperType::BasisType BasisType;
+	typedef typename LeftRightSuperType::OperatorType OperatorType;
+	typedef typename OperatorType::SparseMatrixType SparseMatrixType;
+	typedef typename SparseMatrixType::value_type ComplexOrRealType;
+	typedef typename PsimagLite::Real<ComplexOrRealType>::Type RealType;
+	typedef PsimagLite::Matrix<ComplexOrRealType> MatrixType;
+	typedef typename PsimagLite::Vector<SparseMatrixType>::Type VectorSparseMatrixType;
+	typedef typename PsimagLite::Vector<SizeType>::Type VectorSizeType;
+	typedef PsimagLite::Vector<PsimagLite::String>::Type VectorStringType;
+	typedef Braket<ModelType> BraketType;
+	typedef PsimagLite::PackIndices PackIndicesType;
+	typedef RowAccumulator<SparseMatrixType> RowAccumulatorType;
+
+	struct ObservableType {
+
+		ObservableType() : points(0), abSign(1) {}
+
+		PsimagLite::String label;
+		SizeType points;
+		OperatorType a;
+		OperatorType b;
+		SparseMatrixType ab; // a*b, for i == j
+		int abSign;
+		MatrixType values;
+		VectorSparseMatrixType carried; // a of site i, in the basis of the system
+	};
+
+	typedef typename PsimagLite::Vector<ObservableType>::Type VectorObservableType;
+
+public:
+
+	ObservablesInSweep(const ModelType& model, PsimagLite::String list)
+	    : model_(model), firstSite_(-1), lastSite_(-1)
+	{
+		if (list == "") return;
+
+		SizeType n = model_.geometry().numberOfSites();
+		VectorStringType vecStr;
+		PsimagLite::split(vecStr, list, ",");
+		for (SizeType i = 0; i < vecStr.size(); ++i) {
+			PsimagLite::String label = vecStr[i];
+			if (label.length() == 0) continue;
+			if (label[0] != '<') label = "<gs|" + label + "|gs>";
+			BraketType braket(model_, label);
+			if (braket.bra() != "gs" || braket.ket() != "gs")
+				err("InSweepObservables: only <gs|...|gs> supported, not " + label + "\n");
+
+			ObservableType o;
+			o.label = label;
+			o.points = braket.points();
+			if (o.points < 1 || o.points > 2)
+				err("InSweepObservables: only one and two points supported, not " +
+				    label + "\n");
+
+			o.a = braket.op(0);
+			if (o.points == 1) {
+				o.values.resize(n, 1);
+				observables_.push_back(o);
+				continue;
+			}
+
+			o.b = braket.op(1);
+			multiply(o.ab, o.a.data, o.b.data);
+			o.abSign = o.a.fermionSign*o.b.fermionSign;
+			o.values.resize(n, n);
+			o.carried.resize(n);
+			observables_.push_back(o);
+		}
+	}
+
+	bool enabled() const { return (observables_.size() > 0); }
+
+	// Measures at the site just added to the system, with the basis of
+	// lrs before truncation, and carries the operators with transform
+	template<typename VectorWithOffsetType>
+	void measure(const LeftRightSuperType& lrs,
+	             const VectorWithOffsetType& psi,
+	             const SparseMatrixType& transform)
+	{
+		if (!enabled()) return;
+		if (BasisType::useSu2Symmetry())
+			err("InSweepObservables: not when SU(2) symmetry is in use\n");
+
+		const BasisWithOperatorsType& left = lrs.left();
+		SizeType blockSize = left.block().size();
+		assert(blockSize > 1);
+		SizeType site = left.block()[blockSize - 1];
+		SizeType hilbert = model_.hilbertSize(site);
+		SizeType ni = left.size()/hilbert;
+		if (ni*hilbert != left.size())
+			err("InSweepObservables: needs SitesPerBlock=1\n");
+
+		VectorSizeType electrons;
+		model_.findElectronsOfOneSite(electrons, site);
+		FermionSign fsOld(left, electrons);
+		FermionSign fsSite(electrons);
+
+		SizeType edge = left.block()[0];
+		bool hasEdge = (firstSite_ < 0 &&
+		                blockSize == 2 &&
+		                ni == model_.hilbertSize(edge));
+		if (firstSite_ < 0) firstSite_ = (hasEdge) ? edge : site;
+		lastSite_ = site;
+
+		SparseMatrixType transformC;
+		transposeConjugate(transformC, transform);
+		SizeType total = 0;
+		for (SizeType x = 0; x < observables_.size(); ++x) {
+			ObservableType& o = observables_[x];
+			check(o.a, site);
+			if (hasEdge) measureEdge(o, lrs, psi, edge, hilbert);
+
+			SparseMatrixType c;
+			SparseMatrixType oldParity;
+			diagonal(oldParity, fsOld, o.a.fermionSign);
+			if (o.points == 1) {
+				fluffUp(c, oldParity, o.a.data, left);
+				o.values(site, 0) = bracketSystem(c, lrs, psi);
+				measureCorner(o, lrs, psi);
+				continue;
+			}
+
+			check(o.b, site);
+			SparseMatrixType siteParity;
+			diagonal(siteParity, fsSite, o.b.fermionSign);
+
+			// <A_i B_site> for i < site, and A_i grown with the sign of site
+			for (SizeType i = 0; i < site; ++i) {
+				if (o.carried[i].rows() == 0) continue;
+				fluffUp(c, o.carried[i], o.b.data, left);
+				o.values(i, site) = bracketSystem(c, lrs, psi);
+				fluffUp(c, o.carried[i], siteParity, left);
+				o.carried[i] = c;
+			}
+
+			diagonal(oldParity, fsOld, o.abSign);
+			fluffUp(c, oldParity, o.ab, left);
+			o.values(site, site) = bracketSystem(c, lrs, psi);
+
+			SparseMatrixType aSign;
+			multiply(aSign, o.a.data, siteParity);
+			fluffUp(o.carried[site], oldParity, aSign, left);
+
+			measureCorner(o, lrs, psi);
+
+			for (SizeType i = 0; i <= site; ++i) {
+				if (o.carried[i].rows() == 0) continue;
+				SparseMatrixType tmp;
+				multiply(tmp, transformC, o.carried[i]);
+				multiply(o.carried[i], tmp, transform);
+				total += MemoryAccounting::bytes(o.carried[i]);
+			}
+		}
+
+		MemoryAccounting::peak("inSweep", total);
+	}
+
+	void print(std::ostream& os) const
+	{
+		if (!enabled()) return;
+		os<<"#InSweepObservables sites="<<firstSite_<<"-"<<lastSite_<<"\n";
+		for (SizeType x = 0; x < observables_.size(); ++x) {
+			const ObservableType& o = observables_[x];
+			if (o.points == 2) {
+				os<<o.label<<"\n";
+				os<<o.values;
+				continue;
+			}
+
+			os<<"site "<<o.label<<"\n";
+			if (firstSite_ < 0) continue;
+			for (int i = firstSite_; i <= lastSite_; ++i)
+				os<<i<<" "<<o.values(i, 0)<<"\n";
+		}
+	}
+
+private:
+
+	void check(const OperatorType& op, SizeType site) const
+	{
+		if (op.data.rows() == model_.hilbertSize(site)) return;
+		err("InSweepObservables: operator does not match site " + ttos(site) + "\n");
+	}
+
+	// Sites of the initial system block of one site, whose basis is
+	// that of the site
+	template<typename VectorWithOffsetType>
+	void measureEdge(ObservableType& o,
+	                 const LeftRightSuperType& lrs,
+	                 const VectorWithOffsetType& psi,
+	                 SizeType edge,
+	                 SizeType hilbert)
+	{
+		const BasisWithOperatorsType& left = lrs.left();
+		SparseMatrixType id(hilbert, hilbert);
+		id.makeDiagonal(hilbert, 1.0);
+		SparseMatrixType c;
+		if (o.points == 1) {
+			fluffUp(c, o.a.data, id, left);
+			o.values(edge, 0) = bracketSystem(c, lrs, psi);
+			return;
+		}
+
+		fluffUp(c, o.ab, id, left);
+		o.values(edge, edge) = bracketSystem(c, lrs, psi);
+
+		VectorSizeType electrons;
+		model_.findElectronsOfOneSite(electrons, edge);
+		FermionSign fsEdge(electrons);
+		SparseMatrixType edgeParity;
+		diagonal(edgeParity, fsEdge, o.b.fermionSign);
+		multiply(o.carried[edge], o.a.data, edgeParity);
+	}
+
+	// The site of the final environ block of one site
+	template<typename VectorWithOffsetType>
+	void measureCorner(ObservableType& o,
+	                   const LeftRightSuperType& lrs,
+	                   const VectorWithOffsetType& psi)
+	{
+		const BasisWithOperatorsType& right = lrs.right();
+		if (right.block().size() != 1) return;
+		SizeType corner = right.block()[0];
+		if (right.size() != model_.hilbertSize(corner)) return;
+		lastSite_ = corner;
+
+		FermionSign fsLeft(lrs.left().electronsVector(BasisType::AFTER_TRANSFORM));
+		SparseMatrixType leftParity;
+		if (o.points == 1) {
+			diagonal(leftParity, fsLeft, o.a.fermionSign);
+			o.values(corner, 0) = bracketCorner(leftParity, o.a.data, lrs, psi);
+			return;
+		}
+
+		diagonal(leftParity, fsLeft, o.abSign);
+		o.values(corner, corner) = bracketCorner(leftParity, o.ab, lrs, psi);
+
+		// carried operators already hold the signs of all sites in the system
+		for (SizeType i = 0; i < corner; ++i) {
+			if (o.carried[i].rows() == 0) continue;
+			o.values(i, corner) = bracketCorner(o.carried[i], o.b.data, lrs, psi);
+		}
+	}
+
+	static void diagonal(SparseMatrixType& m, const FermionSign& fs, int f)
+	{
+		SizeType n = fs.size();
+		m.resize(n, n);
+		for (SizeType i = 0; i < n; ++i) {
+			m.setRow(i, i);
+			m.pushCol(i);
+			m.pushValue(fs(i, f));
+		}
+
+		m.setRow(n, n);
+		m.checkValidity();
+	}
+
+	// result = oldBlock (x) site in the basis of left
+	static void fluffUp(SparseMatrixType& result,
+	                    const SparseMatrixType& oldBlock,
+	                    const SparseMatrixType& site,
+	                    const BasisWithOperatorsType& left)
+	{
+		SizeType ni = oldBlock.rows();
+		SizeType n = left.size();
+		assert(ni*site.rows() == n);
+		result.resize(n, n);
+
+		RowAccumulatorType accumulator(n);
+		PackIndicesType pack(ni);
+		SizeType counter = 0;
+		for (SizeType r = 0; r < n; ++r) {
+			SizeType e = 0;
+			SizeType u = 0;
+			pack.unpack(e, u, left.permutation(r));
+			result.setRow(r, counter);
+			for (int k = oldBlock.getRowPtr(e); k < oldBlock.getRowPtr(e + 1); ++k) {
+				SizeType e2 = oldBlock.getCol(k);
+				for (int k2 = site.getRowPtr(u); k2 < site.getRowPtr(u + 1); ++k2) {
+					SizeType u2 = site.getCol(k2);
+					SizeType r2 = left.permutationInverse(e2 + u2*ni);
+					accumulator.add(r2, oldBlock.getValue(k)*site.getValue(k2));
+				}
+			}
+
+			accumulator.flush(result, counter);
+		}
+
+		result.setRow(n, counter);
+		result.checkValidity();
+	}
+
+	// <psi|a (x) 1|psi>
+	template<typename VectorWithOffsetType>
+	static ComplexOrRealType bracketSystem(const SparseMatrixType& a,
+	                                       const LeftRightSuperType& lrs,
+	                                       const VectorWithOffsetType& psi)
+	{
+		ComplexOrRealType sum = 0.0;
+		SizeType leftSize = lrs.left().size();
+		PackIndicesType pack(leftSize);
+		for (SizeType x = 0; x < psi.sectors(); ++x) {
+			SizeType sector = psi.sector(x);
+			SizeType offset = psi.offset(sector);
+			SizeType total = offset + psi.effectiveSize(sector);
+			for (SizeType t = offset; t < total; ++t) {
+				SizeType r = 0;
+				SizeType eta = 0;
+				pack.unpack(r, eta, lrs.super().permutation(t));
+				for (int k = a.getRowPtr(r); k < a.getRowPtr(r + 1); ++k) {
+					SizeType t2 = lrs.super().permutationInverse(a.getCol(k) + eta*leftSize);
+					if (t2 < offset || t2 >= total) continue;
+					sum += a.getValue(k)*PsimagLite::conj(psi.slowAccess(t))*
+					        psi.slowAccess(t2);
+				}
+			}
+		}
+
+		return sum/norm2(psi);
+	}
+
+	// <psi|a (x) b|psi>
+	template<typename VectorWithOffsetType>
+	static ComplexOrRealType bracketCorner(const SparseMatrixType& a,
+	                                       const SparseMatrixType& b,
+	                                       const LeftRightSuperType& lrs,
+	                                       const VectorWithOffsetType& psi)
+	{
+		ComplexOrRealType sum = 0.0;
+		SizeType leftSize = lrs.left().size();
+		PackIndicesType pack(leftSize);
+		for (SizeType x = 0; x < psi.sectors(); ++x) {
+			SizeType sector = psi.sector(x);
+			SizeType offset = psi.offset(sector);
+			SizeType total = offset + psi.effectiveSize(sector);
+			for (SizeType t = offset; t < total; ++t) {
+				SizeType r = 0;
+				SizeType eta = 0;
+				pack.unpack(r, eta, lrs.super().permutation(t));
+				for (int k = a.getRowPtr(r); k < a.getRowPtr(r + 1); ++k) {
+					SizeType r2 = a.getCol(k);
+					for (int k2 = b.getRowPtr(eta); k2 < b.getRowPtr(eta + 1); ++k2) {
+						SizeType t2 = lrs.super().permutationInverse(r2 +
+						                                             b.getCol(k2)*leftSize);
+						if (t2 < offset || t2 >= total) continue;
+						sum += a.getValue(k)*b.getValue(k2)*
+						        PsimagLite::conj(psi.slowAccess(t))*psi.slowAccess(t2);
+					}
+				}
+			}
+		}
+
+		return sum/norm2(psi);
+	}
+
+	template<typename VectorWithOffsetType>
+	static RealType norm2(const VectorWithOffsetType& psi)
+	{
+		ComplexOrRealType tmp = psi*psi;
+		RealType norma2 = PsimagLite::real(tmp);
+		assert(fabs(norma2) > 1e-10);
+		return norma2;
+	}
+
+	const ModelType& model_;
+	VectorObservableType observables_;
+	int firstSite_;
+	int lastSite_;
+}; // class ObservablesInSweep
+} // namespace Dmrg
+#endif // DMRG_OBSERVABLES_IN_SWEEP_H
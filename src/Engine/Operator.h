@@ -87,6 +87,7 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "InputNg.h"
 #include "InputCheck.h"
 #include "CanonicalExpression.h"
+#include "MemoryAccounting.h"
 
 namespace Dmrg {
 
@@ -239,6 +240,11 @@ struct Operator {
 		return total;
 	}
 
+	SizeType memoryUsage() const
+	{
+		return MemoryAccounting::bytes(data);
+	}
+
 	void conjugate()
 	{
 		SparseMatrixType data2 = data;
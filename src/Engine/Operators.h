@@ -85,6 +85,7 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "Complex.h"
 #include "Concurrency.h"
 #include "Parallelizer.h"
+#include "SharedOperators.h"
 
 namespace Dmrg {
 /* PSIDOC Operators
@@ -125,14 +126,15 @@ public:
 	typedef typename PsimagLite::Vector<RealType>::Type VectorRealType;
 	typedef typename PsimagLite::Vector<SizeType>::Type VectorSizeType;
 	typedef std::pair<SizeType,SizeType> PairSizeSizeType;
-
+	typedef typename PsimagLite::Vector<OperatorType>::Type VectorOperatorType;
+	typedef SharedOperators<OperatorType> SharedOperatorsType;
 	class MyLoop {
 
 	public:
 
 		MyLoop(bool useSu2Symmetry,
 		       ReducedOperatorsType& reducedOpImpl,
-		       typename PsimagLite::Vector<OperatorType>::Type& operators,
+		       SharedOperatorsType& operators,
 		       const BlockDiagonalMatrixType& ftransform1,
 		       const BasisType* thisBasis1,
 		       const PairSizeSizeType& startEnd)
@@ -151,12 +153,12 @@ public:
 		{
 			SizeType k = taskNumber;
 			if (isExcluded(k) && k < operators_.size()) {
-				operators_[k].data.clear();
+				operators_.clearData(k);
 				return;
 			}
 
 			if (!useSu2Symmetry_)
-				reducedOpImpl_.changeBasis(operators_[k].data);
+				reducedOpImpl_.changeBasis(operators_.modify(k).data);
 			else
 				reducedOpImpl_.changeBasis(k);
 		}
@@ -194,19 +196,22 @@ public:
 		void gatherOperators()
 		{
 			if (!hasMpi_) return;
-			PsimagLite::MPI::pointByPointGather(operators_);
+			VectorOperatorType ops;
+			operators_.get(ops);
+			PsimagLite::MPI::pointByPointGather(ops);
+			operators_.set(ops);
 		}
 
 		void bcastOperators()
 		{
 			if (!hasMpi_) return;
 			for (SizeType i = 0; i < operators_.size(); i++)
-				Dmrg::bcast(operators_[i]);
+				Dmrg::bcast(operators_.modify(i));
 		}
 
 		bool useSu2Symmetry_;
 		ReducedOperatorsType& reducedOpImpl_;
-		typename PsimagLite::Vector<OperatorType>::Type& operators_;
+		SharedOperatorsType& operators_;
 		const BlockDiagonalMatrixType& ftransform;
 		const BasisType* thisBasis;
 		bool hasMpi_;
@@ -234,7 +239,7 @@ public:
 
 		announceChangeAll();
 
-		if (!useSu2Symmetry_) io.read(operators_,"#OPERATORS");
+		if (!useSu2Symmetry_) readOperators(io);
 
 		io.read(hamiltonian_, "#HAMILTONIAN");
 		reducedOpImpl_.setHamiltonian(hamiltonian_);
@@ -246,7 +251,7 @@ public:
 	          PsimagLite::IsInputLike<IoInputter>::True, int>::Type = 0)
 	{
 		if (!useSu2Symmetry_)
-			io.read(operators_,"#OPERATORS");
+			readOperators(io);
 		else reducedOpImpl_.load(io);
 
 		io.read(hamiltonian_, "#HAMILTONIAN");
@@ -255,7 +260,7 @@ public:
 
 	void setOperators(const typename PsimagLite::Vector<OperatorType>::Type& ops)
 	{
-		if (!useSu2Symmetry_) operators_=ops;
+		if (!useSu2Symmetry_) operators_.set(ops);
 		else reducedOpImpl_.setOperators(ops);
 	}
 
@@ -304,7 +309,7 @@ public:
 	void reorder(const   VectorSizeType& permutation)
 	{
 		for (SizeType k=0;k<numberOfOperators();k++) {
-			if (!useSu2Symmetry_) reorder(operators_[k].data,permutation);
+			if (!useSu2Symmetry_) reorder(operators_.modify(k).data,permutation);
 			reducedOpImpl_.reorder(k,permutation);
 		}
 		reorder(hamiltonian_,permutation);
@@ -358,12 +363,13 @@ public:
 	                     ApplyFactorsType& apply)
 	{
 		assert(!useSu2Symmetry_);
-		PsimagLite::externalProduct(operators_[i].data,m.data,x,fermionicSigns,option);
+		OperatorType& op = operators_.modify(i);
+		PsimagLite::externalProduct(op.data,m.data,x,fermionicSigns,option);
 		// don't forget to set fermion sign and j:
-		operators_[i].fermionSign=m.fermionSign;
-		operators_[i].jm=m.jm;
-		operators_[i].angularFactor=m.angularFactor;
-		apply(operators_[i].data);
+		op.fermionSign=m.fermionSign;
+		op.jm=m.jm;
+		op.angularFactor=m.angularFactor;
+		apply(op.data);
 	}
 
 	void externalProductReduced(SizeType i,
@@ -432,7 +438,7 @@ public:
 	          typename PsimagLite::EnableIf<
 	          PsimagLite::IsOutputLike<IoOutputter>::True, int>::Type = 0) const
 	{
-		if (!useSu2Symmetry_) io.write(operators_,"#OPERATORS");
+		if (!useSu2Symmetry_) operators_.write(io,"#OPERATORS");
 		else reducedOpImpl_.save(io,s);
 		io.write(hamiltonian_, "#HAMILTONIAN");
 	}
@@ -449,8 +455,24 @@ public:
 
 	SizeType size() const { return operators_.size(); }
 
+	SizeType memoryUsage() const
+	{
+		return MemoryAccounting::bytes(hamiltonian_) +
+		        reducedOpImpl_.memoryUsage() +
+		        operators_.memoryUsage();
+	}
+
 private:
 
+	// identical operators, such as those cleared, share storage after reading
+	template<typename IoInputter>
+	void readOperators(IoInputter& io)
+	{
+		VectorOperatorType ops;
+		io.read(ops,"#OPERATORS");
+		operators_.set(ops);
+	}
+
 	void reorder(SparseMatrixType &v,const   VectorSizeType& permutation)
 	{
 		if (v.rows() == 0 || v.cols() == 0) {
@@ -479,7 +501,7 @@ private:
 
 	bool useSu2Symmetry_;
 	ReducedOperatorsType reducedOpImpl_;
-	typename PsimagLite::Vector<OperatorType>::Type operators_;
+	SharedOperatorsType operators_;
 	SparseMatrixType hamiltonian_;
 	PsimagLite::ProgressIndicator progress_;
 }; //class Operators
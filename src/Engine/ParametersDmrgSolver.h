@@ -108,6 +108,48 @@ of doing \verb!git rev-parse HEAD!.
  and if it
 exits it will be truncated.
 
+\item[Profiler=string] Optional. Either json or csv. Writes the time and
+number of calls of the main phases of each step, of each finite loop, and of
+the run, together with the peak memory, to Profile followed by the output
+file name, with extension json or csv. Default is no profiling.
+
+\item[MemoryBudget=integer] Optional. Memory budget in MB for the stacks,
+operators, Kron structures, Lanczos vectors and WFT stacks, whose sizes are
+printed after each step. When the budget is approached, the oldest entries
+of the system and environ stacks are moved to disk, as with diskstacks.
+Default is 0, meaning no budget.
+
+\item[InSweepObservables=string] Optional. A comma-separated list of
+one-point and two-point brakets, for example \verb!<gs|n|gs>,<gs|c';c|gs>!,
+or just \verb!n,c';c!, measured in the ground state during the last finite
+loop, which must go to the right, and printed at the end of the run and to
+the output file. Two-point brakets are computed for $i\le j$ and, unlike the
+observe program, do not need the transforms to be saved, but keep
+one operator per site in memory while the loop runs.
+Not supported with SU(2) symmetry.
+
+\item[UseReflectionSymmetry=integer] Optional. If 1, and during the
+infinite algorithm, splits the superblock into the even and odd subspaces of
+the left-right reflection, and finds the ground state in each one. The
+lattice and Hamiltonian must be reflection symmetric, and only
+SolverOptions=MatrixVectorStored, models without fermions, without SU(2),
+and with one site added to each block per step are supported. Default is 0.
+
+\item[DensityMatrixPerturbation=real] Optional. If positive, adds to the
+density matrix of the growing block $\alpha\sum_a (A_a\rho A_a^\dagger +
+A_a^\dagger\rho A_a)$, where $\alpha$ is this number and the $A_a$ are the
+operators of the site just added to the block, and keeps the trace of the
+density matrix. This brings into the kept basis states that are connected
+by the Hamiltonian to the targeted states, and improves the convergence
+without twositedmrg. Values between $10^{-4}$ and $10^{-8}$ are typical, and
+should be decreased, or set to zero, for the last finite loops.
+Not supported with SU(2) symmetry or with useSvd. Default is 0.
+
+\item[ThickRestartVectors=integer] Optional. The maximum number of Lanczos
+vectors kept in memory with SolverOptions=useThickRestart, which bounds the
+memory of the solver to this number times the size of the superblock sector.
+Default is 32.
+
 \item[InfiniteLoopKeptStates=integer]  \emph{m} value for the infinite algorithm.
 
 \item[FiniteLoops=vector]
@@ -143,6 +185,8 @@ struct ParametersDmrgSolver {
 	SizeType dumperBegin;
 	SizeType dumperEnd;
 	SizeType precision;
+	SizeType memoryBudget;
+	SizeType thickRestartVectors;
 	int useReflectionSymmetry;
 	PairRealSizeType truncationControl;
 	PsimagLite::String filename;
@@ -152,11 +196,14 @@ struct ParametersDmrgSolver {
 	PsimagLite::String insitu;
 	PsimagLite::String fileForDensityMatrixEigs;
 	PsimagLite::String recoverySave;
+	PsimagLite::String profiler;
+	PsimagLite::String inSweepObservables;
 	RestartStruct checkpoint;
 	VectorSizeType adjustQuantumNumbers;
 	VectorFiniteLoopType finiteLoop;
 	FieldType degeneracyMax;
 	FieldType denseSparseThreshold;
+	FieldType densityMatrixPerturbation;
 
 	template<class Archive>
 	void serialize(Archive&, const unsigned int)
@@ -188,9 +235,12 @@ struct ParametersDmrgSolver {
 	      dumperBegin(0),
 	      dumperEnd(0),
 	      precision(6),
+	      memoryBudget(0),
+	      thickRestartVectors(32),
 	      recoverySave("0"),
 	      degeneracyMax(1e-12),
-	      denseSparseThreshold(0.1)
+	      denseSparseThreshold(0.1),
+	      densityMatrixPerturbation(0.0)
 	{
 		io.readline(model,"Model=");
 		io.readline(options,"SolverOptions=");
@@ -280,6 +330,14 @@ struct ParametersDmrgSolver {
 			io.readline(degeneracyMax,"DegeneracyMax=");
 		} catch (std::exception&) {}
 
+		try {
+			io.readline(densityMatrixPerturbation,"DensityMatrixPerturbation=");
+		} catch (std::exception&) {}
+
+		try {
+			io.readline(thickRestartVectors,"ThickRestartVectors=");
+		} catch (std::exception&) {}
+
 		try {
 			io.readline(recoverySave,"RecoverySave=");
 		} catch (std::exception&) {}
@@ -312,6 +370,18 @@ struct ParametersDmrgSolver {
 			io.readline(denseSparseThreshold, "DenseSparseThreshold=");
 		} catch (std::exception&) {}
 
+		try {
+			io.readline(profiler,"Profiler=");
+		} catch (std::exception&) {}
+
+		try {
+			io.readline(memoryBudget,"MemoryBudget=");
+		} catch (std::exception&) {}
+
+		try {
+			io.readline(inSweepObservables,"InSweepObservables=");
+		} catch (std::exception&) {}
+
 		if (isObserveCode) return;
 		bool hasRestart = false;
 		if (options.find("restart")!=PsimagLite::String::npos) {
@@ -527,6 +597,12 @@ std::ostream &operator<<(std::ostream &os,
 	os<<p.finiteLoop;
 
 	os<<"RecoverySave="<<p.recoverySave<<"\n";
+	if (p.profiler != "")
+		os<<"Profiler="<<p.profiler<<"\n";
+	if (p.memoryBudget > 0)
+		os<<"MemoryBudget="<<p.memoryBudget<<"\n";
+	if (p.inSweepObservables != "")
+		os<<"InSweepObservables="<<p.inSweepObservables<<"\n";
 	if (p.truncationControl.first > 0) {
 		os<<"parameters.tolerance="<<p.truncationControl.first<<",";
 		os<<p.truncationControl.second<<"\n";
@@ -534,6 +610,10 @@ std::ostream &operator<<(std::ostream &os,
 
 	os<<"parameters.degeneracyMax="<<p.degeneracyMax<<"\n";
 	os<<"parameters.denseSparseThreshold="<<p.denseSparseThreshold<<"\n";
+	if (p.options.find("useThickRestart") != PsimagLite::String::npos)
+		os<<"parameters.thickRestartVectors="<<p.thickRestartVectors<<"\n";
+	if (p.densityMatrixPerturbation > 0)
+		os<<"parameters.densityMatrixPerturbation="<<p.densityMatrixPerturbation<<"\n";
 	os<<"parameters.nthreads="<<p.nthreads<<"\n";
 	os<<"parameters.useReflectionSymmetry="<<p.useReflectionSymmetry<<"\n";
 	os<<p.checkpoint;
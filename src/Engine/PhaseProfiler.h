@@ -0,0 +1,307 @@
+#ifndef PHASEPROFILER_H
+#define PHASEPROFILER_H
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include "Vector.h"
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#endif
+
+namespace Dmrg {
+
+// Scoped timers for the phases of a DMRG run
+//
+// Enabled with Profiler=json or Profiler=csv in the input. Nested scopes
+// form a tree of phases, for example step/diagonalization/solver/matvec.
+// Time and number of calls of each phase are aggregated per step, per
+// finite loop (sweep) and per run. Together with the largest resident memory
+// seen at the end of the scopes in that step, sweep or run, they are written
+// to Profile<filename>.json (one JSON object per line) or
+// Profile<filename>.csv. The resident memory is the current one, read from
+// /proc/self/statm, or the process peak where that file does not exist.
+// Only the thread that called init() is timed; scopes entered by other
+// threads, for example when diagonalizing sectors concurrently, are ignored.
+class PhaseProfiler {
+
+	enum {STEP, SWEEP, RUN, LEVELS};
+
+	enum FormatEnum {FORMAT_NONE, FORMAT_JSON, FORMAT_CSV};
+
+	struct NodeType {
+
+		NodeType(PsimagLite::String name_, SizeType parent_)
+		    : name(name_), parent(parent_)
+		{
+			for (SizeType i = 0; i < LEVELS; ++i) {
+				seconds[i] = 0.0;
+				calls[i] = 0;
+				maxRssKb[i] = 0;
+			}
+		}
+
+		PsimagLite::String name;
+		SizeType parent;
+		PsimagLite::Vector<SizeType>::Type children;
+		double seconds[LEVELS];
+		SizeType calls[LEVELS];
+		long int maxRssKb[LEVELS];
+	};
+
+	typedef PsimagLite::Vector<NodeType>::Type VectorNodeType;
+
+	struct StateType {
+
+		StateType() : format(FORMAT_NONE), current(0)
+		{
+			nodes.push_back(NodeType("run", 0));
+			for (SizeType i = 0; i < LEVELS; ++i)
+				maxRssKb[i] = 0;
+		}
+
+		FormatEnum format;
+		std::ofstream fout;
+		VectorNodeType nodes;
+		SizeType current;
+		long int maxRssKb[LEVELS];
+#ifdef USE_PTHREADS
+		pthread_t owner;
+#endif
+	};
+
+public:
+
+	class Scope {
+
+	public:
+
+		Scope(const char* name, bool memory = true)
+		    : node_(PhaseProfiler::enter(name)), memory_(memory), t0_(0.0)
+		{
+			if (node_ > 0) t0_ = PhaseProfiler::now();
+		}
+
+		~Scope() { stop(); }
+
+		// Ends the scope before its destruction
+		void stop()
+		{
+			if (node_ == 0) return;
+			PhaseProfiler::leave(node_, PhaseProfiler::now() - t0_, memory_);
+			node_ = 0;
+		}
+
+	private:
+
+		Scope(const Scope&);
+
+		Scope& operator=(const Scope&);
+
+		SizeType node_;
+		bool memory_;
+		double t0_;
+	};
+
+	static void init(PsimagLite::String format, PsimagLite::String filename)
+	{
+		StateType& s = state();
+		if (format == "") return;
+		if (format == "json") {
+			s.format = FORMAT_JSON;
+		} else if (format == "csv") {
+			s.format = FORMAT_CSV;
+		} else {
+			err("Profiler=" + format + " is not json or csv\n");
+		}
+
+		s.fout.open((filename + "." + format).c_str());
+		if (!s.fout) err("PhaseProfiler: cannot open " + filename + "." + format + "\n");
+		s.fout<<std::setprecision(6);
+		if (s.format == FORMAT_CSV)
+			s.fout<<"kind,loop,step,site,direction,phase,seconds,calls,maxRssKb\n";
+#ifdef USE_PTHREADS
+		s.owner = pthread_self();
+#endif
+	}
+
+	static bool enabled() { return (state().format != FORMAT_NONE); }
+
+	// Writes the phases of the step that just ended
+	static void step(SizeType loop,
+	                 SizeType stepIndex,
+	                 SizeType site,
+	                 PsimagLite::String direction)
+	{
+		if (!enabled()) return;
+		write(STEP, "step", loop, stepIndex, site, direction);
+	}
+
+	// Writes the phases of the finite loop that just ended; phases timed
+	// outside of its steps are not carried to the next step
+	static void sweep(SizeType loop)
+	{
+		if (!enabled()) return;
+		write(SWEEP, "sweep", loop, 0, 0, "");
+		reset(STEP);
+	}
+
+	// Writes the phases of the infinite algorithm, which just ended; its
+	// steps are not written one by one, and are not carried to the next step
+	static void infinite()
+	{
+		if (!enabled()) return;
+		write(SWEEP, "infinite", 0, 0, 0, "INFINITE");
+		reset(STEP);
+	}
+
+	static void finalize()
+	{
+		if (!enabled()) return;
+		write(RUN, "run", 0, 0, 0, "");
+		state().fout.close();
+		state().format = FORMAT_NONE;
+	}
+
+	// Used by Scope; returns 0 if the scope is not timed
+	static SizeType enter(const char* name)
+	{
+		if (!enabled()) return 0;
+#ifdef USE_PTHREADS
+		if (!pthread_equal(pthread_self(), state().owner)) return 0;
+#endif
+		StateType& s = state();
+		const PsimagLite::Vector<SizeType>::Type& children = s.nodes[s.current].children;
+		SizeType n = children.size();
+		SizeType node = 0;
+		for (SizeType i = 0; i < n; ++i) {
+			if (strcmp(s.nodes[children[i]].name.c_str(), name) != 0) continue;
+			node = children[i];
+			break;
+		}
+
+		if (node == 0) {
+			node = s.nodes.size();
+			s.nodes.push_back(NodeType(name, s.current));
+			s.nodes[s.current].children.push_back(node);
+		}
+
+		s.current = node;
+		return node;
+	}
+
+	// Used by Scope
+	static void leave(SizeType node, double seconds, bool memory)
+	{
+		StateType& s = state();
+		NodeType& n = s.nodes[node];
+		for (SizeType i = 0; i < LEVELS; ++i) {
+			n.seconds[i] += seconds;
+			++n.calls[i];
+		}
+
+		s.current = n.parent;
+		if (!memory) return;
+		long int rss = rssKb();
+		for (SizeType i = 0; i < LEVELS; ++i) {
+			n.maxRssKb[i] = std::max(n.maxRssKb[i], rss);
+			s.maxRssKb[i] = std::max(s.maxRssKb[i], rss);
+		}
+	}
+
+	static double now()
+	{
+		struct timeval tv;
+		gettimeofday(&tv, 0);
+		return tv.tv_sec + 1e-6*tv.tv_usec;
+	}
+
+private:
+
+	static StateType& state()
+	{
+		static StateType s;
+		return s;
+	}
+
+	// Current resident memory, or the peak if it cannot be read
+	static long int rssKb()
+	{
+		std::ifstream fin("/proc/self/statm");
+		long int pages = 0;
+		long int resident = 0;
+		if (fin >> pages >> resident) return resident*(sysconf(_SC_PAGESIZE)/1024);
+
+		struct rusage usage;
+		if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+		return usage.ru_maxrss;
+	}
+
+	static void reset(SizeType level)
+	{
+		StateType& s = state();
+		SizeType total = s.nodes.size();
+		for (SizeType i = 0; i < total; ++i) {
+			NodeType& n = s.nodes[i];
+			n.seconds[level] = 0.0;
+			n.calls[level] = 0;
+			n.maxRssKb[level] = 0;
+		}
+
+		s.maxRssKb[level] = 0;
+	}
+
+	static void write(SizeType level,
+	                  PsimagLite::String kind,
+	                  SizeType loop,
+	                  SizeType stepIndex,
+	                  SizeType site,
+	                  PsimagLite::String direction)
+	{
+		StateType& s = state();
+		long int rss = std::max(s.maxRssKb[level], rssKb());
+		bool json = (s.format == FORMAT_JSON);
+		if (json) {
+			s.fout<<"{\"kind\":\""<<kind<<"\",\"loop\":"<<loop<<",\"step\":"<<stepIndex;
+			s.fout<<",\"site\":"<<site<<",\"direction\":\""<<direction<<"\"";
+			s.fout<<",\"maxRssKb\":"<<rss<<",\"phases\":{";
+		}
+
+		bool first = true;
+		SizeType total = s.nodes.size();
+		for (SizeType i = 1; i < total; ++i) {
+			NodeType& n = s.nodes[i];
+			if (n.calls[level] == 0) continue;
+			PsimagLite::String path = pathOf(i);
+			if (json) {
+				if (!first) s.fout<<",";
+				s.fout<<"\""<<path<<"\":{\"seconds\":"<<n.seconds[level];
+				s.fout<<",\"calls\":"<<n.calls[level]<<",\"maxRssKb\":"<<n.maxRssKb[level]<<"}";
+			} else {
+				s.fout<<kind<<","<<loop<<","<<stepIndex<<","<<site<<","<<direction<<",";
+				s.fout<<path<<","<<n.seconds[level]<<","<<n.calls[level]<<",";
+				s.fout<<n.maxRssKb[level]<<"\n";
+			}
+
+			first = false;
+		}
+
+		if (json) s.fout<<"}}\n";
+		s.fout.flush();
+		reset(level);
+	}
+
+	static PsimagLite::String pathOf(SizeType node)
+	{
+		const VectorNodeType& nodes = state().nodes;
+		PsimagLite::String path = nodes[node].name;
+		for (node = nodes[node].parent; node > 0; node = nodes[node].parent)
+			path = nodes[node].name + "/" + path;
+		return path;
+	}
+};
+}
+#endif // PHASEPROFILER_H
@@ -79,13 +79,26 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #ifndef DMRG_RECOVER_H
 #define DMRG_RECOVER_H
 
+#include <cstdio>
 #include "Checkpoint.h"
 #include "Vector.h"
 #include "ProgramGlobals.h"
 #include "ProgressIndicator.h"
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#endif
 
 namespace Dmrg {
 
+// Recovery files alternate between Recovery0 and Recovery1, so that one
+// of them is complete if the run dies while the other is being written.
+//
+// With stacks in memory, only the stack entries pushed since the last
+// snapshot into the same file are appended, by a background thread, and
+// without copying the stacks. The main recovery file is written to a
+// temporary, and renamed only after both stacks are in disk, so that a
+// recovery file that exists always matches its stacks.
+
 template<typename ParametersType,typename TargetingType>
 class Recovery  {
 
@@ -101,6 +114,7 @@ public:
 	typedef typename PsimagLite::Vector<SizeType>::Type VectorSizeType;
 	typedef typename CheckpointType::MemoryStackType MemoryStackType;
 	typedef typename CheckpointType::DiskStackType DiskStackType;
+	typedef typename MemoryStackType::SnapshotType SnapshotType;
 
 	Recovery(const CheckpointType& checkpoint,
 	         const WaveFunctionTransfType& wft,
@@ -111,11 +125,19 @@ public:
 	      wft_(wft),
 	      pS_(pS),
 	      pE_(pE),
-	      flag_m_(false)
+	      flag_m_(false),
+	      writerRunning_(false),
+	      writeFailed_(false)
 	{}
 
 	~Recovery()
 	{
+		try {
+			finishSnapshot();
+		} catch (std::exception& e) {
+			std::cerr<<e.what();
+		}
+
 		if (checkpoint_.parameters().options.find("recoveryNoDelete") !=
 		        PsimagLite::String::npos) return;
 
@@ -131,27 +153,122 @@ public:
 		if (checkpoint_.parameters().recoverySave == "0")
 			return;
 
+		finishSnapshot();
+
 		PsimagLite::String prefix("Recovery");
 		prefix += (flag_m_) ? "1" : "0";
 		PsimagLite::String rootName(prefix + checkpoint_.parameters().filename);
-		typename IoType::Out ioOut(rootName);
-		ioOut<<checkpoint_.parameters();
-		checkpoint_.save(pS_,pE_,ioOut);
-		psi.save(vsites,ioOut);
-		PsimagLite::OstringStream msg;
-		msg<<"#LastLoopSign="<<lastSign<<"\n";
-		ioOut<<msg.str();
-		files_.push_back(rootName);
+		bool inMemory = (!checkpoint_.memoryStack(SYSTEM).inDisk() &&
+		                 !checkpoint_.memoryStack(ENVIRON).inDisk());
 
-		saveStacksForRecovery(rootName,isObserveCode);
+		// this recovery file will not match its stacks until they are written
+		unlink(rootName.c_str());
+		tmpName_ = rootName + ".tmp";
+		rootName_ = rootName;
+
+		{
+			typename IoType::Out ioOut(tmpName_);
+			ioOut<<checkpoint_.parameters();
+			checkpoint_.save(pS_,pE_,ioOut);
+			psi.save(vsites,ioOut);
+			PsimagLite::OstringStream msg;
+			msg<<"#LastLoopSign="<<lastSign<<"\n";
+			ioOut<<msg.str();
+		}
+
+		files_.push_back(rootName);
 
 		wft_.save(rootName);
 		wft_.appendFileList(files_,rootName);
 		flag_m_ = !flag_m_;
+
+		if (inMemory) {
+			startSnapshot(rootName);
+			return;
+		}
+
+		saveStacksForRecovery(rootName,isObserveCode);
+		commit();
 	}
 
 private:
 
+	void startSnapshot(PsimagLite::String rootWriteFile) const
+	{
+		PsimagLite::String sysWriteFile = utils::pathPrepend(checkpoint_.SYSTEM_STACK_STRING,
+		                                                     rootWriteFile);
+		PsimagLite::String envWriteFile = utils::pathPrepend(checkpoint_.ENVIRON_STACK_STRING,
+		                                                     rootWriteFile);
+		files_.push_back(sysWriteFile);
+		files_.push_back(envWriteFile);
+
+		checkpoint_.memoryStack(SYSTEM).snapshot(snapshots_[SYSTEM], sysWriteFile);
+		checkpoint_.memoryStack(ENVIRON).snapshot(snapshots_[ENVIRON], envWriteFile);
+
+		PsimagLite::OstringStream msg;
+		msg<<"Writing "<<snapshots_[SYSTEM].entries.size()<<" sys. and ";
+		msg<<snapshots_[ENVIRON].entries.size()<<" env. new stack entries (for recovery)";
+		progress_.printline(msg,std::cout);
+
+		writeFailed_ = false;
+#ifdef USE_PTHREADS
+		writerRunning_ = (pthread_create(&writer_,
+		                                 0,
+		                                 writeThread,
+		                                 const_cast<Recovery*>(this)) == 0);
+		if (writerRunning_) return;
+#endif
+		writeSnapshot();
+		finishSnapshot();
+	}
+
+	void writeSnapshot() const
+	{
+		try {
+			MemoryStackType::writeSnapshot(snapshots_[SYSTEM]);
+			MemoryStackType::writeSnapshot(snapshots_[ENVIRON]);
+			if (rename(tmpName_.c_str(), rootName_.c_str()) != 0)
+				writeFailed_ = true;
+		} catch (std::exception&) {
+			writeFailed_ = true;
+		}
+	}
+
+	// Waits for the background writer, and releases the stacks
+	void finishSnapshot() const
+	{
+#ifdef USE_PTHREADS
+		if (writerRunning_) {
+			pthread_join(writer_, 0);
+			writerRunning_ = false;
+		}
+#endif
+
+		if (snapshots_[SYSTEM].file == "") return;
+
+		checkpoint_.memoryStack(SYSTEM).unpin();
+		checkpoint_.memoryStack(ENVIRON).unpin();
+		snapshots_[SYSTEM] = SnapshotType();
+		snapshots_[ENVIRON] = SnapshotType();
+
+		if (!writeFailed_) return;
+		err("Recovery: cannot write " + rootName_ + " or its stacks\n");
+	}
+
+	void commit() const
+	{
+		if (rename(tmpName_.c_str(), rootName_.c_str()) == 0) return;
+		err("Recovery: cannot rename " + tmpName_ + " to " + rootName_ + "\n");
+	}
+
+#ifdef USE_PTHREADS
+	static void* writeThread(void* arg)
+	{
+		static_cast<Recovery*>(arg)->writeSnapshot();
+		return 0;
+	}
+#endif
+
 	void saveStacksForRecovery(PsimagLite::String rootWriteFile,
 	                           bool isObserveCode) const
 	{
@@ -187,6 +304,14 @@ private:
 	const BasisWithOperatorsType& pE_;
 	mutable bool flag_m_;
 	mutable VectorStringType files_;
+	mutable PsimagLite::String tmpName_;
+	mutable PsimagLite::String rootName_;
+	mutable SnapshotType snapshots_[2];
+	mutable bool writerRunning_;
+	mutable bool writeFailed_;
+#ifdef USE_PTHREADS
+	mutable pthread_t writer_;
+#endif
 };     //class Recovery
 
 } // namespace Dmrg
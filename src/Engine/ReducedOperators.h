@@ -390,6 +390,17 @@ public:
 
 	SizeType size() const { return reducedOperators_.size(); }
 
+	SizeType memoryUsage() const
+	{
+		if (!useSu2Symmetry_) return 0;
+		SizeType total = MemoryAccounting::bytes(reducedHamiltonian_) +
+		        MemoryAccounting::bytes(su2Transform_) +
+		        MemoryAccounting::bytes(su2TransformT_);
+		for (SizeType i = 0; i < reducedOperators_.size(); ++i)
+			total += reducedOperators_[i].memoryUsage();
+		return total;
+	}
+
 	void gather()
 	{
 		PsimagLite::MPI::pointByPointGather(reducedOperators_);
@@ -884,7 +895,7 @@ private:
 
 	const BasisType* thisBasis_;
 	bool useSu2Symmetry_;
-	ClebschGordanType* cgObject_;
+	const ClebschGordanType* cgObject_;
 	PsimagLite::Vector<SizeType>::Type momentumOfOperators_;
 	PsimagLite::Vector<SizeType>::Type basisrinverse_;
 	typename PsimagLite::Vector<OperatorType>::Type reducedOperators_;
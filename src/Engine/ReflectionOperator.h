@@ -0,0 +1,403 @@
+#ifndef DMRG_REFLECTION_OPERATOR_H
+#define DMRG_REFLECTION_OPERATOR_H
+#include "Matrix.h"
+#include "CrsMatrix.h"
+#include "ProgressIndicator.h"
+
+namespace Dmrg {
+
+// Reflection symmetry of a left-right symmetric chain
+//
+// With UseReflectionSymmetry=1, and during the infinite algorithm, where
+// the system and environment have the same number of sites, the superblock
+// sector is split into the even and odd subspaces of the reflection R, and
+// Lanczos runs in each one; the lowest of the two is expanded back
+// into the sector to be used by the density matrix.
+// The reflection is kept as the mirror matrix M, with
+// M(eta, r) = <eta|R|r>, from left block states r to right block states eta,
+// which starts as the identity for one-site blocks, is grown with each added
+// site, and changes basis with the truncation transforms of both blocks.
+// Then R|r,eta> = sum M(eta',r) M(eta,r')^* |r',eta'>
+// Limitations: MatrixVectorStored only, models without fermions only, no
+// SU(2), one site added to each block per step, and one symmetry sector only.
+// Otherwise, or if the truncation breaks the mirror, the reflection is
+// switched off for the rest of the run.
+template<typename LeftRightSuperType>
+class ReflectionOperator {
+
+	typedef typename LeftRightSuperType::SparseMatrixType SparseMatrixType;
+	typedef typename LeftRightSuperType::BasisType BasisType;
+	typedef typename LeftRightSuperType::RealType RealType;
+	typedef typename SparseMatrixType::value_type ComplexOrRealType;
+	typedef typename PsimagLite::Vector<ComplexOrRealType>::Type VectorType;
+	typedef typename PsimagLite::Vector<RealType>::Type VectorRealType;
+	typedef typename PsimagLite::Vector<SizeType>::Type VectorSizeType;
+	typedef typename PsimagLite::Vector<SparseMatrixType>::Type VectorSparseMatrixType;
+	typedef PsimagLite::Matrix<ComplexOrRealType> MatrixType;
+
+public:
+
+	ReflectionOperator(LeftRightSuperType& lrs,
+	                   SizeType hilbert,
+	                   bool isEnabled,
+	                   SizeType)
+	    : lrs_(lrs),
+	      hilbert_(hilbert),
+	      isEnabled_(isEnabled),
+	      active_(false),
+	      broken_(false),
+	      progress_("ReflectionOperator"),
+	      projectors_(2),
+	      projectorsDagger_(2)
+	{}
+
+	// Builds the even and odd subspaces of the superblock sector
+	void update(const VectorSizeType& sectors)
+	{
+		active_ = false;
+		if (!isEnabled_ || broken_) return;
+
+		if (BasisType::useSu2Symmetry())
+			err("ReflectionOperator: not supported with SU(2) symmetry\n");
+
+		const BasisType& left = lrs_.left();
+		for (SizeType i = 0; i < left.size(); ++i) {
+			if (left.electrons(i) == 0) continue;
+			err("ReflectionOperator: only models without fermions are supported\n");
+		}
+
+		if (!isMirrored()) {
+			switchOff("blocks are not mirror images");
+			return;
+		}
+
+		if (sectors.size() != 1) {
+			switchOff("more than one symmetry sector");
+			return;
+		}
+
+		growMirror();
+
+		SparseMatrixType reflection;
+		buildReflection(reflection, sectors[0]);
+		if (!buildProjectors(reflection)) {
+			switchOff("reflection is not unitary");
+			return;
+		}
+
+		active_ = true;
+		PsimagLite::OstringStream msg;
+		msg<<"sector of size "<<reflection.rows()<<" split into even= "<<size(0);
+		msg<<" and odd= "<<size(1);
+		progress_.printline(msg,std::cout);
+	}
+
+	const LeftRightSuperType& leftRightSuper() const { return lrs_; }
+
+	bool isEnabled() const { return active_; }
+
+	// Changes the basis of the mirror with the transforms of both blocks
+	template<typename SomeTransformType>
+	void changeBasis(const SomeTransformType& transform1,
+	                 const SomeTransformType& transform2)
+	{
+		if (!active_) {
+			if (mirror_.rows() > 0) switchOff("step without reflection");
+			return;
+		}
+
+		active_ = false;
+		SparseMatrixType tL;
+		SparseMatrixType tR;
+		SparseMatrixType tRdagger;
+		SparseMatrixType tmp;
+		transform1.toSparse(tL);
+		transform2.toSparse(tR);
+		transposeConjugate(tRdagger, tR);
+		multiply(tmp, grown_, tL);
+		multiply(mirror_, tRdagger, tmp);
+		grown_.clear();
+
+		if (!isUnitary(mirror_)) switchOff("truncation broke the mirror");
+	}
+
+	template<typename SomeVectorType>
+	void setInitState(const SomeVectorType& initVector,
+	                  SomeVectorType& initVector1,
+	                  SomeVectorType& initVector2) const
+	{
+		initVector1.clear();
+		initVector1.resize(size(0), 0.0);
+		initVector2.clear();
+		initVector2.resize(size(1), 0.0);
+		if (initVector.size() != projectors_[0].rows()) return;
+
+		projectorsDagger_[0].matrixVectorProduct(initVector1, initVector);
+		projectorsDagger_[1].matrixVectorProduct(initVector2, initVector);
+	}
+
+	RealType setGroundState(VectorType& gs,
+	                        const RealType& gsEnergy1,
+	                        const VectorType& gsVector1,
+	                        const RealType& gsEnergy2,
+	                        const VectorType& gsVector2) const
+	{
+		SizeType sector = (gsEnergy1 <= gsEnergy2) ? 0 : 1;
+		gs.clear();
+		gs.resize(projectors_[sector].rows(), 0.0);
+		projectors_[sector].matrixVectorProduct(gs, (sector == 0) ? gsVector1 : gsVector2);
+
+		PsimagLite::OstringStream msg;
+		msg<<"even energy= "<<gsEnergy1<<" odd energy= "<<gsEnergy2;
+		msg<<", ground state is "<<((sector == 0) ? "even" : "odd");
+		progress_.printline(msg,std::cout);
+		return (sector == 0) ? gsEnergy1 : gsEnergy2;
+	}
+
+	// Projects the sector Hamiltonian into the even and odd subspaces
+	void transform(SparseMatrixType& matrix1,
+	               SparseMatrixType& matrix2,
+	               const SparseMatrixType& matrix) const
+	{
+		SparseMatrixType tmp;
+		multiply(tmp, matrix, projectors_[0]);
+		multiply(matrix1, projectorsDagger_[0], tmp);
+
+		SparseMatrixType offDiagonal;
+		multiply(offDiagonal, projectorsDagger_[1], tmp);
+		if (maxAbs(offDiagonal) > TOLERANCE*(1.0 + maxAbs(matrix)))
+			err("ReflectionOperator: Hamiltonian is not reflection symmetric\n");
+
+		multiply(tmp, matrix, projectors_[1]);
+		multiply(matrix2, projectorsDagger_[1], tmp);
+	}
+
+	SizeType size(SizeType sector) const
+	{
+		assert(sector < projectorsDagger_.size());
+		return projectorsDagger_[sector].rows();
+	}
+
+	void switchOff(PsimagLite::String reason)
+	{
+		active_ = false;
+		broken_ = true;
+		mirror_.clear();
+		grown_.clear();
+		PsimagLite::OstringStream msg;
+		msg<<"switched off for the rest of the run: "<<reason;
+		progress_.printline(msg,std::cout);
+	}
+
+private:
+
+	static const RealType TOLERANCE;
+
+	bool isMirrored()
+	{
+		const BasisType& left = lrs_.left();
+		const BasisType& right = lrs_.right();
+		if (left.size() != right.size()) return false;
+		if (left.block().size() != right.block().size()) return false;
+		if (mirror_.rows() == 0) {
+			if (left.block().size() != 2 || left.size() != hilbert_*hilbert_)
+				return false;
+			mirror_.makeDiagonal(hilbert_, 1.0);
+		}
+
+		return (mirror_.cols()*hilbert_ == left.size() &&
+		        mirror_.rows()*hilbert_ == right.size());
+	}
+
+	// Mirror from left = oldLeft x site to right = site x oldRight
+	void growMirror()
+	{
+		const BasisType& left = lrs_.left();
+		const BasisType& right = lrs_.right();
+		SizeType nL = left.size();
+		SizeType nR = right.size();
+		SizeType oldLeftSize = mirror_.cols();
+		grown_.resize(nR, nL);
+		SizeType counter = 0;
+		for (SizeType eta = 0; eta < nR; ++eta) {
+			grown_.setRow(eta, counter);
+			SizeType u = right.permutation(eta) % hilbert_;
+			SizeType ePrime = right.permutation(eta)/hilbert_;
+			for (int k = mirror_.getRowPtr(ePrime); k < mirror_.getRowPtr(ePrime + 1); ++k) {
+				SizeType e = mirror_.getCol(k);
+				grown_.pushCol(left.permutationInverse(e + u*oldLeftSize));
+				grown_.pushValue(mirror_.getValue(k));
+				++counter;
+			}
+		}
+
+		grown_.setRow(nR, counter);
+		grown_.checkValidity();
+	}
+
+	// Row t=(r,eta) of R has R(t,t') = M(eta',r)^* M(eta,r') for t'=(r',eta'),
+	// which, as R is hermitian, is also column t
+	void buildReflection(SparseMatrixType& reflection, SizeType sector) const
+	{
+		const BasisType& super = lrs_.super();
+		SizeType nL = lrs_.left().size();
+		SizeType offset = super.partition(sector);
+		SizeType n = super.partition(sector + 1) - offset;
+		SparseMatrixType grownDagger;
+		transposeConjugate(grownDagger, grown_);
+
+		reflection.resize(n, n);
+		SizeType counter = 0;
+		for (SizeType t = 0; t < n; ++t) {
+			reflection.setRow(t, counter);
+			SizeType r = super.permutation(t + offset) % nL;
+			SizeType eta = super.permutation(t + offset)/nL;
+			for (int k = grownDagger.getRowPtr(r); k < grownDagger.getRowPtr(r + 1); ++k) {
+				SizeType etaPrime = grownDagger.getCol(k);
+				for (int l = grown_.getRowPtr(eta); l < grown_.getRowPtr(eta + 1); ++l) {
+					SizeType rPrime = grown_.getCol(l);
+					int tPrime = super.permutationInverse(rPrime + etaPrime*nL) - offset;
+					if (tPrime < 0 || static_cast<SizeType>(tPrime) >= n)
+						err("ReflectionOperator: reflection leaves the sector\n");
+					reflection.pushCol(tPrime);
+					reflection.pushValue(grownDagger.getValue(k)*grown_.getValue(l));
+					++counter;
+				}
+			}
+		}
+
+		reflection.setRow(n, counter);
+		reflection.checkValidity();
+	}
+
+	// Diagonalizes R in each of its connected components, usually of size
+	// one or two, and puts eigenvalue +1 vectors into sector 0 and -1 into 1
+	bool buildProjectors(const SparseMatrixType& reflection)
+	{
+		SizeType n = reflection.rows();
+		VectorSizeType root(n);
+		for (SizeType i = 0; i < n; ++i) root[i] = i;
+		for (SizeType i = 0; i < n; ++i) {
+			for (int k = reflection.getRowPtr(i); k < reflection.getRowPtr(i + 1); ++k) {
+				SizeType a = findRoot(root, i);
+				SizeType b = findRoot(root, reflection.getCol(k));
+				if (a != b) root[b] = a;
+			}
+		}
+
+		typename PsimagLite::Vector<VectorSizeType>::Type components(n);
+		for (SizeType i = 0; i < n; ++i)
+			components[findRoot(root, i)].push_back(i);
+
+		VectorSizeType location(n);
+		typename PsimagLite::Vector<VectorSizeType>::Type rowPtr(2, VectorSizeType(1, 0));
+		typename PsimagLite::Vector<VectorSizeType>::Type cols(2);
+		typename PsimagLite::Vector<VectorType>::Type values(2);
+		for (SizeType c = 0; c < n; ++c) {
+			const VectorSizeType& members = components[c];
+			SizeType m = members.size();
+			if (m == 0) continue;
+			for (SizeType i = 0; i < m; ++i)
+				location[members[i]] = i;
+
+			MatrixType block(m, m);
+			for (SizeType i = 0; i < m; ++i) {
+				SizeType row = members[i];
+				for (int k = reflection.getRowPtr(row); k < reflection.getRowPtr(row + 1); ++k)
+					block(i, location[reflection.getCol(k)]) += reflection.getValue(k);
+			}
+
+			VectorRealType eigs(m);
+			diag(block, eigs, 'V');
+			for (SizeType j = 0; j < m; ++j) {
+				if (fabs(fabs(eigs[j]) - 1.0) > TOLERANCE) return false;
+				SizeType s = (eigs[j] > 0) ? 0 : 1;
+				for (SizeType i = 0; i < m; ++i) {
+					if (std::abs(block(i, j)) < TOLERANCE) continue;
+					cols[s].push_back(members[i]);
+					values[s].push_back(PsimagLite::conj(block(i, j)));
+				}
+
+				rowPtr[s].push_back(cols[s].size());
+			}
+		}
+
+		for (SizeType s = 0; s < 2; ++s) {
+			SparseMatrixType& p = projectorsDagger_[s];
+			SizeType rows = rowPtr[s].size() - 1;
+			p.resize(rows, n);
+			for (SizeType i = 0; i < rows; ++i) {
+				p.setRow(i, rowPtr[s][i]);
+				for (SizeType k = rowPtr[s][i]; k < rowPtr[s][i + 1]; ++k) {
+					p.pushCol(cols[s][k]);
+					p.pushValue(values[s][k]);
+				}
+			}
+
+			p.setRow(rows, cols[s].size());
+			p.checkValidity();
+			transposeConjugate(projectors_[s], p);
+		}
+
+		return true;
+	}
+
+	static SizeType findRoot(VectorSizeType& root, SizeType i)
+	{
+		while (root[i] != i) {
+			root[i] = root[root[i]];
+			i = root[i];
+		}
+
+		return i;
+	}
+
+	static bool isUnitary(const SparseMatrixType& m)
+	{
+		if (m.rows() != m.cols()) return false;
+		SparseMatrixType mDagger;
+		SparseMatrixType product;
+		transposeConjugate(mDagger, m);
+		multiply(product, mDagger, m);
+		for (SizeType i = 0; i < product.rows(); ++i) {
+			ComplexOrRealType diagonal = 0.0;
+			for (int k = product.getRowPtr(i); k < product.getRowPtr(i + 1); ++k) {
+				if (static_cast<SizeType>(product.getCol(k)) == i)
+					diagonal += product.getValue(k);
+				else if (std::abs(product.getValue(k)) > TOLERANCE)
+					return false;
+			}
+
+			if (std::abs(diagonal - 1.0) > TOLERANCE) return false;
+		}
+
+		return true;
+	}
+
+	static RealType maxAbs(const SparseMatrixType& m)
+	{
+		RealType max = 0;
+		for (SizeType k = 0; k < m.nonZeros(); ++k)
+			if (max < std::abs(m.getValue(k))) max = std::abs(m.getValue(k));
+		return max;
+	}
+
+	const LeftRightSuperType& lrs_;
+	SizeType hilbert_;
+	bool isEnabled_;
+	bool active_;
+	bool broken_;
+	PsimagLite::ProgressIndicator progress_;
+	SparseMatrixType mirror_;
+	SparseMatrixType grown_;
+	VectorSparseMatrixType projectors_;
+	VectorSparseMatrixType projectorsDagger_;
+}; // class ReflectionOperator
+
+template<typename LeftRightSuperType>
+const typename ReflectionOperator<LeftRightSuperType>::RealType
+ReflectionOperator<LeftRightSuperType>::TOLERANCE = 1e-6;
+
+} // namespace Dmrg
+
+#endif // DMRG_REFLECTION_OPERATOR_H
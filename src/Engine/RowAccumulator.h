@@ -0,0 +1,82 @@
+#ifndef DMRG_ROW_ACCUMULATOR_H
+#define DMRG_ROW_ACCUMULATOR_H
+#include <algorithm>
+#include "Vector.h"
+
+namespace Dmrg {
+
+// Sparse accumulator of one row of a CrsMatrix being built with pushCol and
+// pushValue: only the columns touched are visited when the row is flushed,
+// in increasing order. flushAt writes the row instead into a matrix whose
+// row pointers are set already, so that rows can be filled concurrently
+template<typename SparseMatrixType>
+class RowAccumulator {
+
+	typedef typename SparseMatrixType::value_type FieldType;
+	typedef typename PsimagLite::Vector<SizeType>::Type VectorSizeType;
+
+public:
+
+	explicit RowAccumulator(SizeType n) : position_(n, -1) {}
+
+	void add(SizeType col, const FieldType& value)
+	{
+		int p = position_[col];
+		if (p >= 0) {
+			values_[p] += value;
+			return;
+		}
+
+		position_[col] = cols_.size();
+		cols_.push_back(col);
+		values_.push_back(value);
+	}
+
+	void flush(SparseMatrixType& m, SizeType& counter)
+	{
+		std::sort(cols_.begin(), cols_.end());
+		for (SizeType i = 0; i < cols_.size(); ++i) {
+			SizeType col = cols_[i];
+			m.pushCol(col);
+			m.pushValue(values_[position_[col]]);
+			position_[col] = -1;
+		}
+
+		counter += cols_.size();
+		cols_.clear();
+		values_.clear();
+	}
+
+	void flushAt(SparseMatrixType& m, SizeType ip)
+	{
+		std::sort(cols_.begin(), cols_.end());
+		for (SizeType i = 0; i < cols_.size(); ++i) {
+			SizeType col = cols_[i];
+			m.setCol(ip + i, col);
+			m.setValues(ip + i, values_[position_[col]]);
+		}
+
+		clear();
+	}
+
+	// number of columns touched
+	SizeType size() const { return cols_.size(); }
+
+	void clear()
+	{
+		for (SizeType i = 0; i < cols_.size(); ++i)
+			position_[cols_[i]] = -1;
+
+		cols_.clear();
+		values_.clear();
+	}
+
+private:
+
+	typename PsimagLite::Vector<int>::Type position_;
+	VectorSizeType cols_;
+	typename PsimagLite::Vector<FieldType>::Type values_;
+}; // class RowAccumulator
+} // namespace Dmrg
+
+#endif // DMRG_ROW_ACCUMULATOR_H
@@ -0,0 +1,278 @@
+#ifndef DMRG_SHARED_OPERATORS_H
+#define DMRG_SHARED_OPERATORS_H
+#include <map>
+#include <algorithm>
+#include <cassert>
+#include "Vector.h"
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#endif
+
+namespace Dmrg {
+
+// Operators shared by reference count, with copy-on-write
+//
+// Copies share every operator, so that copying a basis, as pushing to or
+// popping from a stack does, does not copy operator data.
+// set() also shares operators of identical content, found by a hash of the
+// sparsity pattern and metadata and then compared element by element.
+// modify(i) gives the i-th operator to be changed in place, copying it first
+// if it is shared, as it is when a change of basis makes it diverge.
+// Different operators can be modified concurrently.
+template<typename OperatorType>
+class SharedOperators {
+
+	typedef typename OperatorType::SparseMatrixType SparseMatrixType;
+	typedef typename PsimagLite::Vector<OperatorType>::Type VectorOperatorType;
+	typedef typename PsimagLite::Vector<SizeType>::Type VectorSizeType;
+
+	struct SharedOperator {
+
+		SharedOperator(const OperatorType& op1) : op(op1), count(1) {}
+
+		OperatorType op;
+		SizeType count;
+	};
+
+	typedef typename PsimagLite::Vector<SharedOperator*>::Type VectorSharedType;
+
+public:
+
+	SharedOperators() {}
+
+	SharedOperators(const SharedOperators& other)
+	    : items_(other.items_)
+	{
+		acquireAll();
+	}
+
+	SharedOperators& operator=(const SharedOperators& other)
+	{
+		if (this == &other) return *this;
+		VectorSharedType old = items_;
+		items_ = other.items_;
+		acquireAll();
+		for (SizeType i = 0; i < old.size(); ++i)
+			release(old[i]);
+		return *this;
+	}
+
+	~SharedOperators()
+	{
+		for (SizeType i = 0; i < items_.size(); ++i)
+			release(items_[i]);
+	}
+
+	SizeType size() const { return items_.size(); }
+
+	const OperatorType& operator[](SizeType i) const
+	{
+		assert(i < items_.size());
+		return items_[i]->op;
+	}
+
+	OperatorType& modify(SizeType i)
+	{
+		assert(i < items_.size());
+		SharedOperator* shared = items_[i];
+		lock();
+		bool exclusive = (shared->count == 1);
+		unlock();
+		if (exclusive) return shared->op;
+
+		// shared operators are not changed, so the copy can be done unlocked
+		items_[i] = new SharedOperator(shared->op);
+		release(shared);
+		return items_[i]->op;
+	}
+
+	// drops the data of the i-th operator, but keeps its metadata
+	void clearData(SizeType i)
+	{
+		assert(i < items_.size());
+		SharedOperator* shared = items_[i];
+		lock();
+		bool exclusive = (shared->count == 1);
+		unlock();
+		if (exclusive) {
+			shared->op.data.clear();
+			return;
+		}
+
+		OperatorType op;
+		op.fermionSign = shared->op.fermionSign;
+		op.jm = shared->op.jm;
+		op.angularFactor = shared->op.angularFactor;
+		op.su2Related = shared->op.su2Related;
+		items_[i] = new SharedOperator(op);
+		release(shared);
+	}
+
+	// new operators are empty and not shared
+	void resize(SizeType n)
+	{
+		for (SizeType i = n; i < items_.size(); ++i)
+			release(items_[i]);
+
+		SizeType old = items_.size();
+		items_.resize(n);
+		for (SizeType i = old; i < n; ++i)
+			items_[i] = new SharedOperator(OperatorType());
+	}
+
+	void set(const VectorOperatorType& ops)
+	{
+		SharedOperators tmp;
+		tmp.items_.resize(ops.size());
+		std::map<SizeType, VectorSizeType> byHash;
+		for (SizeType i = 0; i < ops.size(); ++i) {
+			SizeType h = hash(ops[i]);
+			VectorSizeType& candidates = byHash[h];
+			SizeType j = 0;
+			for (; j < candidates.size(); ++j)
+				if (equal(ops[candidates[j]], ops[i])) break;
+
+			if (j < candidates.size()) {
+				tmp.items_[i] = tmp.items_[candidates[j]];
+				++tmp.items_[i]->count;
+				continue;
+			}
+
+			tmp.items_[i] = new SharedOperator(ops[i]);
+			candidates.push_back(i);
+		}
+
+		swap(tmp);
+	}
+
+	void get(VectorOperatorType& ops) const
+	{
+		ops.resize(items_.size());
+		for (SizeType i = 0; i < items_.size(); ++i)
+			ops[i] = items_[i]->op;
+	}
+
+	// same layout as io.write(ops,label) with the ops of get(ops),
+	// but writes the shared operators without copying them
+	template<typename IoOutputter>
+	void write(IoOutputter& io, const PsimagLite::String& label) const
+	{
+		io<<label<<"\n";
+		io<<items_.size()<<"\n";
+		for (SizeType i = 0; i < items_.size(); ++i)
+			io<<items_[i]->op<<"\n";
+	}
+
+	void swap(SharedOperators& other)
+	{
+		items_.swap(other.items_);
+	}
+
+	// shared operators are counted once
+	SizeType memoryUsage() const
+	{
+		VectorSharedType distinct = items_;
+		std::sort(distinct.begin(), distinct.end());
+		SizeType total = 0;
+		for (SizeType i = 0; i < distinct.size(); ++i) {
+			if (i > 0 && distinct[i] == distinct[i - 1]) continue;
+			total += distinct[i]->op.memoryUsage();
+		}
+
+		return total;
+	}
+
+private:
+
+	void acquireAll()
+	{
+		lock();
+		for (SizeType i = 0; i < items_.size(); ++i)
+			++items_[i]->count;
+		unlock();
+	}
+
+	static void release(SharedOperator* shared)
+	{
+		lock();
+		assert(shared->count > 0);
+		bool last = (--shared->count == 0);
+		unlock();
+		if (last) delete shared;
+	}
+
+	static SizeType hash(const OperatorType& op)
+	{
+		const SparseMatrixType& m = op.data;
+		SizeType h = m.rows();
+		combine(h, m.cols());
+		combine(h, op.fermionSign + 1);
+		combine(h, op.jm.first);
+		combine(h, op.jm.second);
+		for (SizeType i = 0; i <= m.rows() && m.cols() > 0; ++i)
+			combine(h, m.getRowPtr(i));
+		if (m.rows() == 0 || m.cols() == 0) return h;
+
+		int nonZeros = m.getRowPtr(m.rows());
+		for (int k = 0; k < nonZeros; ++k)
+			combine(h, m.getCol(k));
+		return h;
+	}
+
+	static void combine(SizeType& h, SizeType x)
+	{
+		h ^= x + 0x9e3779b9 + (h<<6) + (h>>2);
+	}
+
+	static bool equal(const OperatorType& a, const OperatorType& b)
+	{
+		if (a.fermionSign != b.fermionSign || a.jm != b.jm) return false;
+		if (a.angularFactor != b.angularFactor) return false;
+		if (a.su2Related.offset != b.su2Related.offset) return false;
+		if (a.su2Related.source != b.su2Related.source) return false;
+		if (a.su2Related.transpose != b.su2Related.transpose) return false;
+
+		const SparseMatrixType& ma = a.data;
+		const SparseMatrixType& mb = b.data;
+		if (ma.rows() != mb.rows() || ma.cols() != mb.cols()) return false;
+		if (ma.rows() == 0 || ma.cols() == 0) return true;
+
+		for (SizeType i = 0; i <= ma.rows(); ++i)
+			if (ma.getRowPtr(i) != mb.getRowPtr(i)) return false;
+
+		int nonZeros = ma.getRowPtr(ma.rows());
+		for (int k = 0; k < nonZeros; ++k) {
+			if (ma.getCol(k) != mb.getCol(k)) return false;
+			if (ma.getValue(k) != mb.getValue(k)) return false;
+		}
+
+		return true;
+	}
+
+	static void lock()
+	{
+#ifdef USE_PTHREADS
+		pthread_mutex_lock(&mutex());
+#endif
+	}
+
+	static void unlock()
+	{
+#ifdef USE_PTHREADS
+		pthread_mutex_unlock(&mutex());
+#endif
+	}
+
+#ifdef USE_PTHREADS
+	static pthread_mutex_t& mutex()
+	{
+		static pthread_mutex_t m = PTHREAD_MUTEX_INITIALIZER;
+		return m;
+	}
+#endif
+
+	VectorSharedType items_;
+}; // class SharedOperators
+} // namespace Dmrg
+
+#endif // DMRG_SHARED_OPERATORS_H
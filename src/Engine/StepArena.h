@@ -0,0 +1,257 @@
+#ifndef DMRG_STEP_ARENA_H
+#define DMRG_STEP_ARENA_H
+#include <algorithm>
+#include <cassert>
+#include "Vector.h"
+#include "MemoryAccounting.h"
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#endif
+
+namespace Dmrg {
+
+// The StepArena instantiations in use
+//
+// Each StepArena<VectorType> adds itself here when first used, so that
+// DmrgSolver ends the step of all of them with one call to reset(), whatever
+// the vector types of the Hamiltonian connections and of the targets are.
+// reset() records the sum of their peak bytes for the memory report, as "arena".
+class StepArenas {
+
+	typedef SizeType (*EndStepType)();
+	typedef PsimagLite::Vector<EndStepType>::Type VectorEndStepType;
+
+public:
+
+	static void add(EndStepType endStep)
+	{
+		lock();
+		VectorEndStepType& all = arenas();
+		if (std::find(all.begin(), all.end(), endStep) == all.end())
+			all.push_back(endStep);
+		unlock();
+	}
+
+	static void reset()
+	{
+		lock();
+		VectorEndStepType all = arenas();
+		unlock();
+
+		SizeType peak = 0;
+		for (SizeType i = 0; i < all.size(); ++i)
+			peak += (*all[i])();
+
+		MemoryAccounting::peak("arena", peak);
+	}
+
+private:
+
+	static VectorEndStepType& arenas()
+	{
+		static VectorEndStepType all;
+		return all;
+	}
+
+	static void lock()
+	{
+#ifdef USE_PTHREADS
+		pthread_mutex_lock(&mutex());
+#endif
+	}
+
+	static void unlock()
+	{
+#ifdef USE_PTHREADS
+		pthread_mutex_unlock(&mutex());
+#endif
+	}
+
+#ifdef USE_PTHREADS
+	static pthread_mutex_t& mutex()
+	{
+		static pthread_mutex_t m = PTHREAD_MUTEX_INITIALIZER;
+		return m;
+	}
+#endif
+}; // class StepArenas
+
+// Buffers for the temporary vectors of a DMRG step, reused across steps
+//
+// take() gives a vector of n zeros, made from a buffer given back earlier
+// by the same thread if there is one, so that the large temporaries of each
+// matrix vector product do not go back to the heap. give() returns the
+// storage of a vector to the arena. At the end of each step, StepArenas::reset()
+// frees the buffers that the step did not need at the same time.
+template<typename VectorType>
+class StepArena {
+
+	typedef typename VectorType::value_type ValueType;
+	typedef typename PsimagLite::Vector<VectorType>::Type VectorVectorType;
+
+	struct ThreadBuffers {
+
+		ThreadBuffers() : taken(0), maxTaken(0) {}
+
+		VectorVectorType free;
+		SizeType taken;
+		SizeType maxTaken;
+	};
+
+	typedef typename PsimagLite::Vector<ThreadBuffers>::Type VectorThreadBuffersType;
+
+public:
+
+	static void take(VectorType& v, SizeType n, SizeType thread = 0)
+	{
+		VectorType buffer;
+		lock();
+		ThreadBuffers& b = buffers(thread);
+		SizeType k = best(b.free, n);
+		if (k < b.free.size()) {
+			buffer.swap(b.free[k]);
+			b.free.erase(b.free.begin() + k);
+			stats().free -= bytes(buffer);
+		}
+
+		++b.taken;
+		b.maxTaken = std::max(b.maxTaken, b.taken);
+		unlock();
+
+		v.swap(buffer);
+		v.assign(n, 0.0);
+
+		lock();
+		stats().taken += bytes(v);
+		updatePeak();
+		unlock();
+	}
+
+	// v is left empty
+	static void give(VectorType& v, SizeType thread = 0)
+	{
+		if (v.capacity() == 0) return;
+
+		lock();
+		ThreadBuffers& b = buffers(thread);
+		b.free.push_back(VectorType());
+		b.free.back().swap(v);
+		if (b.taken > 0) --b.taken;
+		SizeType x = bytes(b.free.back());
+		stats().taken -= std::min(stats().taken, x);
+		stats().free += x;
+		updatePeak();
+		unlock();
+	}
+
+private:
+
+	// returns the peak bytes of the step
+	static SizeType endStep()
+	{
+		lock();
+		VectorThreadBuffersType& all = threadBuffers();
+		for (SizeType i = 0; i < all.size(); ++i) {
+			ThreadBuffers& b = all[i];
+			// the largest buffers are kept
+			while (b.free.size() > b.maxTaken) {
+				SizeType k = best(b.free, 0);
+				stats().free -= bytes(b.free[k]);
+				b.free.erase(b.free.begin() + k);
+			}
+
+			b.maxTaken = b.taken;
+		}
+
+		SizeType peak = stats().peak;
+		stats().peak = stats().taken + stats().free;
+		unlock();
+		return peak;
+	}
+
+	struct Stats {
+
+		Stats() : taken(0), free(0), peak(0) {}
+
+		SizeType taken;
+		SizeType free;
+		SizeType peak;
+	};
+
+	// smallest buffer of at least n elements, or else the largest one
+	static SizeType best(const VectorVectorType& free, SizeType n)
+	{
+		SizeType k = free.size();
+		for (SizeType i = 0; i < free.size(); ++i) {
+			SizeType c = free[i].capacity();
+			if (k == free.size()) {
+				k = i;
+				continue;
+			}
+
+			SizeType ck = free[k].capacity();
+			bool fits = (c >= n);
+			bool kFits = (ck >= n);
+			if ((fits && (!kFits || c < ck)) || (!fits && !kFits && c > ck))
+				k = i;
+		}
+
+		return k;
+	}
+
+	static SizeType bytes(const VectorType& v)
+	{
+		return v.capacity()*sizeof(ValueType);
+	}
+
+	static void updatePeak()
+	{
+		SizeType total = stats().taken + stats().free;
+		if (stats().peak < total) stats().peak = total;
+	}
+
+	static ThreadBuffers& buffers(SizeType thread)
+	{
+		VectorThreadBuffersType& all = threadBuffers();
+		if (all.size() == 0) StepArenas::add(endStep);
+		if (all.size() <= thread) all.resize(thread + 1);
+		return all[thread];
+	}
+
+	static VectorThreadBuffersType& threadBuffers()
+	{
+		static VectorThreadBuffersType all;
+		return all;
+	}
+
+	static Stats& stats()
+	{
+		static Stats s;
+		return s;
+	}
+
+	static void lock()
+	{
+#ifdef USE_PTHREADS
+		pthread_mutex_lock(&mutex());
+#endif
+	}
+
+	static void unlock()
+	{
+#ifdef USE_PTHREADS
+		pthread_mutex_unlock(&mutex());
+#endif
+	}
+
+#ifdef USE_PTHREADS
+	static pthread_mutex_t& mutex()
+	{
+		static pthread_mutex_t m = PTHREAD_MUTEX_INITIALIZER;
+		return m;
+	}
+#endif
+}; // class StepArena
+} // namespace Dmrg
+
+#endif // DMRG_STEP_ARENA_H
@@ -75,6 +75,12 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "Map.h"
 #include "Su2SymmetryGlobals.h"
 #include "Sort.h"
+#include "Concurrency.h"
+#include "Parallelizer.h"
+#include <map>
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#endif
 
 /** \ingroup DMRG */
 /*@{*/
@@ -98,6 +104,24 @@ namespace Dmrg {
 		typedef typename OperatorsType::OperatorType OperatorType;
 		typedef Su2SymmetryGlobals<RealType> Su2SymmetryGlobalsType;
 		typedef typename Su2SymmetryGlobalsType::ClebschGordanType ClebschGordanType;
+		typedef typename PsimagLite::Vector<SizeType>::Type VectorSizeType;
+		typedef typename PsimagLite::Vector<PairType>::Type VectorPairType;
+		typedef PsimagLite::Matrix<SparseElementType> MatrixType;
+		typedef typename PsimagLite::Vector<MatrixType>::Type VectorMatrixType;
+
+		// The lfactors depend only on the j values of the sector and of
+		// both blocks, and on the j of the operators, so that they are cached
+		// with those as key, and reused by all model helpers of a step,
+		// and by the steps that follow with the same j values
+		struct LfactorsType {
+			VectorMatrixType lfactor;
+			MatrixType lfactorHamiltonian;
+			VectorPairType jsEffective;
+		};
+
+		typedef std::map<VectorSizeType, LfactorsType> CacheType;
+
+		static const SizeType CACHE_SIZE = 16;
 
 		static const SizeType System=0,Environ=1;
 		//static const BasisType* basis1Ptr_;
@@ -110,28 +134,22 @@ namespace Dmrg {
 		 lrs_(lrs),
 		 cgObject_(Su2SymmetryGlobalsType::clebschGordanObject)
 		{
-			typename PsimagLite::Vector<PairType>::Type jsEffective;
-			typename PsimagLite::Vector<SizeType>::Type jvalues;
+			VectorSizeType jvalues;
 			// find all possible j values
-			SizeType counter=0;
 			for (SizeType i=0;i<lrs.left().numberOfOperators();i++) {
 				SizeType j = lrs.left().getReducedOperatorByIndex(i).jm.first;
 				int x = PsimagLite::isInVector(jvalues,j);
 				if (x<0) jvalues.push_back(j);
-				counter += (j+1);
 			}
 
-			// build all lfactors
-			lfactor_.resize(counter);
-			counter=0;
-			for (SizeType i=0;i<jvalues.size();i++) {
-				for (SizeType m=0;m<=jvalues[i];m++) {
-					buildAdditional(lfactor_[counter],jvalues[i],m,jvalues[i]-m,jsEffective);
-					counter++;
-				}
+			VectorSizeType key;
+			makeKey(key,jvalues);
+			VectorPairType jsEffective;
+			if (!fromCache(jsEffective,key)) {
+				buildLfactors(jsEffective,jvalues);
+				toCache(key,jsEffective);
 			}
 
-			calcHamFactor(lfactorHamiltonian_);
 			calcEffectiveStates(jsEffective);
 
 			//basis1Ptr_ = &basis1;
@@ -275,55 +293,216 @@ namespace Dmrg {
 			}
 		}
 
-		void buildAdditional(PsimagLite::Matrix<SparseElementType>& lfactor,
+		class ParallelLfactors {
+
+		public:
+
+			ParallelLfactors(Su2Reduced& su2Reduced,
+			                 const VectorPairType& kmus,
+			                 typename PsimagLite::Vector<VectorPairType>::Type& jsEffective)
+			    : su2Reduced_(su2Reduced), kmus_(kmus), jsEffective_(jsEffective)
+			{}
+
+			SizeType tasks() const { return kmus_.size(); }
+
+			void doTask(SizeType taskNumber, SizeType)
+			{
+				const PairType& kmu = kmus_[taskNumber];
+				su2Reduced_.buildAdditional(su2Reduced_.lfactor_[taskNumber],
+				                            kmu.first,
+				                            kmu.second,
+				                            kmu.first - kmu.second,
+				                            jsEffective_[taskNumber]);
+			}
+
+		private:
+
+			Su2Reduced& su2Reduced_;
+			const VectorPairType& kmus_;
+			typename PsimagLite::Vector<VectorPairType>::Type& jsEffective_;
+		}; // class ParallelLfactors
+
+		// One lfactor per k and mu, built in parallel; the effective j pairs
+		// are merged in the order of a serial build
+		void buildLfactors(VectorPairType& jsEffective, const VectorSizeType& jvalues)
+		{
+			VectorPairType kmus;
+			for (SizeType i=0;i<jvalues.size();i++)
+				for (SizeType m=0;m<=jvalues[i];m++)
+					kmus.push_back(PairType(jvalues[i],m));
+
+			lfactor_.clear();
+			lfactor_.resize(kmus.size());
+			typename PsimagLite::Vector<VectorPairType>::Type jsEffectiveByTask(kmus.size());
+			ParallelLfactors helper(*this,kmus,jsEffectiveByTask);
+			PsimagLite::Parallelizer<ParallelLfactors> threaded(PsimagLite::Concurrency::npthreads,
+			                                                    PsimagLite::MPI::COMM_WORLD);
+			threaded.loopCreate(helper);
+
+			jsEffective.clear();
+			for (SizeType t=0;t<jsEffectiveByTask.size();t++) {
+				for (SizeType i=0;i<jsEffectiveByTask[t].size();i++) {
+					const PairType& jj = jsEffectiveByTask[t][i];
+					if (PsimagLite::isInVector(jsEffective,jj)<0) jsEffective.push_back(jj);
+				}
+			}
+
+			calcHamFactor(lfactorHamiltonian_);
+		}
+
+		void buildAdditional(MatrixType& lfactor,
 		                     SizeType k,
 		                     SizeType mu1,
 		                     SizeType mu2,
-		                     typename PsimagLite::Vector<PairType>::Type& jsEffective)
+		                     VectorPairType& jsEffective) const
 		{
 			PairType kmu1(k,mu1);
 			PairType kmu2(k,mu2);
-			SizeType counter=0;
 			int offset = lrs_.super().partition(m_);
 			PairType jm=lrs_.super().jmValue(offset);
-			lfactor.resize(lrs_.left().jMax()*lrs_.right().jMax(),lrs_.left().jMax()*lrs_.right().jMax());
+			SizeType leftJMax = lrs_.left().jMax();
+			lfactor.resize(leftJMax*lrs_.right().jMax(),leftJMax*lrs_.right().jMax());
+			lfactor.setTo(0.0);
 			for (SizeType i1=0;i1<lrs_.left().jVals();i1++) {
+				SizeType j1 = lrs_.left().jVals(i1);
 				for (SizeType i2=0;i2<lrs_.right().jVals();i2++) {
+					SizeType j2 = lrs_.right().jVals(i2);
+					if (!isTriangle(jm.first,j1,j2)) continue;
 					for (SizeType i1prime=0;i1prime<lrs_.left().jVals();i1prime++) {
+						SizeType j1prime = lrs_.left().jVals(i1prime);
+						if (!isTriangle(j1prime,j1,k)) continue;
 						for (SizeType i2prime=0;i2prime<lrs_.right().jVals();i2prime++) {
-							SparseElementType sum=calcLfactor(lrs_.left().jVals(i1),lrs_.right().jVals(i2),
-							    lrs_.left().jVals(i1prime),lrs_.right().jVals(i2prime),jm,kmu1,kmu2);
-							if (sum!=static_cast<SparseElementType>(0)) {
-								counter++;
-								PairType jj(PairType(lrs_.left().jVals(i1),lrs_.right().jVals(i2)));
-								int x3=PsimagLite::isInVector(jsEffective,jj);
-								if (x3<0) jsEffective.push_back(jj);
-							}
-							lfactor(lrs_.left().jVals(i1)+lrs_.right().jVals(i2)*lrs_.left().jMax(),
-							    lrs_.left().jVals(i1prime)+lrs_.right().jVals(i2prime)*lrs_.left().jMax())=sum;
-
+							SizeType j2prime = lrs_.right().jVals(i2prime);
+							if (!isTriangle(j2prime,j2,k)) continue;
+							if (!isTriangle(jm.first,j1prime,j2prime)) continue;
+							SparseElementType sum=calcLfactor(j1,j2,j1prime,j2prime,jm,kmu1,kmu2);
+							if (sum==static_cast<SparseElementType>(0)) continue;
+							PairType jj(j1,j2);
+							int x3=PsimagLite::isInVector(jsEffective,jj);
+							if (x3<0) jsEffective.push_back(jj);
+							lfactor(j1+j2*leftJMax,j1prime+j2prime*leftJMax)=sum;
 						}
 					}
 				}
 			}
 		}
 
+		// Triangle rule for 2j, 2j1 and 2j2, including that j1+j2-j is an integer
+		static bool isTriangle(SizeType j,SizeType j1,SizeType j2)
+		{
+			if (j > j1 + j2) return false;
+			SizeType jmin = (j1 > j2) ? j1 - j2 : j2 - j1;
+			if (j < jmin) return false;
+			return ((j1 + j2 - j) % 2 == 0);
+		}
+
+		void makeKey(VectorSizeType& key, const VectorSizeType& jvalues) const
+		{
+			int offset = lrs_.super().partition(m_);
+			PairType jm=lrs_.super().jmValue(offset);
+			key.clear();
+			key.push_back(jm.first);
+			key.push_back(jm.second);
+			key.push_back(lrs_.left().jMax());
+			key.push_back(lrs_.right().jMax());
+			key.push_back(jvalues.size());
+			key.insert(key.end(),jvalues.begin(),jvalues.end());
+			key.push_back(lrs_.left().jVals());
+			for (SizeType i=0;i<lrs_.left().jVals();i++)
+				key.push_back(lrs_.left().jVals(i));
+			key.push_back(lrs_.right().jVals());
+			for (SizeType i=0;i<lrs_.right().jVals();i++)
+				key.push_back(lrs_.right().jVals(i));
+		}
+
+		bool fromCache(VectorPairType& jsEffective, const VectorSizeType& key)
+		{
+			bool found = false;
+			lockCache();
+			typename CacheType::const_iterator it = cache().find(key);
+			if (it != cache().end()) {
+				lfactor_ = it->second.lfactor;
+				lfactorHamiltonian_ = it->second.lfactorHamiltonian;
+				jsEffective = it->second.jsEffective;
+				found = true;
+			}
+
+			unlockCache();
+			return found;
+		}
+
+		void toCache(const VectorSizeType& key, const VectorPairType& jsEffective) const
+		{
+			lockCache();
+			typename PsimagLite::Vector<VectorSizeType>::Type& order = cacheOrder();
+			if (cache().find(key) == cache().end()) {
+				if (order.size() == CACHE_SIZE) {
+					cache().erase(order[0]);
+					order.erase(order.begin());
+				}
+
+				LfactorsType& entry = cache()[key];
+				entry.lfactor = lfactor_;
+				entry.lfactorHamiltonian = lfactorHamiltonian_;
+				entry.jsEffective = jsEffective;
+				order.push_back(key);
+			}
+
+			unlockCache();
+		}
+
+		static CacheType& cache()
+		{
+			static CacheType c;
+			return c;
+		}
+
+		static typename PsimagLite::Vector<VectorSizeType>::Type& cacheOrder()
+		{
+			static typename PsimagLite::Vector<VectorSizeType>::Type order;
+			return order;
+		}
+
+		static void lockCache()
+		{
+#ifdef USE_PTHREADS
+			pthread_mutex_lock(&mutex());
+#endif
+		}
+
+		static void unlockCache()
+		{
+#ifdef USE_PTHREADS
+			pthread_mutex_unlock(&mutex());
+#endif
+		}
+
+#ifdef USE_PTHREADS
+		static pthread_mutex_t& mutex()
+		{
+			static pthread_mutex_t m = PTHREAD_MUTEX_INITIALIZER;
+			return m;
+		}
+#endif
+
 		void calcHamFactor(PsimagLite::Matrix<SparseElementType>& lfactor)
 		{
 			int offset = lrs_.super().partition(m_);
 			PairType jm=lrs_.super().jmValue(offset);
 			lfactor.resize(lrs_.left().jMax(),lrs_.right().jMax());
 			PairType kmu(0,0);
+			lfactor.setTo(0.0);
 			for (SizeType i1=0;i1<lrs_.left().jVals();i1++) {
+				SizeType j1 = lrs_.left().jVals(i1);
 				for (SizeType i2=0;i2<lrs_.right().jVals();i2++) {
-					lfactor(lrs_.left().jVals(i1),lrs_.right().jVals(i2))=
-					       calcLfactor(lrs_.left().jVals(i1),lrs_.right().jVals(i2),
-					       lrs_.left().jVals(i1),lrs_.right().jVals(i2),jm,kmu,kmu);
+					SizeType j2 = lrs_.right().jVals(i2);
+					if (!isTriangle(jm.first,j1,j2)) continue;
+					lfactor(j1,j2) = calcLfactor(j1,j2,j1,j2,jm,kmu,kmu);
 				}
 			}
 		}
 
-		void calcEffectiveStates(typename PsimagLite::Vector<PairType>::Type jsEffective)
+		void calcEffectiveStates(const VectorPairType& jsEffective)
 		{
 			int offset = lrs_.super().partition(m_);
 			PairType jm=lrs_.super().jmValue(offset);
@@ -441,13 +620,13 @@ namespace Dmrg {
 
 		SizeType m_;
 		const LeftRightSuperType& lrs_;
-		typename PsimagLite::Vector<PsimagLite::Matrix<SparseElementType> >::Type lfactor_;
-		PsimagLite::Matrix<SparseElementType> lfactorHamiltonian_;
+		VectorMatrixType lfactor_;
+		MatrixType lfactorHamiltonian_;
 		SparseMatrixType hamiltonian2_,hamiltonian3_;
 		typename PsimagLite::Vector<PairType>::Type reducedEffective_;
 		PsimagLite::Matrix<SizeType> reducedInverse_;
 		typename PsimagLite::Vector<SizeType>::Type flavorsOldInverse_;
-		ClebschGordanType& cgObject_;
+		const ClebschGordanType& cgObject_;
 
 	}; // class
 
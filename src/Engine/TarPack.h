@@ -117,9 +117,24 @@ int main(int argc,char** argv)
 #ifndef DMRG_TAR_PACK_H
 #define DMRG_TAR_PACK_H
 #include "Vector.h"
+#include "Concurrency.h"
+#include "Parallelizer.h"
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <cstring>
+#include <cstdlib>
+#include <map>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#if defined(__linux__) && defined(__GLIBC__) && \
+	(__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 27))
+#define DMRG_TAR_PACK_COPY_FILE_RANGE
+#endif
 
 namespace Dmrg {
 
@@ -140,7 +155,7 @@ struct PosixTarHeader {
 		sprintf(gname,"nobody");
 		std::snprintf(name,100,"%s",filename.c_str());
 		typeflag[0]=0;
-		sprintf(size,"%011o",static_cast<int>(fileSize));
+		setSize(fileSize);
 	}
 
 	PosixTarHeader (std::ifstream& fin)
@@ -149,6 +164,44 @@ struct PosixTarHeader {
 		fin.read((char*)(this),sizeof(PosixTarHeader));
 	}
 
+	// Sizes of 8GB or more use the base-256 encoding of GNU tar
+	void setSize(LongType fileSize)
+	{
+		static const LongType maxOctal = 077777777777UL;
+		if (fileSize <= maxOctal) {
+			sprintf(size,"%011lo",fileSize);
+			return;
+		}
+
+		for (int i = sizeof(size) - 1; i > 0; --i) {
+			size[i] = static_cast<char>(fileSize & 0xff);
+			fileSize >>= 8;
+		}
+
+		size[0] = static_cast<char>(0x80);
+	}
+
+	LongType fileSize() const
+	{
+		LongType len = 0;
+		if (static_cast<unsigned char>(size[0]) & 0x80) {
+			for (SizeType i = 1; i < sizeof(size); ++i)
+				len = (len << 8) | static_cast<unsigned char>(size[i]);
+			return len;
+		}
+
+		for (SizeType i = 0; i < sizeof(size); ++i) {
+			if (size[i] < '0' || size[i] > '7') {
+				if (len == 0 && size[i] == ' ') continue;
+				break;
+			}
+
+			len = (len << 3) + (size[i] - '0');
+		}
+
+		return len;
+	}
+
 	char name[100];
 	char mode[8];
 	char uid[8];
@@ -168,6 +221,100 @@ struct PosixTarHeader {
 	char pad[12];
 }; // struct PosixTarHeader
 
+class TarHelper {
+
+	typedef PosixTarHeader::LongType LongType;
+
+	static const LongType BUFFER_SIZE = 4194304;
+
+public:
+
+	static LongType fileSize(PsimagLite::String filename)
+	{
+		struct stat buf;
+		if (stat(filename.c_str(), &buf) != 0)
+			throw PsimagLite::RuntimeError("Cannot stat " + filename + "\n");
+		return buf.st_size;
+	}
+
+	static void goodDescriptorOrThrow(std::ifstream& f,
+	                                  PsimagLite::String filename)
+	{
+		if (!f || !f.good() || !f.is_open() || f.bad())
+			throw PsimagLite::RuntimeError("Cannot read from " + filename + "\n");
+	}
+
+	static void goodDescriptorOrThrow(int fd, PsimagLite::String filename)
+	{
+		if (fd >= 0) return;
+		PsimagLite::String msg(strerror(errno));
+		throw PsimagLite::RuntimeError("Cannot open " + filename + ": " + msg + "\n");
+	}
+
+	// Returns 0 on success, or errno
+	static int pwriteAll(int fd, const char* buffer, LongType len, LongType offset)
+	{
+		while (len > 0) {
+			ssize_t x = pwrite(fd, buffer, len, offset);
+			if (x < 0 && errno == EINTR) continue;
+			if (x <= 0) return (x < 0) ? errno : EIO;
+			buffer += x;
+			len -= x;
+			offset += x;
+		}
+
+		return 0;
+	}
+
+	// Copies len bytes of fdin at inOffset to fdout at outOffset without
+	// moving the file offsets, so that threads can share fdout.
+	// Returns 0 on success, or errno
+	static int copyRange(int fdin,
+	                     LongType inOffset,
+	                     int fdout,
+	                     LongType outOffset,
+	                     LongType len)
+	{
+#ifdef DMRG_TAR_PACK_COPY_FILE_RANGE
+		// in kernel, and without copying if the file system supports it
+		while (len > 0) {
+			loff_t in = inOffset;
+			loff_t out = outOffset;
+			ssize_t x = copy_file_range(fdin, &in, fdout, &out, len, 0);
+			if (x < 0 && errno == EINTR) continue;
+			if (x <= 0) break;
+			inOffset += x;
+			outOffset += x;
+			len -= x;
+		}
+
+		if (len == 0) return 0;
+#endif
+
+		LongType bufferLen = (len < BUFFER_SIZE) ? len : BUFFER_SIZE;
+		char* buffer = new char[bufferLen];
+		int ret = 0;
+		while (len > 0) {
+			LongType chunk = (len < bufferLen) ? len : bufferLen;
+			ssize_t x = pread(fdin, buffer, chunk, inOffset);
+			if (x < 0 && errno == EINTR) continue;
+			if (x <= 0) {
+				ret = (x < 0) ? errno : EIO;
+				break;
+			}
+
+			ret = pwriteAll(fdout, buffer, x, outOffset);
+			if (ret != 0) break;
+			inOffset += x;
+			outOffset += x;
+			len -= x;
+		}
+
+		delete [] buffer;
+		return ret;
+	}
+}; // class TarHelper
+
 class TarHeader {
 
 public :
@@ -195,34 +342,42 @@ public :
 		statusCheck(RECORD_CLOSED,"dtor");
 	}
 
-	void writeTo(std::ofstream& fout) const
+	void writeTo(int fd, LongType offset) const
 	{
 		statusCheck(RECORD_OPEN,"writeTo");
-		fout.write((const char*)(&header_),
-		           sizeof(PosixTarHeader));
+		int ret = TarHelper::pwriteAll(fd,
+		                               (const char*)(&header_),
+		                               sizeof(PosixTarHeader),
+		                               offset);
+		if (ret != 0)
+			throw PsimagLite::RuntimeError("TarHeader::writeTo: " +
+			                               PsimagLite::String(strerror(ret)) + "\n");
 	}
 
-	void endRecord(std::ofstream& fout)
+	// Writes the padding of the record at offset, the end of its data
+	void endRecord(int fd, LongType offset)
 	{
 		statusCheck(RECORD_OPEN,"endRecord");
-		if (len_ == 0) {
-			status_ = RECORD_CLOSED;
-			return;
-		}
-
-		char c='\0';
-		LongType len = len_;
-		while ((len%sizeof(PosixTarHeader)) != 0)
-		{
-			fout.write(&c,sizeof(char));
-			++len;
-		}
-
 		status_ = RECORD_CLOSED;
+		LongType len = padding(len_);
+		if (len == 0) return;
+
+		char c[sizeof(PosixTarHeader)];
+		std::memset(c,0,sizeof(PosixTarHeader));
+		int ret = TarHelper::pwriteAll(fd, c, len, offset);
+		if (ret != 0)
+			throw PsimagLite::RuntimeError("TarHeader::endRecord: " +
+			                               PsimagLite::String(strerror(ret)) + "\n");
 	}
 
 	const PosixTarHeader& header() const { return header_; }
 
+	static LongType padding(LongType len)
+	{
+		LongType r = len % sizeof(PosixTarHeader);
+		return (r == 0) ? 0 : sizeof(PosixTarHeader) - r;
+	}
+
 private:
 
 	void checksum()
@@ -260,38 +415,12 @@ private:
 	RecordEnum status_;
 }; // class TarHeader
 
-class TarHelper {
-
-	typedef TarHeader::LongType LongType;
-
-public:
-
-	static LongType fileSize(PsimagLite::String filename)
-	{
-		std::ifstream fin(filename.c_str(),
-		                  std::ifstream::ate | std::ifstream::binary);
-		return fin.tellg();
-	}
-
-	static void goodDescriptorOrThrow(std::ifstream& f,
-	                                  PsimagLite::String filename)
-	{
-		if (!f || !f.good() || !f.is_open() || f.bad())
-			throw PsimagLite::RuntimeError("Cannot read from " + filename + "\n");
-	}
-
-	static void goodDescriptorOrThrow(std::ofstream& f,
-	                                  PsimagLite::String filename)
-	{
-		if (!f || !f.is_open())
-			throw PsimagLite::RuntimeError("Cannot write to " + filename + "\n");
-	}
-};
-
 class NormalExtract {
 
 	typedef PosixTarHeader::LongType LongType;
 
+	static const LongType BUFFER_SIZE = 4194304;
+
 public:
 
 	typedef int ParametersType;
@@ -303,7 +432,8 @@ public:
 	{
 		std::ofstream fout(file.c_str(),std::ifstream::binary);
 		LongType len2 = len;
-		LongType bufferLen = 1024;
+		LongType bufferLen = (len < BUFFER_SIZE) ? len : BUFFER_SIZE;
+		if (bufferLen == 0) return;
 		char *buffer = new char[bufferLen];
 		while (len2 >= bufferLen) {
 			fin.read(buffer,bufferLen);
@@ -321,54 +451,199 @@ public:
 	}
 }; // class NormalExtract
 
+// Writes a tar archive. Files are copied with copy_file_range where
+// available, and, when added together, in chunks by all threads.
+// On close, an index of the files is appended as the last member,
+// TarPackIndex, so that UnTarPack can extract any file without scanning
+// the archive. The archive remains a valid tar file.
 class TarPack  {
 
 	typedef TarHeader::LongType LongType;
+	typedef PsimagLite::Vector<PsimagLite::String>::Type VectorStringType;
+	typedef std::pair<LongType, LongType> PairLongType;
+
+	// a piece of a file to be copied by one thread
+	struct ChunkType {
+
+		ChunkType(SizeType file_, LongType from_, LongType to_, LongType len_)
+		    : file(file_), from(from_), to(to_), len(len_)
+		{}
+
+		SizeType file;
+		LongType from;
+		LongType to;
+		LongType len;
+	};
+
+	typedef PsimagLite::Vector<ChunkType>::Type VectorChunkType;
+
+	class ParallelCopy {
+
+	public:
+
+		ParallelCopy(const VectorStringType& files, const VectorChunkType& chunks, int fd)
+		    : files_(files), chunks_(chunks), fd_(fd), errors_(chunks.size(), 0)
+		{}
+
+		SizeType tasks() const { return chunks_.size(); }
+
+		void doTask(SizeType taskNumber, SizeType)
+		{
+			const ChunkType& c = chunks_[taskNumber];
+			int fdin = open(files_[c.file].c_str(), O_RDONLY);
+			if (fdin < 0) {
+				errors_[taskNumber] = errno;
+				return;
+			}
+
+			errors_[taskNumber] = TarHelper::copyRange(fdin, c.from, fd_, c.to, c.len);
+			::close(fdin);
+		}
+
+		// Throws if any chunk failed
+		void check() const
+		{
+			for (SizeType i = 0; i < errors_.size(); ++i) {
+				if (errors_[i] == 0) continue;
+				PsimagLite::String msg(strerror(errors_[i]));
+				throw PsimagLite::RuntimeError("TarPack: cannot copy " +
+				                               files_[chunks_[i].file] + ": " + msg + "\n");
+			}
+		}
+
+	private:
+
+		const VectorStringType& files_;
+		const VectorChunkType& chunks_;
+		int fd_;
+		PsimagLite::Vector<int>::Type errors_;
+	}; // class ParallelCopy
 
 public:
 
+	static const LongType CHUNK_SIZE = 67108864;
+
+	static PsimagLite::String indexName() { return "TarPackIndex"; }
+
+	static PsimagLite::String indexTrailer() { return "TarPackIndexAt="; }
+
 	TarPack(PsimagLite::String filename)
-	    : fout_(filename.c_str(),std::ofstream::binary)
+	    : filename_(filename),
+	      fd_(open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)),
+	      offset_(0)
 	{
-		TarHelper::goodDescriptorOrThrow(fout_,filename);
+		TarHelper::goodDescriptorOrThrow(fd_,filename);
 	}
 
 	~TarPack()
 	{
-		fout_.close();
+		try {
+			close();
+		} catch (std::exception& e) {
+			std::cerr<<e.what();
+		}
 	}
 
 	void add(PsimagLite::String filename, PsimagLite::String nameInArchive = "")
 	{
-		if (nameInArchive == "") nameInArchive = filename;
-
-		std::ifstream fin(filename.c_str(),std::ifstream::binary);
-		TarHelper::goodDescriptorOrThrow(fin, filename);
-
-		LongType len = TarHelper::fileSize(filename);
-
+		VectorStringType files(1, filename);
+		VectorStringType names(1, (nameInArchive == "") ? filename : nameInArchive);
+		add(files, names);
+	}
 
-		TarHeader tarHeader(nameInArchive,len);
+	// Adds files with their names; large files are copied in chunks,
+	// and all chunks of all files are copied in parallel
+	void add(const VectorStringType& files, VectorStringType names = VectorStringType())
+	{
+		if (fd_ < 0)
+			throw PsimagLite::RuntimeError("TarPack::add: " + filename_ + " is closed\n");
+		if (names.size() == 0) names = files;
+		assert(names.size() == files.size());
+
+		VectorChunkType chunks;
+		for (SizeType i = 0; i < files.size(); ++i) {
+			LongType len = TarHelper::fileSize(files[i]);
+			TarHeader tarHeader(names[i],len);
+			tarHeader.writeTo(fd_, offset_);
+			offset_ += sizeof(PosixTarHeader);
+			index_.push_back(PairLongType(offset_, len));
+			indexNames_.push_back(names[i]);
+
+			for (LongType from = 0; from < len; from += CHUNK_SIZE) {
+				LongType chunk = (len - from < CHUNK_SIZE) ? len - from : CHUNK_SIZE;
+				chunks.push_back(ChunkType(i, from, offset_ + from, chunk));
+			}
 
-		tarHeader.writeTo(fout_);
+			offset_ += len;
+			tarHeader.endRecord(fd_, offset_);
+			offset_ += TarHeader::padding(len);
+		}
 
-		std::copy(std::istreambuf_iterator<char>(fin),
-		          std::istreambuf_iterator<char>(),
-		          std::ostreambuf_iterator<char>(fout_));
+		SizeType nchunks = chunks.size();
+		if (nchunks == 0) return;
 
-		tarHeader.endRecord(fout_);
+		ParallelCopy parallelCopy(files, chunks, fd_);
+		SizeType threads = PsimagLite::Concurrency::npthreads;
+		if (threads > nchunks) threads = nchunks;
+		PsimagLite::Parallelizer<ParallelCopy> threaded(threads, PsimagLite::MPI::COMM_WORLD);
+		threaded.loopCreate(parallelCopy);
+		parallelCopy.check();
 	}
 
+	// Appends the index and the end of the archive
+	void close()
+	{
+		if (fd_ < 0) return;
+
+		std::ostringstream index;
+		index<<indexName()<<" entries="<<index_.size()<<"\n";
+		for (SizeType i = 0; i < index_.size(); ++i)
+			index<<index_[i].first<<" "<<index_[i].second<<" "<<indexNames_[i]<<"\n";
+
+		PsimagLite::String data = index.str();
+		data.append(TarHeader::padding(data.length()), '\n');
+		PsimagLite::String trailer = indexTrailer() + ttos(offset_) + "\n";
+		trailer.append(sizeof(PosixTarHeader) - trailer.length(), '\0');
+		data += trailer;
+
+		TarHeader tarHeader(indexName(), data.length());
+		tarHeader.writeTo(fd_, offset_);
+		offset_ += sizeof(PosixTarHeader);
+		int ret = TarHelper::pwriteAll(fd_, data.c_str(), data.length(), offset_);
+		offset_ += data.length();
+		tarHeader.endRecord(fd_, offset_);
+
+		// two zero records end the archive
+		char zeros[2*sizeof(PosixTarHeader)];
+		std::memset(zeros, 0, sizeof(zeros));
+		if (ret == 0) ret = TarHelper::pwriteAll(fd_, zeros, sizeof(zeros), offset_);
+		offset_ += sizeof(zeros);
+
+		::close(fd_);
+		fd_ = -1;
+		if (ret != 0)
+			throw PsimagLite::RuntimeError("TarPack: cannot write to " + filename_ + ": " +
+			                               PsimagLite::String(strerror(ret)) + "\n");
+	}
 
 private:
 
-	std::ofstream fout_;
+	TarPack(const TarPack&);
+
+	TarPack& operator=(const TarPack&);
 
+	PsimagLite::String filename_;
+	int fd_;
+	LongType offset_;
+	PsimagLite::Vector<PairLongType>::Type index_;
+	VectorStringType indexNames_;
 };     //class TarPack
 
 class UnTarPack  {
 
 	typedef TarHeader::LongType LongType;
+	typedef std::pair<LongType, LongType> PairLongType;
+	typedef std::map<PsimagLite::String, PairLongType> MapStringPairType;
 
 public:
 
@@ -378,6 +653,7 @@ public:
 	    : fin_(filename.c_str(),std::ifstream::binary),filename_(filename)
 	{
 		TarHelper::goodDescriptorOrThrow(fin_,filename);
+		readIndex();
 	}
 
 	~UnTarPack()
@@ -387,6 +663,11 @@ public:
 
 	void list(VectorStringType& files)
 	{
+		if (names_.size() > 0) {
+			files.insert(files.end(), names_.begin(), names_.end());
+			return;
+		}
+
 		while (!fin_.eof()) {
 			TarHeader* tarHeader = 0;
 			try {
@@ -395,16 +676,14 @@ public:
 				break;
 			}
 
-			std::stringstream ss;
-			ss<<std::oct<<tarHeader->header().size;
-			LongType len = 0;
-			ss>>len;
+			LongType len = tarHeader->header().fileSize();
 			LongType currentPos = fin_.tellg();
 			fin_.seekg(currentPos + len);
 			readPadding(len);
 			PsimagLite::String name(tarHeader->header().name);
-			files.push_back(name);
 			delete tarHeader;
+			if (name == "" || name == TarPack::indexName()) continue;
+			files.push_back(name);
 		}
 
 		fin_.close();
@@ -416,6 +695,20 @@ public:
 	             bool rewind,
 	             const typename SomeCallbackType::ParametersType& params)
 	{
+		if (names_.size() > 0) {
+			typename MapStringPairType::const_iterator it = index_.find(file);
+			if (it == index_.end()) {
+				std::cerr<<"UnTarPack: "<<file<<" not found in archive\n";
+				return;
+			}
+
+			fin_.clear();
+			fin_.seekg(it->second.first);
+			SomeCallbackType::hook(fin_, file, it->second.second, params);
+			std::cerr<<"Read "<<file<<" "<<it->second.second<<"\n";
+			return;
+		}
+
 		if (rewind) fin_.seekg(std::ios_base::beg);
 		bool found = false;
 		while (!fin_.eof()) {
@@ -426,10 +719,7 @@ public:
 				break;
 			}
 
-			std::stringstream ss;
-			ss<<std::oct<<tarHeader->header().size;
-			LongType len = 0;
-			ss>>len;
+			LongType len = tarHeader->header().fileSize();
 			if (len == 0) {
 				delete tarHeader;
 				continue;
@@ -457,23 +747,80 @@ public:
 
 private:
 
+	// Reads the index written by TarPack, if any, from the record before
+	// the two zero records that end the archive
+	void readIndex()
+	{
+		const LongType record = sizeof(PosixTarHeader);
+		LongType total = TarHelper::fileSize(filename_);
+		if (total < 4*record) return;
+
+		char trailer[sizeof(PosixTarHeader) + 1];
+		trailer[record] = '\0';
+		fin_.seekg(total - 3*record);
+		fin_.read(trailer, record);
+		PsimagLite::String prefix = TarPack::indexTrailer();
+		if (!fin_ || strncmp(trailer, prefix.c_str(), prefix.length()) != 0) {
+			rewindAll();
+			return;
+		}
+
+		LongType at = strtoul(trailer + prefix.length(), 0, 10);
+		fin_.seekg(at);
+		TarHeader tarHeader(fin_);
+		LongType len = tarHeader.header().fileSize();
+		PsimagLite::String name(tarHeader.header().name);
+		if (!fin_ || name != TarPack::indexName() || len > total) {
+			rewindAll();
+			return;
+		}
+
+		PsimagLite::String data(len, '\0');
+		fin_.read(&data[0], len);
+		std::istringstream is(data);
+		PsimagLite::String label;
+		std::getline(is, label);
+		if (label.find(TarPack::indexName() + " entries=") != 0) {
+			rewindAll();
+			return;
+		}
+
+		SizeType entries = atoi(label.substr(label.find("=") + 1).c_str());
+		for (SizeType i = 0; i < entries; ++i) {
+			LongType offset = 0;
+			LongType size = 0;
+			is>>offset>>size;
+			is.get();
+			PsimagLite::String file;
+			std::getline(is, file);
+			if (!is) break;
+			if (index_.find(file) == index_.end()) names_.push_back(file);
+			index_[file] = PairLongType(offset, size);
+		}
+
+		rewindAll();
+	}
+
+	void rewindAll()
+	{
+		fin_.clear();
+		fin_.seekg(0);
+	}
+
 	void readPadding(LongType len)
 	{
-		if (len == 0) return;
-		SizeType padding = len % sizeof(PosixTarHeader);
-		padding = sizeof(PosixTarHeader) - padding;
+		LongType padding = TarHeader::padding(len);
 		if (padding == 0) return;
-		SizeType allocation = (padding > 512) ? padding : 512;
-		char *c = new char[allocation];
+		char c[sizeof(PosixTarHeader)];
 		fin_.read(c,padding);
-		delete [] c;
 	}
 
 	std::ifstream fin_;
 	PsimagLite::String filename_;
+	MapStringPairType index_;
+	VectorStringType names_;
 
 };     //class UnTarPack
 } // namespace Dmrg
 /*@}*/
 #endif
-
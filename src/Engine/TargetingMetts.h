@@ -90,6 +90,8 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "SymmetryElectronsSz.h"
 #include "TargetingBase.h"
 #include "IoSelector.h"
+#include "Concurrency.h"
+#include "Parallelizer.h"
 
 namespace Dmrg {
 
@@ -155,6 +157,7 @@ public:
 	typedef typename ModelType::InputValidatorType InputValidatorType;
 	typedef typename PsimagLite::Vector<VectorWithOffsetType>::Type VectorVectorWithOffsetType;
 	typedef typename BaseType::IoType IoType;
+	typedef typename BaseType::TargetingCommonType TargetingCommonType;
 
 	enum {DISABLED,WFT_NOADVANCE,WFT_ADVANCE,COLLAPSE};
 
@@ -172,13 +175,16 @@ public:
 	      wft_(wft),
 	      quantumSector_(quantumSector),
 	      progress_("TargetingMetts"),
-	      mettsStochastics_(model,mettsStruct_.rngSeed,mettsStruct_.pure),
-	      mettsCollapse_(mettsStochastics_,lrs,mettsStruct_),
-	      prevDirection_(ProgramGlobals::INFINITE),
-	      systemPrev_(),
-	      environPrev_()
+	      prevDirection_(ProgramGlobals::INFINITE)
 	{
-		this->common().init(&mettsStruct_,mettsStruct_.timeSteps()+1);
+		for (SizeType c = 0; c < mettsStruct_.chains; ++c)
+			chains_.push_back(new MettsChain(model,
+			                                 lrs,
+			                                 mettsStruct_,
+			                                 chainSeed(mettsStruct_.rngSeed,c)));
+
+		this->common().init(&mettsStruct_,
+		                    mettsStruct_.chains*(mettsStruct_.timeSteps()+1));
 		if (!wft.isEnabled()) throw PsimagLite::RuntimeError(" TargetingMetts "
 		                                                     "needs an enabled wft\n");
 
@@ -201,9 +207,18 @@ public:
 		this->common().initTimeVectors(betas_,ioIn);
 	}
 
+	~TargetingMetts()
+	{
+		for (SizeType c = 0; c < chains_.size(); ++c) {
+			delete chains_[c];
+			chains_[c] = 0;
+		}
+	}
+
+	// weights are per chain, and chains share them equally
 	RealType weight(SizeType i) const
 	{
-		return weight_[i];
+		return weight_[i % weight_.size()]/chains_.size();
 	}
 
 	RealType gsWeight() const
@@ -234,9 +249,14 @@ public:
 
 		SizeType n1 = mettsStruct_.timeSteps();
 
+		SizeType n = n1 + 1;
+
 		if (direction == ProgramGlobals::INFINITE) {
-			updateStochastics(block1,block2);
-			getNewPures(block1,block2);
+			for (SizeType c = 0; c < chains_.size(); ++c) {
+				updateStochastics(*chains_[c],block1,block2);
+				getNewPures(*chains_[c],c*n,block1,block2);
+			}
+
 			return;
 		}
 
@@ -249,16 +269,23 @@ public:
 		}
 
 		// Advance or wft each target vector for beta/2
-		for (SizeType i=0;i<max;i++) {
-			evolve(i,0,n1-1,Eg,direction,sites,loopNumber);
+		for (SizeType c = 0; c < chains_.size(); ++c) {
+			SizeType offset = c*n;
+			for (SizeType i=0;i<max;i++) {
+				evolve(offset+i,i,offset+n1-1,Eg,direction,sites,loopNumber);
+			}
 		}
 
 		// compute imag. time evolution:
-		calcTimeVectors(PairType(0,n1),Eg,direction,block1);
+		for (SizeType c = 0; c < chains_.size(); ++c)
+			calcTimeVectors(c,PairType(0,n1),Eg,direction,block1);
 
 		// Advance or wft  collapsed vector
-		if (this->common().targetVectors()[n1].size()>0)
-			evolve(n1,n1,n1-1,Eg,direction,sites,loopNumber);
+		for (SizeType c = 0; c < chains_.size(); ++c) {
+			SizeType offset = c*n;
+			if (this->common().targetVectors()[offset+n1].size()>0)
+				evolve(offset+n1,n1,offset+n1-1,Eg,direction,sites,loopNumber);
+		}
 
 		for (SizeType i=0;i<this->common().targetVectors().size();i++)
 			assert(this->common().targetVectors()[i].size()==0 ||
@@ -269,6 +296,8 @@ public:
 
 		printEnergies(); // in-situ
 
+		printChainAverages(); // in-situ
+
 		PsimagLite::String options = this->model().params().options;
 		bool normalizeTimeVectors = true;
 		if (options.find("neverNormalizeVectors") != std::string::npos)
@@ -281,14 +310,21 @@ public:
 
 		if (this->common().noStageIs(COLLAPSE)) return;
 
-		// collapse
-		bool hasCollapsed = mettsCollapse_(this->common().targetVectors(n1),
-		                                   this->common().targetVectors()[n1-1],
-		        sites,
-		        direction);
-		if (hasCollapsed) {
+		// collapse, chains are independent from each other here
+		typedef PsimagLite::Parallelizer<ParallelMettsCollapse> ParallelizerType;
+		SizeType nchains = chains_.size();
+		SizeType threads = std::min(nchains, PsimagLite::Concurrency::npthreads);
+		ParallelizerType threadedCollapse(threads, PsimagLite::MPI::COMM_WORLD);
+
+		ParallelMettsCollapse helper(chains_,this->common(),n1,sites,direction);
+
+		threadedCollapse.loopCreate(helper);
+
+		for (SizeType c = 0; c < chains_.size(); ++c) {
+			if (!chains_[c]->hasCollapsed) continue;
 			PsimagLite::OstringStream msg;
 			msg<<"Has Collapsed";
+			if (chains_.size() > 1) msg<<" chain="<<c;
 			progress_.printline(msg,std::cout);
 		}
 	}
@@ -353,6 +389,69 @@ public:
 
 private:
 
+	// Everything a METTS chain does not share with the other chains;
+	// model, lattice, operators and weights are shared
+	struct MettsChain {
+
+		MettsChain(const ModelType& model,
+		           const LeftRightSuperType& lrs,
+		           const TargetParamsType& mettsStruct,
+		           int long seed)
+		    : mettsStochastics(model,seed,mettsStruct.pure),
+		      mettsCollapse(mettsStochastics,lrs,mettsStruct,seed),
+		      systemPrev(),
+		      environPrev(),
+		      hasCollapsed(false)
+		{}
+
+		MettsStochasticsType mettsStochastics;
+		MettsCollapseType mettsCollapse;
+		MettsPrev systemPrev;
+		MettsPrev environPrev;
+		std::pair<TargetVectorType,TargetVectorType> pureVectors;
+		bool hasCollapsed;
+	};
+
+	typedef typename PsimagLite::Vector<MettsChain*>::Type VectorMettsChainType;
+
+	class ParallelMettsCollapse {
+
+	public:
+
+		ParallelMettsCollapse(VectorMettsChainType& chains,
+		                      TargetingCommonType& common,
+		                      SizeType n1,
+		                      const VectorSizeType& sites,
+		                      ProgramGlobals::DirectionEnum direction)
+		    : chains_(chains),
+		      common_(common),
+		      n1_(n1),
+		      sites_(sites),
+		      direction_(direction)
+		{}
+
+		SizeType tasks() const { return chains_.size(); }
+
+		void doTask(SizeType c, SizeType)
+		{
+			SizeType offset = c*(n1_ + 1);
+			VectorSizeType sites = sites_;
+			chains_[c]->hasCollapsed =
+			        chains_[c]->mettsCollapse(common_.targetVectors(offset + n1_),
+			                                  common_.targetVectors()[offset + n1_ - 1],
+			        sites,
+			        direction_);
+		}
+
+	private:
+
+		VectorMettsChainType& chains_;
+		TargetingCommonType& common_;
+		SizeType n1_;
+		const VectorSizeType& sites_;
+		ProgramGlobals::DirectionEnum direction_;
+	}; // class ParallelMettsCollapse
+
 	void evolve(SizeType index,
 	            SizeType start,
 	            SizeType indexAdvance,
@@ -371,18 +470,24 @@ private:
 		advanceOrWft(index,indexAdvance,direction,block);
 	}
 
-	void calcTimeVectors(const PairType& startEnd,
+	// The time vectors engine works on the first startEnd.second target vectors,
+	// so the vectors of chain c are swapped in and out of that place
+	void calcTimeVectors(SizeType c,
+	                     const PairType& startEnd,
 	                     RealType Eg,
 	                     ProgramGlobals::DirectionEnum systemOrEnviron,
 	                     const VectorSizeType& block)
 	{
+		SizeType offset = c*weight_.size();
+		swapChainToFront(offset,startEnd);
+
 		const VectorWithOffsetType& phi = this->common().targetVectors()[startEnd.first];
 		PsimagLite::OstringStream msg;
-		msg<<" vector number "<<startEnd.first<<" has norm ";
+		msg<<" vector number "<<(offset+startEnd.first)<<" has norm ";
 		msg<<norm(phi);
 		progress_.printline(msg,std::cout);
 		if (norm(phi)<1e-6)
-			setFromInfinite(this->common().targetVectors(startEnd.first),lrs_);
+			setFromInfinite(this->common().targetVectors(startEnd.first),*chains_[c],lrs_);
 		bool allOperatorsApplied = (this->common().noStageIs(DISABLED));
 		this->common().calcTimeVectors(startEnd,
 		                               Eg,
@@ -391,6 +496,17 @@ private:
 		                               allOperatorsApplied,
 		                               block);
 		this->common().normalizeTimeVectors(startEnd.first+1,startEnd.second);
+
+		swapChainToFront(offset,startEnd);
+	}
+
+	void swapChainToFront(SizeType offset, const PairType& startEnd)
+	{
+		if (offset == 0) return;
+
+		for (SizeType i = startEnd.first; i < startEnd.second; ++i)
+			std::swap(this->common().targetVectors(i),
+			          this->common().targetVectors(offset + i));
 	}
 
 	void advanceCounterAndComputeStage(const VectorSizeType& block)
@@ -412,13 +528,19 @@ private:
 			this->common().setAllStagesTo(WFT_NOADVANCE);
 			timesWithoutAdvancement = 0;
 			this->common().setTime(0);
-			PsimagLite::OstringStream msg;
 			SizeType n1 = mettsStruct_.timeSteps();
-			RealType x = norm(this->common().targetVectors()[n1]);
-			msg<<"Changing direction, setting collapsed with norm="<<x;
-			progress_.printline(msg,std::cout);
-			for (SizeType i=0;i<n1;i++)
-				this->common().targetVectors(i) = this->common().targetVectors()[n1];
+			for (SizeType c = 0; c < chains_.size(); ++c) {
+				SizeType offset = c*weight_.size();
+				PsimagLite::OstringStream msg;
+				RealType x = norm(this->common().targetVectors()[offset+n1]);
+				msg<<"Changing direction, setting collapsed with norm="<<x;
+				if (chains_.size() > 1) msg<<" chain="<<c;
+				progress_.printline(msg,std::cout);
+				for (SizeType i=0;i<n1;i++)
+					this->common().targetVectors(offset+i) =
+					        this->common().targetVectors()[offset+n1];
+			}
+
 			this->common().timeHasAdvanced();
 			printAdvancement(timesWithoutAdvancement);
 			return;
@@ -452,7 +574,8 @@ private:
 			this->common().setAllStagesTo(COLLAPSE);
 			sitesCollapsed_.clear();
 			SizeType n1 = mettsStruct_.timeSteps();
-			this->common().targetVectors(n1).resize(0);
+			for (SizeType c = 0; c < chains_.size(); ++c)
+				this->common().targetVectors(c*weight_.size()+n1).resize(0);
 			timesWithoutAdvancement = 0;
 			printAdvancement(timesWithoutAdvancement);
 			return;
@@ -475,7 +598,7 @@ private:
 		if (this->common().targetVectors()[index].size()==0) return;
 		assert(norm(this->common().targetVectors()[index])>1e-6);
 		VectorSizeType nk;
-		mettsCollapse_.setNk(nk,block);
+		chains_[0]->mettsCollapse.setNk(nk,block);
 
 		if (this->common().allStages(WFT_NOADVANCE) ||
 		    this->common().allStages(WFT_ADVANCE) ||
@@ -486,7 +609,7 @@ private:
 				this->common().timeHasAdvanced();
 			}
 			// don't advance the collapsed vector because we'll recompute
-			if (index==weight_.size()-1) advance=index;
+			if (index % weight_.size() == weight_.size()-1) advance=index;
 			PsimagLite::OstringStream msg;
 			msg<<"I'm calling the WFT now";
 			progress_.printline(msg,std::cout);
@@ -506,7 +629,26 @@ private:
 		}
 	}
 
-	void updateStochastics(const VectorSizeType& block1,
+	// Chain 0 keeps the seed of the input file, so that runs with
+	// MettsChains=1 are unchanged. Other chains get the seed scrambled by a
+	// 32-bit integer hash, because adjacent seeds of the same linear
+	// congruential generator give correlated streams
+	static int long chainSeed(int long seed, SizeType c)
+	{
+		if (c == 0) return seed;
+
+		unsigned int z = static_cast<unsigned int>(seed) + c*0x9e3779b9U;
+		z ^= (z >> 16);
+		z *= 0x7feb352dU;
+		z ^= (z >> 15);
+		z *= 0x846ca68bU;
+		z ^= (z >> 16);
+		// positive and below 2^31 - 1
+		return static_cast<int long>(z % 2147483646U) + 1;
+	}
+
+	void updateStochastics(MettsChain& chain,
+	                       const VectorSizeType& block1,
 	                       const VectorSizeType& block2)
 	{
 		SizeType linSize = model_.geometry().numberOfSites();
@@ -516,7 +658,7 @@ private:
 		                                                        ProgramGlobals::INFINITE,
 		                                                        0,
 		                                                        BasisType::useSu2Symmetry());
-		mettsStochastics_.update(qn,block1,block2,mettsStruct_.rngSeed);
+		chain.mettsStochastics.update(qn,block1,block2);
 	}
 
 	SizeType getPartition() const
@@ -531,16 +673,18 @@ private:
 	}
 
 	// direction here is INFINITE
-	void getNewPures(const VectorSizeType& block1,
+	void getNewPures(MettsChain& chain,
+	                 SizeType offset,
+	                 const VectorSizeType& block1,
 	                 const VectorSizeType& block2)
 	{
 		VectorSizeType alphaFixed(block1.size());
 		for (SizeType i=0;i<alphaFixed.size();i++)
-			alphaFixed[i] = mettsStochastics_.chooseRandomState(block1[i]);
+			alphaFixed[i] = chain.mettsStochastics.chooseRandomState(block1[i]);
 
 		VectorSizeType betaFixed(block2.size());
 		for (SizeType i=0;i<betaFixed.size();i++)
-			betaFixed[i] = mettsStochastics_.chooseRandomState(block2[i]);
+			betaFixed[i] = chain.mettsStochastics.chooseRandomState(block2[i]);
 
 		PsimagLite::OstringStream msg;
 		msg<<"New pures for ";
@@ -555,59 +699,64 @@ private:
 		TargetVectorType newVector1(transformSystem.rows(),0);
 
 		VectorSizeType nk1;
-		mettsCollapse_.setNk(nk1,block1);
-		SizeType alphaFixedVolume = mettsCollapse_.volumeOf(alphaFixed,nk1);
+		chain.mettsCollapse.setNk(nk1,block1);
+		SizeType alphaFixedVolume = chain.mettsCollapse.volumeOf(alphaFixed,nk1);
 
-		getNewPure(newVector1,
-		           pureVectors_.first,
+		getNewPure(chain,
+		           newVector1,
+		           chain.pureVectors.first,
 		           ProgramGlobals::SYSTEM,
 		           alphaFixedVolume,
 		           lrs_.left(),
 		           transformSystem,
 		           block1);
-		pureVectors_.first = newVector1;
+		chain.pureVectors.first = newVector1;
 
 		const BlockDiagonalMatrixType& transformEnviron = wft_.transform(ProgramGlobals::ENVIRON);
 		TargetVectorType newVector2(transformEnviron.rows(),0);
 
 		VectorSizeType nk2;
-		mettsCollapse_.setNk(nk2,block2);
-		SizeType betaFixedVolume = mettsCollapse_.volumeOf(betaFixed,nk2);
-		getNewPure(newVector2,
-		           pureVectors_.second,
+		chain.mettsCollapse.setNk(nk2,block2);
+		SizeType betaFixedVolume = chain.mettsCollapse.volumeOf(betaFixed,nk2);
+		getNewPure(chain,
+		           newVector2,
+		           chain.pureVectors.second,
 		           ProgramGlobals::ENVIRON,
 		           betaFixedVolume,
 		           lrs_.right(),
 		           transformEnviron,block2);
-		pureVectors_.second = newVector2;
-		setFromInfinite(this->common().targetVectors(0),lrs_);
-		assert(norm(this->common().targetVectors()[0])>1e-6);
-
-		systemPrev_.fixed = alphaFixedVolume;
-		systemPrev_.permutationInverse = lrs_.left().permutationInverse();
-		environPrev_.fixed = betaFixedVolume;
-		environPrev_.permutationInverse = lrs_.right().permutationInverse();
+		chain.pureVectors.second = newVector2;
+		setFromInfinite(this->common().targetVectors(offset),chain,lrs_);
+		assert(norm(this->common().targetVectors()[offset])>1e-6);
+
+		chain.systemPrev.fixed = alphaFixedVolume;
+		chain.systemPrev.permutationInverse = lrs_.left().permutationInverse();
+		chain.environPrev.fixed = betaFixedVolume;
+		chain.environPrev.permutationInverse = lrs_.right().permutationInverse();
 	}
 
 	void getFullVector(TargetVectorType& v,
 	                   SizeType m,
+	                   const MettsChain& chain,
 	                   const LeftRightSuperType& lrs) const
 	{
+		const std::pair<TargetVectorType,TargetVectorType>& pureVectors = chain.pureVectors;
 		int offset = lrs.super().partition(m);
 		int total = lrs.super().partition(m+1) - offset;
 
 		PackIndicesType pack(lrs.left().size());
 		v.resize(total);
-		assert(PsimagLite::norm(pureVectors_.first)>1e-6);
-		assert(PsimagLite::norm(pureVectors_.second)>1e-6);
+		assert(PsimagLite::norm(pureVectors.first)>1e-6);
+		assert(PsimagLite::norm(pureVectors.second)>1e-6);
 		for (int i=0;i<total;i++) {
 			SizeType alpha,beta;
 			pack.unpack(alpha,beta,lrs.super().permutation(i+offset));
-			v[i] = pureVectors_.first[alpha] * pureVectors_.second[beta];
+			v[i] = pureVectors.first[alpha] * pureVectors.second[beta];
 		}
 	}
 
-	void getNewPure(TargetVectorType& newVector,
+	void getNewPure(MettsChain& chain,
+	                TargetVectorType& newVector,
 	                TargetVectorType& oldVector,
 	                SizeType direction,
 	                SizeType alphaFixed,
@@ -616,7 +765,7 @@ private:
 	                const VectorSizeType& block)
 	{
 		if (oldVector.size()==0)
-			setInitialPure(oldVector,block);
+			setInitialPure(chain,oldVector,block);
 		TargetVectorType tmpVector;
 		if (transform.rows()==0) {
 			tmpVector = oldVector;
@@ -624,13 +773,13 @@ private:
 		} else {
 			MatrixType transform1;
 			transform.toDense(transform1);
-			delayedTransform(tmpVector,oldVector,direction,transform1,block);
+			delayedTransform(chain,tmpVector,oldVector,direction,transform1,block);
 			assert(PsimagLite::norm(tmpVector)>1e-6);
 		}
 		SizeType ns = tmpVector.size();
 		VectorSizeType nk;
-		mettsCollapse_.setNk(nk,block);
-		SizeType volumeOfNk = mettsCollapse_.volumeOf(nk);
+		chain.mettsCollapse.setNk(nk,block);
+		SizeType volumeOfNk = chain.mettsCollapse.volumeOf(nk);
 		SizeType newSize =  (transform.cols()==0) ? (ns*ns) :
 		                                           transform.cols() * volumeOfNk;
 		newVector.resize(newSize);
@@ -653,7 +802,8 @@ private:
 		assert(PsimagLite::norm(newVector)>1e-6);
 	}
 
-	void delayedTransform(TargetVectorType& newVector,
+	void delayedTransform(const MettsChain& chain,
+	                      TargetVectorType& newVector,
 	                      TargetVectorType& oldVector,
 	                      SizeType direction,
 	                      const MatrixType& transform,
@@ -662,11 +812,13 @@ private:
 		assert(oldVector.size()==transform.rows());
 
 		VectorSizeType nk;
-		mettsCollapse_.setNk(nk,block);
-		SizeType ne = mettsCollapse_.volumeOf(nk);
+		chain.mettsCollapse.setNk(nk,block);
+		SizeType ne = chain.mettsCollapse.volumeOf(nk);
 
+		const MettsPrev& systemPrev = chain.systemPrev;
+		const MettsPrev& environPrev = chain.environPrev;
 		const VectorSizeType& permutationInverse = (direction==SYSTEM)
-		        ? systemPrev_.permutationInverse : environPrev_.permutationInverse;
+		        ? systemPrev.permutationInverse : environPrev.permutationInverse;
 		SizeType nsPrev = permutationInverse.size()/ne;
 
 		newVector.resize(transform.cols());
@@ -675,8 +827,8 @@ private:
 			newVector[gamma] = 0;
 			for (SizeType alpha=0;alpha<nsPrev;alpha++) {
 				SizeType noPermIndex =  (direction==SYSTEM)
-				        ? alpha + systemPrev_.fixed*nsPrev
-				        : environPrev_.fixed + alpha*ne;
+				        ? alpha + systemPrev.fixed*nsPrev
+				        : environPrev.fixed + alpha*ne;
 
 				SizeType gammaPrime = permutationInverse[noPermIndex];
 
@@ -687,7 +839,9 @@ private:
 		}
 	}
 
-	void setInitialPure(TargetVectorType& oldVector,const VectorSizeType& block)
+	void setInitialPure(MettsChain& chain,
+	                    TargetVectorType& oldVector,
+	                    const VectorSizeType& block)
 	{
 		int offset = (block[0]==block.size()) ? -block.size() : block.size();
 		VectorSizeType blockCorrected = block;
@@ -695,11 +849,11 @@ private:
 			blockCorrected[i] += offset;
 
 		VectorSizeType nk;
-		mettsCollapse_.setNk(nk,blockCorrected);
-		SizeType volumeOfNk = mettsCollapse_.volumeOf(nk);
+		chain.mettsCollapse.setNk(nk,blockCorrected);
+		SizeType volumeOfNk = chain.mettsCollapse.volumeOf(nk);
 		VectorSizeType alphaFixed(nk.size());
 		for (SizeType i=0;i<alphaFixed.size();i++)
-			alphaFixed[i] = mettsStochastics_.chooseRandomState(blockCorrected[i]);
+			alphaFixed[i] = chain.mettsStochastics.chooseRandomState(blockCorrected[i]);
 
 		PsimagLite::OstringStream msg;
 		msg<<"New pures for site ";
@@ -708,7 +862,7 @@ private:
 		msg<<" is "<<alphaFixed;
 		progress_.printline(msg,std::cerr);
 
-		SizeType volumeOfAlphaFixed = mettsCollapse_.volumeOf(alphaFixed,nk);
+		SizeType volumeOfAlphaFixed = chain.mettsCollapse.volumeOf(alphaFixed,nk);
 
 		oldVector.resize(volumeOfNk);
 		assert(volumeOfAlphaFixed<oldVector.size());
@@ -719,6 +873,7 @@ private:
 	}
 
 	void setFromInfinite(VectorWithOffsetType& phi,
+	                     const MettsChain& chain,
 	                     const LeftRightSuperType& lrs) const
 	{
 		SizeType mode = model_.targetQuantum().other.size();
@@ -726,7 +881,7 @@ private:
 		for (SizeType ii=0;ii<phi.sectors();ii++) {
 			SizeType i0 = phi.sector(ii);
 			TargetVectorType v;
-			getFullVector(v,i0,lrs);
+			getFullVector(v,i0,chain,lrs);
 			RealType tmpNorm = PsimagLite::norm(v);
 			if (fabs(tmpNorm-1.0)<1e-6) {
 				SizeType j = lrs.super().qn(lrs.super().partition(i0));
@@ -831,6 +986,66 @@ private:
 		progress_.printline(msg2,std::cout);
 	}
 
+	// METTS estimate of the energy: average over chains of the
+	// Hamiltonian average of each chain's state at beta/2
+	void printChainAverages() const
+	{
+		SizeType nchains = chains_.size();
+		if (nchains < 2 || this->common().allStages(DISABLED)) return;
+
+		SizeType n1 = mettsStruct_.timeSteps();
+		RealType sum = 0;
+		RealType sum2 = 0;
+		SizeType count = 0;
+		for (SizeType c = 0; c < nchains; ++c) {
+			const VectorWithOffsetType& phi =
+			        this->common().targetVectors()[c*weight_.size() + n1 - 1];
+			if (phi.size() == 0) continue;
+			RealType e = hamiltonianAverage(phi);
+			sum += e;
+			sum2 += e*e;
+			++count;
+		}
+
+		if (count == 0) return;
+
+		RealType average = sum/count;
+		RealType variance = (count > 1) ? (sum2/count - average*average)/(count - 1) : 0;
+		if (variance < 0) variance = 0;
+
+		PsimagLite::OstringStream msg;
+		msg<<"MettsChains="<<count<<" time="<<this->common().currentTime();
+		msg<<" <H>="<<average<<" error="<<sqrt(variance);
+		progress_.printline(msg,std::cout);
+	}
+
+	RealType hamiltonianAverage(const VectorWithOffsetType& phi) const
+	{
+		ComplexOrRealType numerator = 0;
+		ComplexOrRealType den = 0;
+		for (SizeType ii=0;ii<phi.sectors();ii++) {
+			SizeType i0 = phi.sector(ii);
+			SizeType p = this->lrs().super().findPartitionNumber(phi.offset(i0));
+			SizeType threadId = 0;
+			typename ModelType::ModelHelperType modelHelper(p,
+			                                                this->lrs(),
+			                                                this->common().currentTime(),
+			                                                threadId);
+			typename LanczosSolverType::LanczosMatrixType lanczosHelper(&this->model(),
+			                                                            &modelHelper);
+
+			SizeType total = phi.effectiveSize(i0);
+			TargetVectorType phi2(total);
+			phi.extract(phi2,i0);
+			TargetVectorType x(total);
+			lanczosHelper.matrixVectorProduct(x,phi2);
+			numerator += phi2*x;
+			den += phi2*phi2;
+		}
+
+		return (PsimagLite::norm(den)<1e-10) ? 0 : PsimagLite::real(numerator/den);
+	}
+
 	void printEnergies() const
 	{
 		for (SizeType i=0;i<this->common().targetVectors().size();i++)
@@ -883,12 +1098,8 @@ private:
 	VectorRealType betas_;
 	VectorRealType weight_;
 	RealType gsWeight_;
-	MettsStochasticsType mettsStochastics_;
-	MettsCollapseType mettsCollapse_;
 	SizeType prevDirection_;
-	MettsPrev systemPrev_;
-	MettsPrev environPrev_;
-	std::pair<TargetVectorType,TargetVectorType> pureVectors_;
+	VectorMettsChainType chains_;
 	VectorSizeType sitesCollapsed_;
 };     //class TargetingMetts
 
@@ -84,6 +84,7 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "DensityMatrixSu2.h"
 #include "Sort.h"
 #include "Concurrency.h"
+#include "PhaseProfiler.h"
 
 namespace Dmrg {
 
@@ -175,6 +176,8 @@ public:
 
 		truncateBasisSystem(sBasis,lrs_.right());
 		truncateBasisEnviron(eBasis,lrs_.left());
+
+		reflectionOperator_.changeBasis(leftCache_.transform, rightCache_.transform);
 	}
 
 private:
@@ -206,11 +209,23 @@ private:
 
 		bool debug = false;
 		bool useSvd = (parameters_.options.find("useSvd") != PsimagLite::String::npos);
-		ParamsDensityMatrixType p(useSvd, direction, verbose_, debug);
+		bool truncatedSvd = (parameters_.options.find("truncatedSvd") !=
+		        PsimagLite::String::npos);
+		ParamsDensityMatrixType p(useSvd,
+		                          direction,
+		                          verbose_,
+		                          debug,
+		                          keptStates,
+		                          truncatedSvd,
+		                          parameters_.densityMatrixPerturbation);
 		TruncationCache& cache = (direction == ProgramGlobals::EXPAND_SYSTEM) ?
 		            leftCache_ : rightCache_;
 		DensityMatrixBaseType* dmS = 0;
 
+		PhaseProfiler::Scope densityMatrixScope("densityMatrix");
+		if (p.perturbation > 0 && (p.useSvd || BasisType::useSu2Symmetry()))
+			err("DensityMatrixPerturbation not supported with useSvd or SU(2)\n");
+
 		if (BasisType::useSu2Symmetry()) {
 			if (p.useSvd) {
 				err("useSvd not supported while SU(2) is in use\n");
@@ -227,7 +242,11 @@ private:
 
 		*/
 
+		densityMatrixScope.stop();
+
+		PhaseProfiler::Scope diagScope("densityMatrixDiag");
 		dmS->diag(cache.eigs,'V');
+		diagScope.stop();
 
 		updateKeptStates(keptStates,cache.eigs);
 
@@ -239,8 +258,10 @@ private:
 			cache.transform.setTo(1.0);
 		}
 
+		PhaseProfiler::Scope changeBasisScope("changeBasis");
 		rSprime = pBasis;
 		rSprime.changeBasis(cache.removedIndices,cache.eigs,keptStates,parameters_);
+		changeBasisScope.stop();
 
 		PsimagLite::OstringStream msg2;
 		msg2<<"done with entanglement";
@@ -265,21 +286,25 @@ private:
 
 		PsimagLite::OstringStream msg0;
 		msg0<<"Truncating transform...";
+		PhaseProfiler::Scope truncateScope("truncateBasis");
 		cache.transform.truncate(cache.removedIndices);
 		progress_.printline(msg0,std::cout);
 		rSprime.truncateBasis(cache.transform,
 		                      cache.eigs,
 		                      cache.removedIndices,
 		                      startEnd);
+		truncateScope.stop();
 		LeftRightSuperType lrs(rSprime,(BasisWithOperatorsType&) eBasis,
 		                       (BasisType&)lrs_.super());
 		bool twoSiteDmrg = waveFunctionTransformation_.options().twoSiteDmrg;
 		bool wftInPatches = (waveFunctionTransformation_.options().accel ==
 		                     WaveFunctionTransfType::WftOptionsType::ACCEL_PATCHES);
 		const LeftRightSuperType& lrsForWft = (twoSiteDmrg || wftInPatches) ? lrs_ : lrs;
+		PhaseProfiler::Scope wftScope("wftPush");
 		waveFunctionTransformation_.push(cache.transform,
 		                                 ProgramGlobals::EXPAND_SYSTEM,
 		                                 lrsForWft);
+		wftScope.stop();
 
 		msg<<"new size of basis="<<rSprime.size();
 		msg<<" transform is "<<cache.transform.rows()<<" x "<<cache.transform.cols();
@@ -305,19 +330,23 @@ private:
 		cache.transform.truncate(cache.removedIndices);
 		progress_.printline(msg0,std::cout);
 
+		PhaseProfiler::Scope truncateScope("truncateBasis");
 		rEprime.truncateBasis(cache.transform,
 		                      cache.eigs,
 		                      cache.removedIndices,
 		                      startEnd);
+		truncateScope.stop();
 		LeftRightSuperType lrs((BasisWithOperatorsType&) sBasis,
 		                       rEprime,(BasisType&)lrs_.super());
 		bool twoSiteDmrg = waveFunctionTransformation_.options().twoSiteDmrg;
 		bool wftInPatches = (waveFunctionTransformation_.options().accel ==
 		                     WaveFunctionTransfType::WftOptionsType::ACCEL_PATCHES);
 		const LeftRightSuperType& lrsForWft = (twoSiteDmrg || wftInPatches) ? lrs_ : lrs;
+		PhaseProfiler::Scope wftScope("wftPush");
 		waveFunctionTransformation_.push(cache.transform,
 		                                 ProgramGlobals::EXPAND_ENVIRON,
 		                                 lrsForWft);
+		wftScope.stop();
 		msg<<"new size of basis="<<rEprime.size();
 		msg<<" transform is "<<cache.transform.rows()<<" x "<<cache.transform.cols();
 		msg<<" with "<<cache.transform.blocks()<<" blocks";
@@ -88,7 +88,7 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "DmrgWaveStruct.h"
 #include "IoSelector.h"
 #include "Random48.h"
-#include "BaseStack.h"
+#include "WftStack.h"
 
 namespace Dmrg {
 template<typename LeftRightSuperType,typename VectorWithOffsetType_>
@@ -117,7 +117,7 @@ public:
 	typedef WaveFunctionTransfSu2<DmrgWaveStructType,VectorWithOffsetType>
 	WaveFunctionTransfSu2Type;
 	typedef typename WaveFunctionTransfBaseType::WftOptions WftOptionsType;
-	typedef BaseStack<BlockDiagonalMatrixType> WftStackType;
+	typedef WftStack<BlockDiagonalMatrixType> WftStackType;
 
 	template<typename SomeParametersType>
 	WaveFunctionTransfFactory(SomeParametersType& params)
@@ -144,9 +144,6 @@ public:
 		        params.options.find("restart")!=PsimagLite::String::npos);
 
 		if (b) {
-			if (wsStack_.inDisk())
-				err("The options restart and wftStacksInDisk cannot be combined yet\n");
-
 			if (params.options.find("noloadwft")!=PsimagLite::String::npos)
 				noLoad_=true;
 			else
@@ -359,11 +356,19 @@ public:
 
 	bool isEnabled() const { return isEnabled_; }
 
+	SizeType memoryUsage() const
+	{
+		return wsStack_.memoryUsage() + weStack_.memoryUsage();
+	}
+
 	const WftOptionsType options() const { return wftOptions_; }
 
 	void appendFileList(VectorStringType& files, PsimagLite::String rootName) const
 	{
 		files.push_back(utils::pathPrepend(WFT_STRING,rootName));
+		if (!wsStack_.inDisk()) return;
+		files.push_back(stackFilename(ProgramGlobals::SYSTEM, rootName));
+		files.push_back(stackFilename(ProgramGlobals::ENVIRON, rootName));
 	}
 
 	void save(PsimagLite::String fileOut) const
@@ -381,12 +386,20 @@ public:
 		io.printline("dmrgWaveStruct");
 
 		dmrgWaveStruct_.save(io);
-		wsStack_.save(io, "wsStack\n");
-		weStack_.save(io, "weStack\n");
+		wsStack_.save(io, "wsStack\n", stackFilename(ProgramGlobals::SYSTEM, fileOut));
+		weStack_.save(io, "weStack\n", stackFilename(ProgramGlobals::ENVIRON, fileOut));
 	}
 
 private:
 
+	// Only used with wftStacksInDisk
+	PsimagLite::String stackFilename(SizeType what, PsimagLite::String rootName) const
+	{
+		PsimagLite::String prefix = (what == ProgramGlobals::SYSTEM) ?
+		            ProgramGlobals::SYSTEM_STACK_STRING : ProgramGlobals::ENVIRON_STACK_STRING;
+		return utils::pathPrepend(WFT_STRING + prefix, rootName);
+	}
+
 	void load()
 	{
 		if (!isEnabled_)
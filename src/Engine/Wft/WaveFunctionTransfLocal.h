@@ -85,12 +85,12 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "VectorWithOffset.h" // so that PsimagLite::norm() becomes visible here
 #include "WaveFunctionTransfBase.h"
 #include "MatrixOrIdentity.h"
-#include "ParallelWftOne.h"
 #include "Parallelizer.h"
 #include "MatrixVectorKron/KronMatrix.h"
 #include "WftAccelBlocks.h"
 #include "WftAccelPatches.h"
 #include "WftSparseTwoSite.h"
+#include "WftSectorBlocks.h"
 
 namespace Dmrg {
 
@@ -115,13 +115,11 @@ public:
 	typedef typename BasisType::FactorsType FactorsType;
 	typedef typename DmrgWaveStructType::LeftRightSuperType LeftRightSuperType;
 	typedef MatrixOrIdentity<SparseMatrixType> MatrixOrIdentityType;
-	typedef ParallelWftOne<VectorWithOffsetType,
-	DmrgWaveStructType,
-	LeftRightSuperType> ParallelWftType;
 	typedef PsimagLite::Matrix<SparseElementType> MatrixType;
 	typedef WftAccelBlocks<BaseType> WftAccelBlocksType;
 	typedef WftAccelPatches<BaseType> WftAccelPatchesType;
 	typedef WftSparseTwoSite<BaseType, MatrixOrIdentityType> WftSparseTwoSiteType;
+	typedef WftSectorBlocks<BaseType> WftSectorBlocksType;
 
 	WaveFunctionTransfLocal(const DmrgWaveStructType& dmrgWaveStruct,
 	                        const WftOptions& wftOptions)
@@ -129,6 +127,7 @@ public:
 	      wftOptions_(wftOptions),
 	      wftAccelBlocks_(dmrgWaveStruct, wftOptions),
 	      wftAccelPatches_(dmrgWaveStruct, wftOptions),
+	      wftSectorBlocks_(dmrgWaveStruct, wftOptions),
 	      progress_("WaveFunctionTransfLocal")
 	{
 		PsimagLite::OstringStream msg;
@@ -180,36 +179,22 @@ private:
 
 		typename ProgramGlobals::DirectionEnum dir1 = ProgramGlobals::EXPAND_ENVIRON;
 
-		for (SizeType ii=0;ii<psiDest.sectors();ii++)
-			transformVectorParallel(psiDest,psiSrc,lrs,ii,nk,dir1);
+		transformVectorOneSite(psiDest,psiSrc,lrs,nk,dir1);
 	}
 
-	void transformVectorParallel(VectorWithOffsetType& psiDest,
-	                             const VectorWithOffsetType& psiSrc,
-	                             const LeftRightSuperType& lrs,
-	                             SizeType iNew,
-	                             const VectorSizeType& nk,
-	                             typename ProgramGlobals::DirectionEnum dir) const
-	{		
-		if (wftOptions_.accel == WftOptions::ACCEL_PATCHES) {
+	void transformVectorOneSite(VectorWithOffsetType& psiDest,
+	                            const VectorWithOffsetType& psiSrc,
+	                            const LeftRightSuperType& lrs,
+	                            const VectorSizeType& nk,
+	                            typename ProgramGlobals::DirectionEnum dir) const
+	{
+		if (wftOptions_.accel != WftOptions::ACCEL_PATCHES)
+			return wftSectorBlocks_(psiDest, psiSrc, lrs, nk, dir);
+
+		for (SizeType iNew = 0; iNew < psiDest.sectors(); ++iNew) {
 			SizeType iOld = findIold(psiSrc, psiDest.qn(iNew));
-			return wftAccelPatches_(psiDest, iNew, psiSrc, iOld, lrs, nk, dir);
+			wftAccelPatches_(psiDest, iNew, psiSrc, iOld, lrs, nk, dir);
 		}
-
-		SizeType i0 = psiDest.sector(iNew);
-		typedef PsimagLite::Parallelizer<ParallelWftType> ParallelizerType;
-		ParallelizerType threadedWft(PsimagLite::Concurrency::npthreads,
-		                             PsimagLite::MPI::COMM_WORLD);
-
-		ParallelWftType helperWft(psiDest,
-		                          psiSrc,
-		                          lrs,
-		                          i0,
-		                          nk,
-		                          dmrgWaveStruct_,
-		                          dir);
-
-		threadedWft.loopCreate(helperWft);
 	}
 
 	void transformVector1FromInfinite(VectorWithOffsetType& psiDest,
@@ -217,6 +202,9 @@ private:
 	                                  const LeftRightSuperType& lrs,
 	                                  const VectorSizeType& nk) const
 	{
+		if (wftSectorBlocks_.twoSiteApplies(nk, ProgramGlobals::EXPAND_ENVIRON))
+			return wftSectorBlocks_(psiDest, psiSrc, lrs, nk, ProgramGlobals::EXPAND_ENVIRON);
+
 		for (SizeType ii=0;ii<psiSrc.sectors();ii++) {
 			SizeType iOld = psiSrc.sector(ii);
 			SizeType qn = psiSrc.qn(ii);
@@ -274,8 +262,7 @@ private:
 			return transformVector2FromInfinite(psiDest,psiSrc,lrs,nk);
 
 		typename ProgramGlobals::DirectionEnum dir2 = ProgramGlobals::EXPAND_SYSTEM;
-		for (SizeType ii=0;ii<psiDest.sectors();ii++)
-			transformVectorParallel(psiDest,psiSrc,lrs,ii,nk,dir2);
+		transformVectorOneSite(psiDest,psiSrc,lrs,nk,dir2);
 	}
 
 	void transformVector2FromInfinite(VectorWithOffsetType& psiDest,
@@ -285,6 +272,9 @@ private:
 	{
 		typedef PsimagLite::Parallelizer<WftSparseTwoSiteType> ParallelizerType;
 
+		if (wftSectorBlocks_.twoSiteApplies(nk, ProgramGlobals::EXPAND_SYSTEM))
+			return wftSectorBlocks_(psiDest, psiSrc, lrs, nk, ProgramGlobals::EXPAND_SYSTEM);
+
 		PsimagLite::OstringStream msg;
 		msg<<" Destination sectors "<<psiDest.sectors();
 		msg<<" Source sectors "<<psiSrc.sectors();
@@ -464,6 +454,7 @@ private:
 	const WftOptions& wftOptions_;
 	WftAccelBlocksType wftAccelBlocks_;
 	WftAccelPatchesType wftAccelPatches_;
+	WftSectorBlocksType wftSectorBlocks_;
 	PsimagLite::ProgressIndicator progress_;
 }; // class WaveFunctionTransfLocal
 } // namespace Dmrg
@@ -0,0 +1,515 @@
+#ifndef WFTSECTORBLOCKS_H
+#define WFTSECTORBLOCKS_H
+#include <map>
+#include "Matrix.h"
+#include "BLAS.h"
+#include "ProgramGlobals.h"
+#include "Concurrency.h"
+#include "Parallelizer.h"
+
+namespace Dmrg {
+
+// WFT with dense products of the symmetry blocks of ws and we
+//
+// The source vector is cut into patches, one for each state kp of the moving
+// site(s) and each pair of symmetry blocks of ws and we that it touches.
+// Each patch is transformed with two GEMMs, and the patches of all sectors
+// are transformed in parallel. This is the default for two-site and one-site
+// DMRG when no WFT accelerator has been chosen.
+template<typename WaveFunctionTransfBaseType>
+class WftSectorBlocks {
+
+	typedef typename WaveFunctionTransfBaseType::DmrgWaveStructType DmrgWaveStructType;
+	typedef typename WaveFunctionTransfBaseType::WftOptions WftOptionsType;
+	typedef typename WaveFunctionTransfBaseType::VectorWithOffsetType VectorWithOffsetType;
+	typedef typename WaveFunctionTransfBaseType::VectorSizeType VectorSizeType;
+	typedef typename WaveFunctionTransfBaseType::PackIndicesType PackIndicesType;
+	typedef typename DmrgWaveStructType::LeftRightSuperType LeftRightSuperType;
+	typedef typename DmrgWaveStructType::BlockDiagonalMatrixType BlockDiagonalMatrixType;
+	typedef typename BlockDiagonalMatrixType::BuildingBlockType MatrixType;
+	typedef typename MatrixType::value_type ComplexOrRealType;
+	typedef typename PsimagLite::Vector<MatrixType>::Type VectorMatrixType;
+	typedef std::map<SizeType, SizeType> MapSizeType;
+
+	// Maps indices of the old (source) and new (destination) superblocks
+	// into (kp, row, col), where row and col index the blocks of ws and we
+	class IndexMap {
+
+	public:
+
+		IndexMap(const DmrgWaveStructType& dmrgWaveStruct,
+		         const LeftRightSuperType& lrs,
+		         const VectorSizeType& nk,
+		         typename ProgramGlobals::DirectionEnum dir,
+		         bool twoSiteDmrg)
+		    : old_(dmrgWaveStruct.lrs),
+		      lrs_(lrs),
+		      volumeOfNk_(DmrgWaveStructType::volumeOf(nk)),
+		      environ_(dir == ProgramGlobals::EXPAND_ENVIRON),
+		      twoSiteDmrg_(twoSiteDmrg),
+		      packSrcSuper_((environ_ && !twoSiteDmrg) ? dmrgWaveStruct.ws.cols() :
+		                                                   old_.left().permutationInverse().size()),
+		      nip_(old_.left().permutationInverse().size()/volumeOfNk_),
+		      packSrcLeft_(nip_),
+		      packSrcRight_(volumeOfNk_),
+		      packDestSuper_((environ_) ? lrs.super().permutationInverse().size()/
+		                                  lrs.right().permutationInverse().size() :
+		                                  lrs.left().permutationInverse().size()),
+		      packDestLeft_(lrs.left().permutationInverse().size()/volumeOfNk_),
+		      packDestRight_(volumeOfNk_)
+		{}
+
+		void src(SizeType& kp, SizeType& row, SizeType& col, SizeType x) const
+		{
+			kp = 0;
+			if (!twoSiteDmrg_)
+				return packSrcSuper_.unpack(row, col, old_.super().permutation(x));
+
+			SizeType alpha = 0;
+			SizeType beta = 0;
+			packSrcSuper_.unpack(alpha, beta, old_.super().permutation(x));
+			if (environ_) {
+				col = beta;
+				packSrcLeft_.unpack(row, kp, old_.left().permutation(alpha));
+			} else {
+				row = alpha;
+				packSrcRight_.unpack(kp, col, old_.right().permutation(beta));
+			}
+		}
+
+		void dest(SizeType& kp, SizeType& row, SizeType& col, SizeType x) const
+		{
+			SizeType alpha = 0;
+			SizeType beta = 0;
+			packDestSuper_.unpack(alpha, beta, lrs_.super().permutation(x));
+			if (environ_) {
+				packDestRight_.unpack(kp, col, lrs_.right().permutation(beta));
+				row = alpha;
+				if (twoSiteDmrg_) return;
+				row = old_.left().permutationInverse(alpha + kp*nip_);
+			} else {
+				packDestLeft_.unpack(row, kp, lrs_.left().permutation(alpha));
+				col = beta;
+				if (twoSiteDmrg_) return;
+				col = old_.right().permutationInverse(kp + beta*volumeOfNk_);
+			}
+
+			kp = 0;
+		}
+
+		static SizeType patchKey(SizeType kp,
+		                         SizeType bL,
+		                         SizeType bR,
+		                         SizeType nbL,
+		                         SizeType nbR)
+		{
+			return (kp*nbL + bL)*nbR + bR;
+		}
+
+	private:
+
+		const LeftRightSuperType& old_;
+		const LeftRightSuperType& lrs_;
+		SizeType volumeOfNk_;
+		bool environ_;
+		bool twoSiteDmrg_;
+		PackIndicesType packSrcSuper_;
+		SizeType nip_;
+		PackIndicesType packSrcLeft_;
+		PackIndicesType packSrcRight_;
+		PackIndicesType packDestSuper_;
+		PackIndicesType packDestLeft_;
+		PackIndicesType packDestRight_;
+	};
+
+	class ParallelPatches {
+
+	public:
+
+		ParallelPatches(VectorMatrixType& result,
+		                const VectorMatrixType& psi,
+		                const VectorSizeType& keys,
+		                const BlockDiagonalMatrixType& ws,
+		                const BlockDiagonalMatrixType& we,
+		                bool environ,
+		                SizeType threads)
+		    : result_(result),
+		      psi_(psi),
+		      keys_(keys),
+		      ws_(ws),
+		      we_(we),
+		      environ_(environ),
+		      storage_(threads)
+		{}
+
+		SizeType tasks() const { return psi_.size(); }
+
+		void doTask(SizeType p, SizeType threadNum)
+		{
+			SizeType nbL = ws_.blocks();
+			SizeType nbR = we_.blocks();
+			const MatrixType& mLeft = ws_((keys_[p]/nbR) % nbL);
+			const MatrixType& mRight = we_(keys_[p] % nbR);
+			const MatrixType& m = psi_[p];
+
+			result_[p].clear();
+			if (isEmpty(mLeft) || isEmpty(mRight) || isEmpty(m)) return;
+
+			if (environ_)
+				return doTaskEnviron(result_[p], mLeft, m, mRight, threadNum);
+
+			doTaskSystem(result_[p], mLeft, m, mRight);
+		}
+
+	private:
+
+		// result = mLeft * m * conj(mRight)
+		void doTaskEnviron(MatrixType& result,
+		                   const MatrixType& mLeft,
+		                   const MatrixType& m,
+		                   const MatrixType& mRight,
+		                   SizeType threadNum)
+		{
+			assert(m.rows() == mLeft.cols() && m.cols() == mRight.rows());
+			MatrixType tmp(m.rows(), mRight.cols());
+			const MatrixType& mRightModif = getConj(mRight, threadNum);
+
+			psimag::BLAS::GEMM('N',
+			                   'N',
+			                   m.rows(),
+			                   mRight.cols(),
+			                   m.cols(),
+			                   1.0,
+			                   &(m(0,0)),
+			                   m.rows(),
+			                   &(mRightModif(0,0)),
+			                   mRight.rows(),
+			                   0.0,
+			                   &(tmp(0,0)),
+			                   m.rows());
+
+			result.resize(mLeft.rows(), tmp.cols());
+			psimag::BLAS::GEMM('N',
+			                   'N',
+			                   mLeft.rows(),
+			                   tmp.cols(),
+			                   mLeft.cols(),
+			                   1.0,
+			                   &(mLeft(0,0)),
+			                   mLeft.rows(),
+			                   &(tmp(0,0)),
+			                   tmp.rows(),
+			                   0.0,
+			                   &(result(0,0)),
+			                   mLeft.rows());
+		}
+
+		// result = mLeft^\dagger * m * mRight^T
+		void doTaskSystem(MatrixType& result,
+		                  const MatrixType& mLeft,
+		                  const MatrixType& m,
+		                  const MatrixType& mRight)
+		{
+			assert(m.rows() == mLeft.rows() && m.cols() == mRight.cols());
+			MatrixType tmp(m.rows(), mRight.rows());
+
+			psimag::BLAS::GEMM('N',
+			                   'T',
+			                   m.rows(),
+			                   mRight.rows(),
+			                   m.cols(),
+			                   1.0,
+			                   &(m(0,0)),
+			                   m.rows(),
+			                   &(mRight(0,0)),
+			                   mRight.rows(),
+			                   0.0,
+			                   &(tmp(0,0)),
+			                   m.rows());
+
+			result.resize(mLeft.cols(), tmp.cols());
+			psimag::BLAS::GEMM('C',
+			                   'N',
+			                   mLeft.cols(),
+			                   tmp.cols(),
+			                   mLeft.rows(),
+			                   1.0,
+			                   &(mLeft(0,0)),
+			                   mLeft.rows(),
+			                   &(tmp(0,0)),
+			                   tmp.rows(),
+			                   0.0,
+			                   &(result(0,0)),
+			                   mLeft.cols());
+		}
+
+		const MatrixType& getConj(const PsimagLite::Matrix<double>& m, SizeType)
+		{
+			return m;
+		}
+
+		const MatrixType& getConj(const PsimagLite::Matrix<std::complex<double> >& m,
+		                          SizeType threadNum)
+		{
+			storage_[threadNum].clear();
+			SizeType rows = m.rows();
+			SizeType cols = m.cols();
+			storage_[threadNum].resize(rows, cols);
+			for (SizeType j = 0; j < cols; ++j)
+				for (SizeType i = 0; i < rows; ++i)
+					storage_[threadNum](i, j) = PsimagLite::conj(m(i, j));
+
+			return storage_[threadNum];
+		}
+
+		static bool isEmpty(const MatrixType& m)
+		{
+			return (m.rows() == 0 || m.cols() == 0);
+		}
+
+		VectorMatrixType& result_;
+		const VectorMatrixType& psi_;
+		const VectorSizeType& keys_;
+		const BlockDiagonalMatrixType& ws_;
+		const BlockDiagonalMatrixType& we_;
+		bool environ_;
+		VectorMatrixType storage_;
+	};
+
+	class ParallelCopyOut {
+
+	public:
+
+		ParallelCopyOut(VectorWithOffsetType& dest,
+		                SizeType i0,
+		                const IndexMap& indexMap,
+		                const MapSizeType& patchIndex,
+		                const VectorMatrixType& result,
+		                const VectorSizeType& blockOfRow,
+		                const VectorSizeType& blockOfCol,
+		                const VectorSizeType& offsetsRows,
+		                const VectorSizeType& offsetsCols,
+		                SizeType nbL,
+		                SizeType nbR,
+		                bool assign)
+		    : dest_(dest),
+		      i0_(i0),
+		      offset_(dest.offset(i0)),
+		      indexMap_(indexMap),
+		      patchIndex_(patchIndex),
+		      result_(result),
+		      blockOfRow_(blockOfRow),
+		      blockOfCol_(blockOfCol),
+		      offsetsRows_(offsetsRows),
+		      offsetsCols_(offsetsCols),
+		      nbL_(nbL),
+		      nbR_(nbR),
+		      assign_(assign)
+		{}
+
+		SizeType tasks() const { return dest_.effectiveSize(i0_); }
+
+		void doTask(SizeType x, SizeType)
+		{
+			SizeType kp = 0;
+			SizeType row = 0;
+			SizeType col = 0;
+			indexMap_.dest(kp, row, col, x + offset_);
+			assert(row < blockOfRow_.size() && col < blockOfCol_.size());
+			SizeType bL = blockOfRow_[row];
+			SizeType bR = blockOfCol_[col];
+
+			ComplexOrRealType value = 0.0;
+			SizeType key = IndexMap::patchKey(kp, bL, bR, nbL_, nbR_);
+			typename MapSizeType::const_iterator it = patchIndex_.find(key);
+			if (it != patchIndex_.end() && result_[it->second].rows() > 0)
+				value = result_[it->second](row - offsetsRows_[bL], col - offsetsCols_[bR]);
+
+			if (assign_)
+				dest_.fastAccess(i0_, x) = value;
+			else
+				dest_.fastAccess(i0_, x) += value;
+		}
+
+	private:
+
+		VectorWithOffsetType& dest_;
+		SizeType i0_;
+		SizeType offset_;
+		const IndexMap& indexMap_;
+		const MapSizeType& patchIndex_;
+		const VectorMatrixType& result_;
+		const VectorSizeType& blockOfRow_;
+		const VectorSizeType& blockOfCol_;
+		const VectorSizeType& offsetsRows_;
+		const VectorSizeType& offsetsCols_;
+		SizeType nbL_;
+		SizeType nbR_;
+		bool assign_;
+	};
+
+public:
+
+	WftSectorBlocks(const DmrgWaveStructType& dmrgWaveStruct,
+	                const WftOptionsType& wftOptions)
+	    : dmrgWaveStruct_(dmrgWaveStruct), wftOptions_(wftOptions)
+	{}
+
+	// For two-site DMRG, ws (we) is the identity when expanding the environ (system)
+	// if the system (environ) was a single site; those are left to WftSparseTwoSite
+	bool twoSiteApplies(const VectorSizeType& nk,
+	                    typename ProgramGlobals::DirectionEnum dir) const
+	{
+		if (!wftOptions_.twoSiteDmrg || wftOptions_.accel != WftOptionsType::ACCEL_NONE)
+			return false;
+
+		SizeType volumeOfNk = DmrgWaveStructType::volumeOf(nk);
+		if (dir == ProgramGlobals::EXPAND_ENVIRON)
+			return (dmrgWaveStruct_.lrs.left().permutationInverse().size()/volumeOfNk >
+			        volumeOfNk);
+
+		return (dmrgWaveStruct_.lrs.right().size()/volumeOfNk > volumeOfNk);
+	}
+
+	// Two-site DMRG adds to psiDest, one-site DMRG overwrites psiDest
+	void operator()(VectorWithOffsetType& psiDest,
+	                const VectorWithOffsetType& psiSrc,
+	                const LeftRightSuperType& lrs,
+	                const VectorSizeType& nk,
+	                typename ProgramGlobals::DirectionEnum dir) const
+	{
+		const BlockDiagonalMatrixType& ws = dmrgWaveStruct_.ws;
+		const BlockDiagonalMatrixType& we = dmrgWaveStruct_.we;
+		bool environ = (dir == ProgramGlobals::EXPAND_ENVIRON);
+		bool twoSiteDmrg = wftOptions_.twoSiteDmrg;
+		IndexMap indexMap(dmrgWaveStruct_, lrs, nk, dir, twoSiteDmrg);
+		SizeType nbL = ws.blocks();
+		SizeType nbR = we.blocks();
+
+		VectorSizeType wsBlockOfRow;
+		VectorSizeType wsBlockOfCol;
+		VectorSizeType weBlockOfRow;
+		VectorSizeType weBlockOfCol;
+		blockOf(wsBlockOfRow, ws.offsetsRows());
+		blockOf(wsBlockOfCol, ws.offsetsCols());
+		blockOf(weBlockOfRow, we.offsetsRows());
+		blockOf(weBlockOfCol, we.offsetsCols());
+
+		// source is contracted with the cols of ws and the rows of we when
+		// expanding the environ, and the other way around when expanding the system
+		const VectorSizeType& srcBlockOfRow = (environ) ? wsBlockOfCol : wsBlockOfRow;
+		const VectorSizeType& srcBlockOfCol = (environ) ? weBlockOfRow : weBlockOfCol;
+		const VectorSizeType& srcOffsetsRows = (environ) ? ws.offsetsCols() : ws.offsetsRows();
+		const VectorSizeType& srcOffsetsCols = (environ) ? we.offsetsRows() : we.offsetsCols();
+
+		MapSizeType patchIndex;
+		VectorSizeType keys;
+		SizeType sectors = psiSrc.sectors();
+		for (SizeType ii = 0; ii < sectors; ++ii) {
+			SizeType iOld = psiSrc.sector(ii);
+			SizeType offset = psiSrc.offset(iOld);
+			SizeType total = psiSrc.effectiveSize(iOld);
+			for (SizeType y = 0; y < total; ++y) {
+				SizeType kp = 0;
+				SizeType row = 0;
+				SizeType col = 0;
+				indexMap.src(kp, row, col, y + offset);
+				SizeType key = IndexMap::patchKey(kp,
+				                                  srcBlockOfRow[row],
+				                                  srcBlockOfCol[col],
+				                                  nbL,
+				                                  nbR);
+				if (patchIndex.find(key) != patchIndex.end()) continue;
+				patchIndex[key] = keys.size();
+				keys.push_back(key);
+			}
+		}
+
+		SizeType npatches = keys.size();
+		VectorMatrixType psi(npatches);
+		for (SizeType p = 0; p < npatches; ++p) {
+			SizeType bL = (keys[p]/nbR) % nbL;
+			SizeType bR = keys[p] % nbR;
+			psi[p].resize(srcOffsetsRows[bL + 1] - srcOffsetsRows[bL],
+			              srcOffsetsCols[bR + 1] - srcOffsetsCols[bR]);
+			psi[p].setTo(0.0);
+		}
+
+		for (SizeType ii = 0; ii < sectors; ++ii) {
+			SizeType iOld = psiSrc.sector(ii);
+			SizeType offset = psiSrc.offset(iOld);
+			SizeType total = psiSrc.effectiveSize(iOld);
+			for (SizeType y = 0; y < total; ++y) {
+				SizeType kp = 0;
+				SizeType row = 0;
+				SizeType col = 0;
+				indexMap.src(kp, row, col, y + offset);
+				SizeType bL = srcBlockOfRow[row];
+				SizeType bR = srcBlockOfCol[col];
+				SizeType p = patchIndex[IndexMap::patchKey(kp, bL, bR, nbL, nbR)];
+				psi[p](row - srcOffsetsRows[bL], col - srcOffsetsCols[bR]) +=
+				        psiSrc.fastAccess(iOld, y);
+			}
+		}
+
+		VectorMatrixType result(npatches);
+		if (npatches > 0) {
+			SizeType threads = std::min(npatches, PsimagLite::Concurrency::npthreads);
+			typedef PsimagLite::Parallelizer<ParallelPatches> ParallelizerType;
+			ParallelizerType threadedPatches(threads, PsimagLite::MPI::COMM_WORLD);
+
+			ParallelPatches helperPatches(result, psi, keys, ws, we, environ, threads);
+
+			threadedPatches.loopCreate(helperPatches);
+		}
+
+		const VectorSizeType& destBlockOfRow = (environ) ? wsBlockOfRow : wsBlockOfCol;
+		const VectorSizeType& destBlockOfCol = (environ) ? weBlockOfCol : weBlockOfRow;
+		const VectorSizeType& destOffsetsRows = (environ) ? ws.offsetsRows() : ws.offsetsCols();
+		const VectorSizeType& destOffsetsCols = (environ) ? we.offsetsCols() : we.offsetsRows();
+
+		typedef PsimagLite::Parallelizer<ParallelCopyOut> ParallelizerCopyType;
+		for (SizeType ii = 0; ii < psiDest.sectors(); ++ii) {
+			SizeType i0 = psiDest.sector(ii);
+			SizeType total = psiDest.effectiveSize(i0);
+			if (total == 0) continue;
+
+			SizeType threads = std::min(total, PsimagLite::Concurrency::npthreads);
+			ParallelizerCopyType threadedCopy(threads, PsimagLite::MPI::COMM_WORLD);
+
+			ParallelCopyOut helperCopy(psiDest,
+			                           i0,
+			                           indexMap,
+			                           patchIndex,
+			                           result,
+			                           destBlockOfRow,
+			                           destBlockOfCol,
+			                           destOffsetsRows,
+			                           destOffsetsCols,
+			                           nbL,
+			                           nbR,
+			                           !twoSiteDmrg);
+
+			threadedCopy.loopCreate(helperCopy);
+		}
+	}
+
+private:
+
+	static void blockOf(VectorSizeType& v, const VectorSizeType& offsets)
+	{
+		SizeType n = offsets.size();
+		v.clear();
+		if (n == 0) return;
+
+		v.resize(offsets[n - 1], 0);
+		for (SizeType b = 0; b + 1 < n; ++b)
+			for (SizeType i = offsets[b]; i < offsets[b + 1]; ++i)
+				v[i] = b;
+	}
+
+	const DmrgWaveStructType& dmrgWaveStruct_;
+	const WftOptionsType& wftOptions_;
+};
+}
+#endif // WFTSECTORBLOCKS_H
@@ -0,0 +1,479 @@
+#ifndef WFTSTACK_H
+#define WFTSTACK_H
+#include <errno.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <unistd.h>
+#include "Stack.h"
+#include "IoSelector.h"
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#endif
+
+namespace Dmrg {
+
+// A stack of WFT transformations that keeps its entries in memory or in disk
+//
+// In disk, entries are appended to a scratch file and found by their offset.
+// The entry last pushed is written by a background thread and is served from
+// memory until the next push; while popping, the entry below the top is read
+// ahead by a background thread, because that is the one that the sweep
+// needs next. Background threads are only used with USE_PTHREADS.
+// Popping an entry truncates the scratch file at its offset, because entries
+// above it in the stack were written after it and have been popped already.
+// Entries are written with enough digits to be read back exactly.
+//
+// A disk stack is saved into a file of its own, with an index at the end,
+// and can be reopened from that file on restart without reading it into memory.
+template<typename DataType>
+class WftStack {
+
+	typedef PsimagLite::Vector<PsimagLite::String>::Type VectorStringType;
+	typedef PsimagLite::Vector<SizeType>::Type VectorSizeType;
+	typedef typename PsimagLite::IoSelector::In IoInType;
+	typedef typename PsimagLite::IoSelector::Out IoOutType;
+	typedef long int LongType;
+	typedef PsimagLite::Vector<LongType>::Type VectorLongType;
+	typedef std::pair<SizeType, LongType> PairSizeLongType;
+	typedef PsimagLite::Vector<PairSizeLongType>::Type VectorPairSizeLongType;
+	typedef typename DataType::RealType RealType;
+
+	enum {SCRATCH_FILE, BASE_FILE};
+
+	static const SizeType INDEX_WIDTH = 20;
+
+public:
+
+	WftStack(bool disk)
+	    : m_(!disk)
+	{
+		initDisk();
+	}
+
+	WftStack(const WftStack& other)
+	    : m_(other.m_)
+	{
+		if (m_) {
+			stack_ = other.stack_;
+			bytes_ = other.bytes_;
+			return;
+		}
+
+		initDisk();
+		other.joinWriter();
+		other.joinReader();
+		copyFile(other.scratchFile_, scratchFile_);
+		baseFile_ = other.baseFile_;
+		locations_ = other.locations_;
+		indices_ = other.indices_;
+	}
+
+	~WftStack()
+	{
+		if (m_) return;
+
+		joinWriter();
+		joinReader();
+		deleteFiles();
+		delete writeBuffer_;
+		delete topBuffer_;
+		delete aheadBuffer_;
+		writeBuffer_ = topBuffer_ = aheadBuffer_ = 0;
+	}
+
+	void push(const DataType& d)
+	{
+		if (m_) {
+			bytes_.push_back(d.memoryUsage());
+			return stack_.push(d);
+		}
+
+		joinWriter();
+		joinReader();
+		SizeType id = locations_.size();
+		locations_.push_back(PairSizeLongType(SCRATCH_FILE, 0));
+		indices_.push_back(id);
+		*writeBuffer_ = d;
+		writeBytes_ = d.memoryUsage();
+		writeId_ = id;
+		hasWrite_ = true;
+		startWriter();
+	}
+
+	void pop()
+	{
+		if (m_) {
+			bytes_.pop_back();
+			return stack_.pop();
+		}
+
+		if (indices_.size() == 0)
+			err("WftStack::pop(): stack is empty\n");
+
+		SizeType id = indices_[indices_.size() - 1];
+		indices_.pop_back();
+		if (locations_[id].first != SCRATCH_FILE) return;
+
+		joinWriter();
+		if (truncate(scratchFile_.c_str(), locations_[id].second) != 0)
+			err("WftStack::pop(): truncate of " + scratchFile_ + " failed: " +
+			    PsimagLite::String(strerror(errno)) + "\n");
+	}
+
+	const DataType& top() const
+	{
+		if (m_) return stack_.top();
+
+		if (indices_.size() == 0)
+			err("WftStack::top(): stack is empty\n");
+
+		SizeType id = indices_[indices_.size() - 1];
+		if (hasWrite_ && writeId_ == id) return *writeBuffer_;
+		if (hasTop_ && topId_ == id) return *topBuffer_;
+
+		joinReader();
+		if (hasAhead_ && aheadId_ == id) {
+			std::swap(topBuffer_, aheadBuffer_);
+			hasAhead_ = false;
+		} else {
+			joinWriter();
+			readEntry(*topBuffer_, id);
+		}
+
+		topBytes_ = topBuffer_->memoryUsage();
+		topId_ = id;
+		hasTop_ = true;
+		startReadAhead();
+		return *topBuffer_;
+	}
+
+	SizeType size() const
+	{
+		return (m_) ? stack_.size() : indices_.size();
+	}
+
+	bool inDisk() const { return !m_; }
+
+	// Bytes held in memory: all entries or, in disk, the buffers;
+	// these are counted when handed off, as the background threads use them
+	SizeType memoryUsage() const
+	{
+		if (!m_) return writeBytes_ + 2*topBytes_;
+
+		SizeType total = 0;
+		for (SizeType i = 0; i < bytes_.size(); ++i)
+			total += bytes_[i];
+		return total;
+	}
+
+	// diskFile is only used for stacks in disk
+	void save(IoOutType& io,
+	          PsimagLite::String label,
+	          PsimagLite::String diskFile) const
+	{
+		if (m_) {
+			io.print(label, stack_);
+			return;
+		}
+
+		if (diskFile == baseFile_)
+			err("WftStack::save(): cannot overwrite " + diskFile + " that we read from\n");
+
+		joinWriter();
+		joinReader();
+
+		// write to a temporary and rename, so that diskFile is either
+		// the previous or the new version of the stack, and never half of one
+		PsimagLite::String tmpFile = diskFile + ".tmp";
+		std::ofstream fout(tmpFile.c_str(), std::ios::binary);
+		if (!fout)
+			err("WftStack::save(): cannot write to " + tmpFile + "\n");
+		setPrecision(fout);
+
+		SizeType n = indices_.size();
+		VectorLongType offsets(n);
+		DataType d;
+		for (SizeType i = 0; i < n; ++i) {
+			offsets[i] = fout.tellp();
+			fout<<entry(d, indices_[i]);
+		}
+
+		LongType indexPos = fout.tellp();
+		fout<<"#WFTSTACKINDEX "<<n<<"\n";
+		for (SizeType i = 0; i < n; ++i)
+			fout<<offsets[i]<<"\n";
+		fout<<std::setw(INDEX_WIDTH)<<indexPos<<"\n";
+		fout.close();
+		if (!fout)
+			err("WftStack::save(): writing to " + tmpFile + " failed\n");
+
+		if (rename(tmpFile.c_str(), diskFile.c_str()) != 0)
+			err("WftStack::save(): rename to " + diskFile + " failed: " +
+			    PsimagLite::String(strerror(errno)) + "\n");
+
+		io.printline(labelName(label) + "InDisk=" + diskFile);
+	}
+
+	void load(IoInType& io, PsimagLite::String label)
+	{
+		if (m_) {
+			io.read(stack_, label);
+			cacheBytes();
+			return;
+		}
+
+		PsimagLite::String diskFile;
+		try {
+			io.readline(diskFile, labelName(label) + "InDisk=");
+		} catch (std::exception&) {
+			err("WftStack::load(): " + labelName(label) + " was not saved in disk;" +
+			    " restart without wftStacksInDisk\n");
+		}
+
+		std::ifstream fin(diskFile.c_str(), std::ios::binary);
+		if (!fin)
+			err("WftStack::load(): cannot read from " + diskFile + "\n");
+
+		fin.seekg(-static_cast<LongType>(INDEX_WIDTH + 1), std::ios::end);
+		LongType indexPos = 0;
+		fin>>indexPos;
+		fin.seekg(indexPos);
+		PsimagLite::String header;
+		SizeType n = 0;
+		fin>>header;
+		fin>>n;
+		if (!fin || header != "#WFTSTACKINDEX")
+			err("WftStack::load(): " + diskFile + " has no index\n");
+
+		VectorLongType offsets(n);
+		for (SizeType i = 0; i < n; ++i)
+			fin>>offsets[i];
+
+		if (!fin)
+			err("WftStack::load(): index of " + diskFile + " is truncated\n");
+
+		locations_.clear();
+		indices_.clear();
+		reopenBase(diskFile, offsets);
+	}
+
+private:
+
+	void cacheBytes()
+	{
+		typename PsimagLite::Stack<DataType>::Type tmp = stack_;
+		bytes_.resize(tmp.size());
+		for (SizeType i = bytes_.size(); i > 0; --i) {
+			bytes_[i - 1] = tmp.top().memoryUsage();
+			tmp.pop();
+		}
+	}
+
+	void initDisk()
+	{
+		writeBuffer_ = topBuffer_ = aheadBuffer_ = 0;
+		hasWrite_ = hasTop_ = hasAhead_ = false;
+		writeId_ = topId_ = aheadId_ = 0;
+		writeBytes_ = topBytes_ = 0;
+		writerRunning_ = readerRunning_ = false;
+		writeFailed_ = readFailed_ = false;
+		if (m_) return;
+
+		scratchFile_ = tmpFname();
+		files_.push_back(scratchFile_);
+		writeBuffer_ = new DataType();
+		topBuffer_ = new DataType();
+		aheadBuffer_ = new DataType();
+	}
+
+	void reopenBase(PsimagLite::String diskFile, const VectorLongType& offsets)
+	{
+		baseFile_ = diskFile;
+		hasWrite_ = hasTop_ = hasAhead_ = false;
+		indices_.clear();
+		for (SizeType i = 0; i < offsets.size(); ++i) {
+			indices_.push_back(locations_.size());
+			locations_.push_back(PairSizeLongType(BASE_FILE, offsets[i]));
+		}
+	}
+
+	const DataType& entry(DataType& d, SizeType id) const
+	{
+		if (hasWrite_ && writeId_ == id) return *writeBuffer_;
+		if (hasTop_ && topId_ == id) return *topBuffer_;
+		readEntry(d, id);
+		return d;
+	}
+
+	void readEntry(DataType& d, SizeType id) const
+	{
+		assert(id < locations_.size());
+		const PairSizeLongType& loc = locations_[id];
+		const PsimagLite::String& file = (loc.first == BASE_FILE) ? baseFile_ : scratchFile_;
+		std::ifstream fin(file.c_str(), std::ios::binary);
+		fin.seekg(loc.second);
+		d = DataType();
+		fin>>d;
+		if (!fin)
+			err("WftStack: cannot read entry " + ttos(id) + " from " + file + "\n");
+	}
+
+	void writeEntry()
+	{
+		std::ofstream fout(scratchFile_.c_str(), std::ios::app | std::ios::binary);
+		fout.seekp(0, std::ios::end);
+		setPrecision(fout);
+		locations_[writeId_].second = fout.tellp();
+		fout<<(*writeBuffer_);
+		fout.close();
+		writeFailed_ = !fout;
+	}
+
+	void readAhead() const
+	{
+		try {
+			readEntry(*aheadBuffer_, aheadId_);
+		} catch (std::exception&) {
+			readFailed_ = true;
+		}
+	}
+
+	void startWriter()
+	{
+#ifdef USE_PTHREADS
+		writerRunning_ = (pthread_create(&writer_, 0, writeThread, this) == 0);
+		if (writerRunning_) return;
+#endif
+		writeEntry();
+		checkWrite();
+	}
+
+	void startReadAhead() const
+	{
+#ifdef USE_PTHREADS
+		SizeType n = indices_.size();
+		if (n < 2) return;
+		aheadId_ = indices_[n - 2];
+		if (hasWrite_ && writeId_ == aheadId_) return;
+		readFailed_ = false;
+		hasAhead_ = readerRunning_ =
+		        (pthread_create(&reader_, 0, readThread, const_cast<WftStack*>(this)) == 0);
+#endif
+	}
+
+	void joinWriter() const
+	{
+#ifdef USE_PTHREADS
+		if (!writerRunning_) return;
+		pthread_join(writer_, 0);
+		writerRunning_ = false;
+		checkWrite();
+#endif
+	}
+
+	void joinReader() const
+	{
+#ifdef USE_PTHREADS
+		if (!readerRunning_) return;
+		pthread_join(reader_, 0);
+		readerRunning_ = false;
+		if (readFailed_) hasAhead_ = false;
+#endif
+	}
+
+	void checkWrite() const
+	{
+		if (!writeFailed_) return;
+		err("WftStack: cannot write entry " + ttos(writeId_) + " to " + scratchFile_ + "\n");
+	}
+
+#ifdef USE_PTHREADS
+	static void* writeThread(void* arg)
+	{
+		static_cast<WftStack*>(arg)->writeEntry();
+		return 0;
+	}
+
+	static void* readThread(void* arg)
+	{
+		static_cast<WftStack*>(arg)->readAhead();
+		return 0;
+	}
+#endif
+
+	static void setPrecision(std::ostream& os)
+	{
+		os<<std::setprecision(std::numeric_limits<RealType>::digits10 + 3);
+	}
+
+	static PsimagLite::String labelName(PsimagLite::String label)
+	{
+		SizeType last = label.length();
+		if (last > 0 && label[last - 1] == '\n') label.erase(last - 1, 1);
+		return label;
+	}
+
+	static void copyFile(PsimagLite::String src, PsimagLite::String dest)
+	{
+		std::ifstream fin(src.c_str(), std::ios::binary);
+		std::ofstream fout(dest.c_str(), std::ios::binary);
+		fout<<fin.rdbuf();
+	}
+
+	static PsimagLite::String tmpFname()
+	{
+		char templ[] = "wftStackXXXXXX";
+		int x = mkstemp(templ);
+		if (x < 0) {
+			char *msg = strerror(errno);
+			err("mkstemp failed: " + PsimagLite::String(msg) + "\n");
+		}
+		close(x);
+		return PsimagLite::String(templ);
+	}
+
+	void deleteFiles()
+	{
+		for (SizeType i = 0; i < files_.size(); ++i) {
+			int x = unlink(files_[i].c_str());
+			if (x == 0) continue;
+			std::cerr<<"unlink "<<files_[i]<<" failed\n";
+			std::cerr<<strerror(errno)<<"\n";
+		}
+	}
+
+	WftStack& operator=(const WftStack&);
+
+	bool m_;
+	typename PsimagLite::Stack<DataType>::Type stack_;
+	VectorSizeType bytes_; // of each entry in memory, bottom first
+	PsimagLite::String scratchFile_;
+	PsimagLite::String baseFile_;
+	VectorPairSizeLongType locations_;
+	VectorSizeType indices_;
+	DataType* writeBuffer_;
+	mutable DataType* topBuffer_;
+	mutable DataType* aheadBuffer_;
+	bool hasWrite_;
+	mutable bool hasTop_;
+	mutable bool hasAhead_;
+	SizeType writeId_;
+	mutable SizeType topId_;
+	mutable SizeType aheadId_;
+	SizeType writeBytes_;
+	mutable SizeType topBytes_;
+	mutable bool writerRunning_;
+	mutable bool readerRunning_;
+	bool writeFailed_;
+	mutable bool readFailed_;
+#ifdef USE_PTHREADS
+	mutable pthread_t writer_;
+	mutable pthread_t reader_;
+#endif
+	VectorStringType files_;
+};
+}
+#endif // WFTSTACK_H
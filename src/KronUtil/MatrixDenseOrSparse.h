@@ -64,6 +64,15 @@ public:
 		return (isDense_) ? SparseMatrixType(denseMatrix_) : sparse();
 	}
 
+	// Heap bytes held, both the sparse and, if dense, the dense copy
+	SizeType memoryUsage() const
+	{
+		SizeType total = sparseMatrix_.nonZeros()*(sizeof(ComplexOrRealType) + sizeof(int));
+		total += (sparseMatrix_.rows() + 1)*sizeof(int);
+		total += denseMatrix_.n_row()*denseMatrix_.n_col()*sizeof(ComplexOrRealType);
+		return total;
+	}
+
 private:
 
 	bool isDense_;
@@ -58,10 +58,12 @@ my %observeDriver0 = (name => 'ObserveDriver0', aux => 1);
 my %observeDriver1 = (name => 'ObserveDriver1', aux => 1);
 my %observeDriver2 = (name => 'ObserveDriver2', aux => 1);
 
+my %davidsonTest = (name => 'davidsonTest', dotos => 'davidsonTest.o');
+
 my @drivers = (\%provenanceDriver,\%su2RelatedDriver,
 \%progGlobalsDriver,\%restartDriver,\%finiteLoopDriver,\%utilsDriver,
 \%observeDriver,\%toolboxDriver,
-\%observeDriver0,\%observeDriver1,\%observeDriver2);
+\%observeDriver0,\%observeDriver1,\%observeDriver2,\%davidsonTest);
 
 $dotos = "dmrg.o Provenance.o RestartStruct.o FiniteLoop.o Utils.o ";
 $dotos .= " ProgramGlobals.o Su2Related.o";
@@ -0,0 +1,148 @@
+// Tests DavidsonPreconditioned on a random symmetric matrix
+//
+// The search space is restarted every MAX_SUBSPACE vectors, so with
+// steps=32 and zero tolerance the loop ends right after a restart,
+// without diagonalizing the collapsed space again, and the state returned
+// must come from the collapsed space. Each case checks that the state is
+// normalized and that its Rayleigh quotient is the energy returned; a
+// converged case also checks the energy against full diagonalization.
+#include <iostream>
+#include <cstdio>
+#include "Matrix.h"
+#include "Random48.h"
+#include "ProgressIndicator.h"
+#include "DavidsonPreconditioned.h"
+
+typedef double RealType;
+typedef PsimagLite::Vector<RealType>::Type VectorType;
+typedef PsimagLite::Matrix<RealType> MatrixType;
+
+struct SolverParams {
+
+	SolverParams(SizeType steps1, RealType tolerance1)
+	    : steps(steps1), tolerance(tolerance1)
+	{}
+
+	SizeType steps;
+	RealType tolerance;
+};
+
+class DenseMatrixVector {
+
+public:
+
+	DenseMatrixVector(const MatrixType& h, bool hasDiagonal)
+	    : h_(h), hasDiagonal_(hasDiagonal)
+	{}
+
+	SizeType rows() const { return h_.rows(); }
+
+	void matrixVectorProduct(VectorType& x, const VectorType& y) const
+	{
+		for (SizeType i = 0; i < rows(); ++i)
+			for (SizeType j = 0; j < rows(); ++j)
+				x[i] += h_(i, j)*y[j];
+	}
+
+	bool diagonal(VectorType& d) const
+	{
+		if (!hasDiagonal_) return false;
+		d.resize(rows());
+		for (SizeType i = 0; i < rows(); ++i)
+			d[i] = h_(i, i);
+		return true;
+	}
+
+private:
+
+	const MatrixType& h_;
+	bool hasDiagonal_;
+};
+
+typedef Dmrg::DavidsonPreconditioned<SolverParams,
+DenseMatrixVector,
+VectorType> DavidsonType;
+
+// returns the number of errors
+int check(const MatrixType& h,
+          const VectorType& exact,
+          SizeType steps,
+          RealType tolerance,
+          bool hasDiagonal,
+          SizeType excited)
+{
+	DenseMatrixVector mat(h, hasDiagonal);
+	SolverParams params(steps, tolerance);
+	DavidsonType davidson(mat, params);
+	RealType energy = 0;
+	VectorType z;
+	davidson.computeExcitedState(energy, z, excited);
+
+	SizeType n = h.rows();
+	VectorType hz(n, 0.0);
+	mat.matrixVectorProduct(hz, z);
+	RealType norm2 = 0;
+	RealType quotient = 0;
+	for (SizeType i = 0; i < n; ++i) {
+		norm2 += z[i]*z[i];
+		quotient += z[i]*hz[i];
+	}
+
+	int nerrors = 0;
+	if (fabs(norm2 - 1.0) > 1e-10) {
+		std::cout<<"steps="<<steps<<" excited="<<excited<<" diagonal="<<hasDiagonal;
+		std::cout<<": norm of state "<<sqrt(norm2)<<"\n";
+		++nerrors;
+	}
+
+	if (fabs(quotient - energy) > 1e-10*(1.0 + fabs(energy))) {
+		std::cout<<"steps="<<steps<<" excited="<<excited<<" diagonal="<<hasDiagonal;
+		std::cout<<": energy "<<energy<<" but <z|H|z>="<<quotient<<"\n";
+		++nerrors;
+	}
+
+	if (tolerance > 0 && fabs(energy - exact[excited]) > 1e-8) {
+		std::cout<<"steps="<<steps<<" excited="<<excited<<" diagonal="<<hasDiagonal;
+		std::cout<<": energy "<<energy<<" but exact "<<exact[excited]<<"\n";
+		++nerrors;
+	}
+
+	return nerrors;
+}
+
+int main()
+{
+	SizeType n = 100;
+	MatrixType h(n, n);
+	PsimagLite::Random48<RealType> rng(1234);
+	for (SizeType i = 0; i < n; ++i) {
+		h(i, i) = 0.1*i + rng();
+		for (SizeType j = 0; j < i; ++j) {
+			h(i, j) = 0.05*(rng() - 0.5);
+			h(j, i) = h(i, j);
+		}
+	}
+
+	MatrixType tmp = h;
+	VectorType exact(n);
+	diag(tmp, exact, 'V');
+
+	int nerrors = 0;
+	for (SizeType d = 0; d < 2; ++d) {
+		for (SizeType excited = 0; excited < 2; ++excited) {
+			// ends right after the first restart
+			nerrors += check(h, exact, 32, 0.0, (d == 1), excited);
+			// ends between restarts
+			nerrors += check(h, exact, 45, 0.0, (d == 1), excited);
+			nerrors += check(h, exact, 1000, 1e-20, (d == 1), excited);
+		}
+	}
+
+	if (nerrors == 0) {
+		printf("pass all tests\n");
+		return 0;
+	}
+
+	printf("%d errors\n", nerrors);
+	return 1;
+}